@@ -13,6 +13,28 @@ using MeshConfiguration = json;
 struct TextureConfiguration {
     std::string name;
     std::string path;
+    bool mipmaps  = true;
+    bool compress = true;
+    bool cache    = true;
+};
+
+struct TextureStreamingConfiguration {
+    bool enable                    = false;
+    uint32_t budget_mb             = 2048;
+    uint32_t placeholder_size      = 64;
+    uint32_t max_uploads_per_frame = 2;
+};
+
+struct LodConfiguration {
+    bool enable       = true;
+    float pixel_error = 1.0f;
+    float hysteresis  = 0.25f;
+};
+
+struct LightCullingConfiguration {
+    uint32_t tile_size = 32;
+    uint32_t slices    = 16;
+    float cutoff       = 0.05f;
 };
 
 struct MaterialConfiguration {
@@ -59,6 +81,9 @@ struct VoxelizerConfiguration {
 struct RenderGraphConfiguration {
     std::string name;
     std::string shader_directory;
+    bool shader_hot_reload = false;
+    bool occlusion_culling = true;
+    bool depth_prepass     = false;
     json extra_args;
 };
 
@@ -70,6 +95,17 @@ struct FieldConfiguration {
     std::array<int, 3> dimension;
     std::array<float, 3> scatter;
     std::array<float, 3> absorption;
+    // a .npy, or a .vti read by the field's name, with the voxels of a static field, x fastest. Without
+    // it the field is written by the physics engine
+    std::string path;
+    // storage of the field image: r32_sfloat, r16_sfloat, r16_unorm, r8_unorm or bc4 (static fields
+    // only, falls back to r8_unorm). Values are stored as (value - bias) / scale
+    std::string format = "r32_sfloat";
+    float scale        = 1.0f;
+    float bias         = 0.0f;
+    // 8 or 16 stores only the bricks of this many voxels along an edge that hold a value, in an
+    // atlas sized by them (static fields only). 0 keeps the field dense
+    uint32_t brick_size = 0;
 };
 
 struct FireConfiguration {
@@ -83,6 +119,10 @@ struct FireConfiguration {
 
 struct FieldsConfiguration {
     float step;
+    // voxels along an edge of the macrocells the raymarching skips empty space with
+    uint32_t macrocell_size = 8;
+    // texels along each axis of the fields' light transmittance volume, per light
+    uint32_t transmittance_resolution = 32;
     json fire_configuration;
     std::vector<FieldConfiguration> arr;
 };
@@ -144,10 +184,32 @@ struct OFMConfiguration {
 
 using Configuration = json;
 
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
     TextureConfiguration,
     name,
-    path);
+    path,
+    mipmaps,
+    compress,
+    cache);
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+    TextureStreamingConfiguration,
+    enable,
+    budget_mb,
+    placeholder_size,
+    max_uploads_per_frame);
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+    LodConfiguration,
+    enable,
+    pixel_error,
+    hysteresis);
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+    LightCullingConfiguration,
+    tile_size,
+    slices,
+    cutoff);
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     MaterialConfiguration,
@@ -179,6 +241,9 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
     RenderGraphConfiguration,
     name,
     shader_directory,
+    shader_hot_reload,
+    occlusion_culling,
+    depth_prepass,
     extra_args);
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
@@ -196,7 +261,7 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     posOrDir,
     intensity);
 
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
     FieldConfiguration,
     name,
     data_type,
@@ -204,7 +269,12 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     size,
     dimension,
     scatter,
-    absorption);
+    absorption,
+    path,
+    format,
+    scale,
+    bias,
+    brick_size);
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     FireConfiguration,
@@ -218,6 +288,8 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
     FieldsConfiguration,
     step,
+    macrocell_size,
+    transmittance_resolution,
     fire_configuration,
     arr);
 
@@ -1,5 +1,18 @@
 #include "file.h"
+#include <cstring>
 #include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN64
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 std::vector<char> readFile(const std::filesystem::path& path)
 {
@@ -16,3 +29,74 @@ std::vector<char> readFile(const std::filesystem::path& path)
     file.close();
     return buffer;
 }
+
+uint64_t hashFile(const std::filesystem::path& path)
+{
+    MappedFile file(path);
+
+    // FNV-1a over 8-byte words, fast enough to run on every launch for multi-GB meshes
+    constexpr uint64_t prime = 0x100000001b3ull;
+    uint64_t hash            = 0xcbf29ce484222325ull ^ file.size();
+    size_t words             = file.size() / sizeof(uint64_t);
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t word;
+        std::memcpy(&word, file.data() + i * sizeof(uint64_t), sizeof(uint64_t));
+        hash = (hash ^ word) * prime;
+    }
+    for (size_t i = words * sizeof(uint64_t); i < file.size(); ++i) {
+        hash = (hash ^ static_cast<uint8_t>(file.data()[i])) * prime;
+    }
+    return hash;
+}
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    // the view stays valid after its file handles are closed
+#ifdef _WIN64
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("failed to open " + path.string());
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    length = static_cast<size_t>(file_size.QuadPart);
+    if (length == 0) {
+        CloseHandle(file);
+        return;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+        throw std::runtime_error("failed to map " + path.string());
+    ptr = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    if (ptr == nullptr)
+        throw std::runtime_error("failed to map " + path.string());
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("failed to open " + path.string());
+    struct stat st;
+    fstat(fd, &st);
+    length = static_cast<size_t>(st.st_size);
+    if (length == 0) {
+        close(fd);
+        return;
+    }
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        throw std::runtime_error("failed to map " + path.string());
+    ptr = static_cast<const char*>(mapped);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    if (ptr == nullptr)
+        return;
+#ifdef _WIN64
+    UnmapViewOfFile(ptr);
+#else
+    munmap(const_cast<char*>(ptr), length);
+#endif
+}
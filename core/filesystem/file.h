@@ -1,6 +1,27 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <vector>
 
 std::vector<char> readFile(const std::filesystem::path& path);
+
+// 64-bit content hash of a whole file, for cache invalidation
+uint64_t hashFile(const std::filesystem::path& path);
+
+// Read-only memory mapping of a whole file, unmapped on destruction
+class MappedFile {
+    const char* ptr = nullptr;
+    size_t length   = 0;
+
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return ptr; }
+    size_t size() const { return length; }
+};
@@ -0,0 +1,422 @@
+#include "pipeline_registry.h"
+#include "core/tool/logger.h"
+#include "core/vulkan/vulkan_context.h"
+#include "core/vulkan/vulkan_util.h"
+#include <algorithm>
+#include <chrono>
+#include <type_traits>
+
+namespace Vk {
+namespace {
+    // The keys are built field by field, never from whole structs holding pointers or padding
+    template <typename T>
+    void append(std::string& key, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>);
+        key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // Handles are pointers on 64-bit and uint64_t on 32-bit platforms
+    template <typename H>
+    void appendHandle(std::string& key, H handle)
+    {
+        append(key, (uint64_t)handle);
+    }
+
+    template <typename T>
+    void appendArray(std::string& key, const T* values, uint32_t count)
+    {
+        append(key, count);
+        for (uint32_t i = 0; i < count; ++i)
+            append(key, values[i]);
+    }
+
+    void appendStencil(std::string& key, const VkStencilOpState& state)
+    {
+        append(key, state.failOp);
+        append(key, state.passOp);
+        append(key, state.depthFailOp);
+        append(key, state.compareOp);
+        append(key, state.compareMask);
+        append(key, state.writeMask);
+        append(key, state.reference);
+    }
+}
+
+void PipelineRegistry::init(Context* ctx)
+{
+    this->ctx = ctx;
+}
+
+VkShaderModule PipelineRegistry::createShaderModule(const std::vector<char>& code)
+{
+    VkShaderModule module = Vk::createShaderModule(*ctx, code);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [it, inserted] = codeIds.try_emplace(std::string(code.begin(), code.end()), codeIds.size());
+    moduleCodeIds[module] = it->second;
+    return module;
+}
+
+void PipelineRegistry::destroyShaderModule(VkShaderModule module)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        moduleCodeIds.erase(module);
+    }
+    vkDestroyShaderModule(ctx->device, module, nullptr);
+}
+
+std::string PipelineRegistry::layoutKey(const VkPipelineLayoutCreateInfo& info) const
+{
+    std::string key;
+    append(key, info.flags);
+    append(key, info.setLayoutCount);
+    for (uint32_t i = 0; i < info.setLayoutCount; ++i)
+        appendHandle(key, info.pSetLayouts[i]);
+    append(key, info.pushConstantRangeCount);
+    for (uint32_t i = 0; i < info.pushConstantRangeCount; ++i) {
+        append(key, info.pPushConstantRanges[i].stageFlags);
+        append(key, info.pPushConstantRanges[i].offset);
+        append(key, info.pPushConstantRanges[i].size);
+    }
+    return key;
+}
+
+VkPipelineLayout PipelineRegistry::getLayout(const std::vector<VkDescriptorSetLayout>& set_layouts, const std::vector<VkPushConstantRange>& push_constants)
+{
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+    pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount         = static_cast<uint32_t>(set_layouts.size());
+    pipelineLayoutInfo.pSetLayouts            = set_layouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(push_constants.size());
+    pipelineLayoutInfo.pPushConstantRanges    = push_constants.data();
+    std::string key                           = layoutKey(pipelineLayoutInfo);
+
+    // Layout creation is cheap, keep it under the lock
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = layouts.find(key);
+    if (it != layouts.end()) {
+        it->second.refs++;
+        return it->second.layout;
+    }
+
+    VkPipelineLayout layout;
+    if (vkCreatePipelineLayout(ctx->device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+    layouts[key]       = { layout, 1 };
+    layoutKeys[layout] = key;
+    return layout;
+}
+
+void PipelineRegistry::releaseLayout(VkPipelineLayout layout)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = layoutKeys.find(layout);
+    if (key == layoutKeys.end()) {
+        throw std::runtime_error("releasing a pipeline layout not owned by the registry!");
+    }
+    auto it = layouts.find(key->second);
+    if (--it->second.refs == 0) {
+        vkDestroyPipelineLayout(ctx->device, layout, nullptr);
+        layouts.erase(it);
+        layoutKeys.erase(key);
+    }
+}
+
+bool PipelineRegistry::stageKey(const VkPipelineShaderStageCreateInfo& stage, std::string& key) const
+{
+    auto code = moduleCodeIds.find(stage.module);
+    if (stage.pNext != nullptr || code == moduleCodeIds.end())
+        return false;
+    append(key, stage.flags);
+    append(key, stage.stage);
+    append(key, code->second);
+    key.append(stage.pName).push_back('\0');
+    const VkSpecializationInfo* spec = stage.pSpecializationInfo;
+    append(key, spec ? spec->mapEntryCount : 0u);
+    if (spec) {
+        for (uint32_t j = 0; j < spec->mapEntryCount; ++j) {
+            append(key, spec->pMapEntries[j].constantID);
+            append(key, spec->pMapEntries[j].offset);
+            append(key, spec->pMapEntries[j].size);
+        }
+        append(key, spec->dataSize);
+        key.append(static_cast<const char*>(spec->pData), spec->dataSize);
+    }
+    return true;
+}
+
+bool PipelineRegistry::pipelineKey(const VkGraphicsPipelineCreateInfo& info, std::string& key) const
+{
+    // Extension chains and derivatives can't be keyed generically, those pipelines are never shared
+    if (info.pNext != nullptr || info.basePipelineHandle != VK_NULL_HANDLE)
+        return false;
+
+    append(key, info.flags);
+    appendHandle(key, info.layout);
+    appendHandle(key, info.renderPass);
+    append(key, info.subpass);
+
+    append(key, info.stageCount);
+    for (uint32_t i = 0; i < info.stageCount; ++i) {
+        if (!stageKey(info.pStages[i], key))
+            return false;
+    }
+
+    bool dynamicViewport = false, dynamicScissor = false;
+    append(key, info.pDynamicState != nullptr);
+    if (const auto* dynamic = info.pDynamicState) {
+        if (dynamic->pNext != nullptr)
+            return false;
+        std::vector<VkDynamicState> states(dynamic->pDynamicStates, dynamic->pDynamicStates + dynamic->dynamicStateCount);
+        std::sort(states.begin(), states.end());
+        appendArray(key, states.data(), static_cast<uint32_t>(states.size()));
+        dynamicViewport = std::find(states.begin(), states.end(), VK_DYNAMIC_STATE_VIEWPORT) != states.end();
+        dynamicScissor  = std::find(states.begin(), states.end(), VK_DYNAMIC_STATE_SCISSOR) != states.end();
+    }
+
+    append(key, info.pVertexInputState != nullptr);
+    if (const auto* vertexInput = info.pVertexInputState) {
+        if (vertexInput->pNext != nullptr)
+            return false;
+        append(key, vertexInput->vertexBindingDescriptionCount);
+        for (uint32_t i = 0; i < vertexInput->vertexBindingDescriptionCount; ++i) {
+            const auto& binding = vertexInput->pVertexBindingDescriptions[i];
+            append(key, binding.binding);
+            append(key, binding.stride);
+            append(key, binding.inputRate);
+        }
+        append(key, vertexInput->vertexAttributeDescriptionCount);
+        for (uint32_t i = 0; i < vertexInput->vertexAttributeDescriptionCount; ++i) {
+            const auto& attribute = vertexInput->pVertexAttributeDescriptions[i];
+            append(key, attribute.location);
+            append(key, attribute.binding);
+            append(key, attribute.format);
+            append(key, attribute.offset);
+        }
+    }
+
+    append(key, info.pInputAssemblyState != nullptr);
+    if (const auto* inputAssembly = info.pInputAssemblyState) {
+        if (inputAssembly->pNext != nullptr)
+            return false;
+        append(key, inputAssembly->topology);
+        append(key, inputAssembly->primitiveRestartEnable);
+    }
+
+    append(key, info.pTessellationState != nullptr);
+    if (const auto* tessellation = info.pTessellationState) {
+        if (tessellation->pNext != nullptr)
+            return false;
+        append(key, tessellation->patchControlPoints);
+    }
+
+    // Dynamic viewports and scissors are ignored, so e.g. the fullscreen passes don't depend on the swapchain extent
+    append(key, info.pViewportState != nullptr);
+    if (const auto* viewport = info.pViewportState) {
+        if (viewport->pNext != nullptr)
+            return false;
+        append(key, viewport->viewportCount);
+        append(key, viewport->scissorCount);
+        if (!dynamicViewport && viewport->pViewports) {
+            for (uint32_t i = 0; i < viewport->viewportCount; ++i) {
+                const auto& v = viewport->pViewports[i];
+                append(key, v.x);
+                append(key, v.y);
+                append(key, v.width);
+                append(key, v.height);
+                append(key, v.minDepth);
+                append(key, v.maxDepth);
+            }
+        }
+        if (!dynamicScissor && viewport->pScissors) {
+            for (uint32_t i = 0; i < viewport->scissorCount; ++i) {
+                const auto& s = viewport->pScissors[i];
+                append(key, s.offset.x);
+                append(key, s.offset.y);
+                append(key, s.extent.width);
+                append(key, s.extent.height);
+            }
+        }
+    }
+
+    append(key, info.pRasterizationState != nullptr);
+    if (const auto* rasterization = info.pRasterizationState) {
+        if (rasterization->pNext != nullptr)
+            return false;
+        append(key, rasterization->depthClampEnable);
+        append(key, rasterization->rasterizerDiscardEnable);
+        append(key, rasterization->polygonMode);
+        append(key, rasterization->cullMode);
+        append(key, rasterization->frontFace);
+        append(key, rasterization->depthBiasEnable);
+        append(key, rasterization->depthBiasConstantFactor);
+        append(key, rasterization->depthBiasClamp);
+        append(key, rasterization->depthBiasSlopeFactor);
+        append(key, rasterization->lineWidth);
+    }
+
+    append(key, info.pMultisampleState != nullptr);
+    if (const auto* multisample = info.pMultisampleState) {
+        if (multisample->pNext != nullptr)
+            return false;
+        append(key, multisample->rasterizationSamples);
+        append(key, multisample->sampleShadingEnable);
+        append(key, multisample->minSampleShading);
+        append(key, multisample->alphaToCoverageEnable);
+        append(key, multisample->alphaToOneEnable);
+        append(key, multisample->pSampleMask != nullptr);
+        if (multisample->pSampleMask)
+            appendArray(key, multisample->pSampleMask, (multisample->rasterizationSamples + 31) / 32);
+    }
+
+    append(key, info.pDepthStencilState != nullptr);
+    if (const auto* depthStencil = info.pDepthStencilState) {
+        if (depthStencil->pNext != nullptr)
+            return false;
+        append(key, depthStencil->depthTestEnable);
+        append(key, depthStencil->depthWriteEnable);
+        append(key, depthStencil->depthCompareOp);
+        append(key, depthStencil->depthBoundsTestEnable);
+        append(key, depthStencil->stencilTestEnable);
+        appendStencil(key, depthStencil->front);
+        appendStencil(key, depthStencil->back);
+        append(key, depthStencil->minDepthBounds);
+        append(key, depthStencil->maxDepthBounds);
+    }
+
+    append(key, info.pColorBlendState != nullptr);
+    if (const auto* colorBlend = info.pColorBlendState) {
+        if (colorBlend->pNext != nullptr)
+            return false;
+        append(key, colorBlend->logicOpEnable);
+        append(key, colorBlend->logicOp);
+        append(key, colorBlend->attachmentCount);
+        for (uint32_t i = 0; i < colorBlend->attachmentCount; ++i) {
+            const auto& attachment = colorBlend->pAttachments[i];
+            append(key, attachment.blendEnable);
+            append(key, attachment.srcColorBlendFactor);
+            append(key, attachment.dstColorBlendFactor);
+            append(key, attachment.colorBlendOp);
+            append(key, attachment.srcAlphaBlendFactor);
+            append(key, attachment.dstAlphaBlendFactor);
+            append(key, attachment.alphaBlendOp);
+            append(key, attachment.colorWriteMask);
+        }
+        for (float constant : colorBlend->blendConstants)
+            append(key, constant);
+    }
+
+    return true;
+}
+
+bool PipelineRegistry::pipelineKey(const VkComputePipelineCreateInfo& info, std::string& key) const
+{
+    if (info.pNext != nullptr || info.basePipelineHandle != VK_NULL_HANDLE)
+        return false;
+
+    // a leading marker keeps compute keys apart from graphics ones
+    key.push_back('c');
+    append(key, info.flags);
+    appendHandle(key, info.layout);
+    return stageKey(info.stage, key);
+}
+
+template <typename Info, typename Create>
+VkPipeline PipelineRegistry::getPipeline(const Info& info, const std::string& name, Create create)
+{
+    std::string key;
+    bool shareable;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pipelineRequests++;
+        shareable = pipelineKey(info, key);
+        if (shareable) {
+            auto it = pipelines.find(key);
+            if (it != pipelines.end()) {
+                it->second.refs++;
+                return it->second.pipeline;
+            }
+        }
+    }
+
+    // Build outside the lock so pipelines of different nodes compile concurrently
+    auto start = std::chrono::steady_clock::now();
+    VkPipeline pipeline;
+    if (create(&pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create " + name + " pipeline!");
+    }
+    double create_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!shareable) {
+        key = "unshared:" + std::to_string(reinterpret_cast<uintptr_t>(pipeline));
+    } else if (auto it = pipelines.find(key); it != pipelines.end()) {
+        // Another thread built the same pipeline in the meantime
+        vkDestroyPipeline(ctx->device, pipeline, nullptr);
+        it->second.refs++;
+        return it->second.pipeline;
+    }
+    pipelines[key]         = { pipeline, 1, name, create_ms };
+    pipelineKeys[pipeline] = key;
+    return pipeline;
+}
+
+VkPipeline PipelineRegistry::getGraphicsPipeline(const VkGraphicsPipelineCreateInfo& info, const std::string& name)
+{
+    return getPipeline(info, name, [&](VkPipeline* pipeline) {
+        return vkCreateGraphicsPipelines(ctx->device, VK_NULL_HANDLE, 1, &info, nullptr, pipeline);
+    });
+}
+
+VkPipeline PipelineRegistry::getComputePipeline(const VkComputePipelineCreateInfo& info, const std::string& name)
+{
+    return getPipeline(info, name, [&](VkPipeline* pipeline) {
+        return vkCreateComputePipelines(ctx->device, VK_NULL_HANDLE, 1, &info, nullptr, pipeline);
+    });
+}
+
+void PipelineRegistry::releasePipeline(VkPipeline pipeline)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = pipelineKeys.find(pipeline);
+    if (key == pipelineKeys.end()) {
+        throw std::runtime_error("releasing a pipeline not owned by the registry!");
+    }
+    auto it = pipelines.find(key->second);
+    if (--it->second.refs == 0) {
+        vkDestroyPipeline(ctx->device, pipeline, nullptr);
+        pipelines.erase(it);
+        pipelineKeys.erase(key);
+    }
+}
+
+void PipelineRegistry::logStatistics()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    double total_ms = 0.0;
+    for (const auto& [key, entry] : pipelines) {
+        INFO_ALL("Pipeline {}: {:.2f} ms, {} user(s)", entry.name, entry.create_ms, entry.refs);
+        total_ms += entry.create_ms;
+    }
+    INFO_ALL("{} pipeline requests served by {} pipelines and {} layouts, {:.2f} ms spent creating pipelines",
+        pipelineRequests, pipelines.size(), layouts.size(), total_ms);
+}
+
+void PipelineRegistry::cleanup()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& [key, entry] : pipelines)
+        vkDestroyPipeline(ctx->device, entry.pipeline, nullptr);
+    for (const auto& [key, entry] : layouts)
+        vkDestroyPipelineLayout(ctx->device, entry.layout, nullptr);
+    pipelines.clear();
+    pipelineKeys.clear();
+    layouts.clear();
+    layoutKeys.clear();
+    moduleCodeIds.clear();
+    codeIds.clear();
+}
+}
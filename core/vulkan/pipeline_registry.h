@@ -0,0 +1,69 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace Vk {
+
+struct Context;
+
+// Owns every pipeline layout, graphics and compute pipeline built by the render graph. Requests are keyed by
+// the full create description, so identical layouts and pipelines are created once and shared.
+// Handles are reference counted, release them instead of calling vkDestroy*. Thread-safe.
+class PipelineRegistry {
+    struct LayoutEntry {
+        VkPipelineLayout layout;
+        uint32_t refs;
+    };
+
+    struct PipelineEntry {
+        VkPipeline pipeline;
+        uint32_t refs;
+        std::string name;
+        double create_ms;
+    };
+
+    std::string layoutKey(const VkPipelineLayoutCreateInfo& info) const;
+    bool stageKey(const VkPipelineShaderStageCreateInfo& stage, std::string& key) const;
+    bool pipelineKey(const VkGraphicsPipelineCreateInfo& info, std::string& key) const;
+    bool pipelineKey(const VkComputePipelineCreateInfo& info, std::string& key) const;
+    // returns the shared pipeline of key, or the one create builds
+    template <typename Info, typename Create>
+    VkPipeline getPipeline(const Info& info, const std::string& name, Create create);
+
+    Context* ctx;
+    std::mutex mutex;
+
+    // SPIR-V blob -> code id, shader module -> code id of the blob it was created from
+    std::unordered_map<std::string, uint64_t> codeIds;
+    std::unordered_map<VkShaderModule, uint64_t> moduleCodeIds;
+
+    std::unordered_map<std::string, LayoutEntry> layouts;
+    std::unordered_map<VkPipelineLayout, std::string> layoutKeys;
+    std::unordered_map<std::string, PipelineEntry> pipelines;
+    std::unordered_map<VkPipeline, std::string> pipelineKeys;
+    uint32_t pipelineRequests = 0;
+
+public:
+    PipelineRegistry() = default;
+    void init(Context* ctx);
+
+    // Modules passed to get*Pipeline() must come from here so the key covers the shader code
+    VkShaderModule createShaderModule(const std::vector<char>& code);
+    void destroyShaderModule(VkShaderModule module);
+
+    VkPipelineLayout getLayout(const std::vector<VkDescriptorSetLayout>& set_layouts, const std::vector<VkPushConstantRange>& push_constants = {});
+    void releaseLayout(VkPipelineLayout layout);
+
+    // name is only used for the statistics
+    VkPipeline getGraphicsPipeline(const VkGraphicsPipelineCreateInfo& info, const std::string& name);
+    VkPipeline getComputePipeline(const VkComputePipelineCreateInfo& info, const std::string& name);
+    void releasePipeline(VkPipeline pipeline);
+
+    void logStatistics();
+    void cleanup();
+};
+}
@@ -2,6 +2,7 @@
 #include "core/vulkan/type/buffer.h"
 #include "core/vulkan/vulkan_context.h"
 #include "core/vulkan/vulkan_util.h"
+#include <algorithm>
 
 namespace Vk {
 Image::Image()  = default;
@@ -29,6 +30,7 @@ Image Image::New(const Context& ctx,
     i.layout  = VK_IMAGE_LAYOUT_UNDEFINED;
     i.sampler = VK_NULL_HANDLE;
     i.numLayers = arrayLayers;
+    i.mipLevels = mipLevels;
     return i;
 }
 
@@ -40,13 +42,13 @@ void Image::CreateUUID()
 
 void Image::TransitionLayout(const Context& ctx, VkImageLayout newLayout)
 {
-    transitionImageLayout(ctx.commandBuffer, image, format, numLayers,layout, newLayout);
+    transitionImageLayout(ctx.commandBuffer, image, format, numLayers, layout, newLayout, mipLevels);
     layout = newLayout;
 }
 
 void Image::TransitionLayoutSingleTime(const Context& ctx, VkImageLayout newLayout)
 {
-    transitionImageLayoutSingleTime(ctx, image, format, numLayers, layout, newLayout);
+    transitionImageLayoutSingleTime(ctx, image, format, numLayers, layout, newLayout, mipLevels);
     layout = newLayout;
 }
 
@@ -78,7 +80,7 @@ void Image::AddSampler(const Context& ctx, const VkFilter filter, const std::vec
     sampler_info.mipmapMode              = VK_SAMPLER_MIPMAP_MODE_LINEAR;
     sampler_info.mipLodBias              = 0.0f;
     sampler_info.minLod                  = 0.0f;
-    sampler_info.maxLod                  = 0.0f;
+    sampler_info.maxLod                  = static_cast<float>(mipLevels);
     if (vkCreateSampler(ctx.device, &sampler_info, nullptr, &sampler) != VK_SUCCESS) {
         throw std::runtime_error("failed to create texture sampler!");
     }
@@ -108,6 +110,59 @@ void Image::Update(const Context& ctx, const void* data, uint32_t mipLevel)
     vkFreeMemory(ctx.device, staging_buffer_memory, nullptr);
 }
 
+void Image::UpdateMipChain(const Context& ctx, const void* data, const std::vector<size_t>& levelOffsets)
+{
+    assert(levelOffsets.size() == mipLevels + 1);
+    const VkDeviceSize dataSize = levelOffsets.back();
+
+    VkBuffer staging_buffer;
+    VkDeviceMemory staging_buffer_memory;
+    createBuffer(
+        ctx,
+        dataSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        staging_buffer, staging_buffer_memory);
+    void* mapped_data;
+    vkMapMemory(ctx.device, staging_buffer_memory, 0, dataSize, 0, &mapped_data);
+    memcpy(mapped_data, data, dataSize);
+    vkUnmapMemory(ctx.device, staging_buffer_memory);
+
+    std::vector<VkBufferImageCopy> regions(mipLevels);
+    for (uint32_t level = 0; level < mipLevels; level++) {
+        auto& region                           = regions[level];
+        region.bufferOffset                    = levelOffsets[level];
+        region.bufferRowLength                 = 0; // Tightly packed
+        region.bufferImageHeight               = 0;
+        region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel       = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount     = numLayers;
+        region.imageOffset                     = { 0, 0, 0 };
+        region.imageExtent                     = {
+            std::max(1u, extent.width >> level),
+            std::max(1u, extent.height >> level),
+            std::max(1u, extent.depth >> level)
+        };
+    }
+
+    if (layout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        TransitionLayoutSingleTime(ctx, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    }
+    singleTimeCommands(ctx, [&](const VkCommandBuffer& commandBuffer) {
+        vkCmdCopyBufferToImage(
+            commandBuffer,
+            staging_buffer,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(regions.size()),
+            regions.data());
+    });
+
+    vkDestroyBuffer(ctx.device, staging_buffer, nullptr);
+    vkFreeMemory(ctx.device, staging_buffer_memory, nullptr);
+}
+
 #ifdef _WIN64
     HANDLE Image::getVkMemHandle(const Context& ctx) const
     {
@@ -32,6 +32,9 @@ struct Image {
     void AddSampler(const Context& ctx, const VkFilter filter, const std::vector<VkSamplerAddressMode>& addressMode, const VkBorderColor borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK);
     void AddDefaultSampler(const Context& ctx);
     void Update(const Context& ctx, const void* data, uint32_t mipLevel = 0);
+    // Uploads every mip level in one copy, level i starts at levelOffsets[i] in data and
+    // levelOffsets.back() is the total size. Leaves the image in TRANSFER_DST_OPTIMAL
+    void UpdateMipChain(const Context& ctx, const void* data, const std::vector<size_t>& levelOffsets);
 #ifdef _WIN64
     void* getVkMemHandle(const Context& ctx) const;
 #else
@@ -71,6 +74,7 @@ struct Image {
     VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
     size_t size;
     uint32_t numLayers;
+    uint32_t mipLevels = 1;
 
     VkSampler sampler = VK_NULL_HANDLE;
 };
@@ -255,6 +255,7 @@ void Context::createLogicalDeviceAndQueue()
     deviceFeatures.pNext = &device12Features;
     vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures);
     assert(deviceFeatures.features.multiDrawIndirect);
+    assert(deviceFeatures.features.drawIndirectFirstInstance);
     assert(device12Features.drawIndirectCount);
     assert(device12Features.shaderSampledImageArrayNonUniformIndexing);
     assert(device12Features.descriptorBindingSampledImageUpdateAfterBind);
@@ -263,6 +264,11 @@ void Context::createLogicalDeviceAndQueue()
     assert(device12Features.shaderStorageBufferArrayNonUniformIndexing);
     assert(device12Features.descriptorBindingStorageBufferUpdateAfterBind);
     assert(transformFeedbackFeatures.transformFeedback);
+    // every supported feature is enabled, see pNext below
+    textureCompressionBC = deviceFeatures.features.textureCompressionBC;
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+    maxDrawIndirectCount = deviceProperties.limits.maxDrawIndirectCount;
 
     VkDeviceCreateInfo createInfo {};
     createInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -43,6 +43,11 @@ struct Context {
 
     VkSurfaceKHR surface;
 
+    // device features that are used when present
+    bool textureCompressionBC = false;
+    // draws per vkCmdDrawIndexedIndirect
+    uint32_t maxDrawIndirectCount = 1;
+
     VkSwapchainKHR swapChain;
     std::vector<std::unique_ptr<Image>> swapChainImages;
 
@@ -352,7 +352,8 @@ void transitionImageLayout(
     VkFormat format,
     uint32_t numLayers,
     VkImageLayout oldLayout,
-    VkImageLayout newLayout)
+    VkImageLayout newLayout,
+    uint32_t mipLevels)
 {
     assert(numLayers > 0 && numLayers <= 512);
     VkImageMemoryBarrier barrier {};
@@ -364,7 +365,7 @@ void transitionImageLayout(
     barrier.image                           = image;
     barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel   = 0;
-    barrier.subresourceRange.levelCount     = 1;
+    barrier.subresourceRange.levelCount     = mipLevels;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount     = numLayers;
     barrier.srcAccessMask                   = 0; // TODO
@@ -414,10 +415,11 @@ void transitionImageLayoutSingleTime(
     VkFormat format,
     uint32_t numLayers,
     VkImageLayout oldLayout,
-    VkImageLayout newLayout)
+    VkImageLayout newLayout,
+    uint32_t mipLevels)
 {
     singleTimeCommands(ctx, [&](const VkCommandBuffer& commandBuffer) {
-        transitionImageLayout(commandBuffer, image, format, numLayers, oldLayout, newLayout);
+        transitionImageLayout(commandBuffer, image, format, numLayers, oldLayout, newLayout, mipLevels);
     });
 }
 
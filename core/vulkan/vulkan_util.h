@@ -88,14 +88,16 @@ void transitionImageLayout(
     VkFormat format,
     uint32_t numLayers,
     VkImageLayout oldLayout,
-    VkImageLayout newLayout);
+    VkImageLayout newLayout,
+    uint32_t mipLevels = 1);
 void transitionImageLayoutSingleTime(
     const Vk::Context& ctx,
     VkImage image,
     VkFormat format,
     uint32_t numLayers,
     VkImageLayout oldLayout,
-    VkImageLayout newLayout);
+    VkImageLayout newLayout,
+    uint32_t mipLevels = 1);
 
 void copyBufferToImage(
     VkCommandBuffer commandBuffer,
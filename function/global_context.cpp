@@ -10,6 +10,7 @@ void GlobalContext::init(Configuration& config, GLFWwindow* window)
 {
     vk.init(config, window);
     dm.init(&vk);
+    pipelines.init(&vk);
 
     rm = std::make_unique<ResourceManager>();
     rm->load(config);
@@ -20,6 +21,7 @@ void GlobalContext::init(Configuration& config, GLFWwindow* window)
 void GlobalContext::cleanup()
 {
     rm->cleanup();
+    pipelines.cleanup();
     dm.cleanup();
     vk.cleanup();
 }
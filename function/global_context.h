@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/vulkan/descriptor_manager.h"
+#include "core/vulkan/pipeline_registry.h"
 #include "core/vulkan/vulkan_context.h"
 #include "core/vulkan/profiler.h"
 
@@ -20,6 +21,7 @@ struct GlobalContext {
 
     Vk::Context vk;
     Vk::DescriptorManager dm;
+    Vk::PipelineRegistry pipelines;
     Vk::Profiler profiler;
     std::unique_ptr<ResourceManager> rm;
 
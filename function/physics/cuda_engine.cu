@@ -41,12 +41,15 @@ void CudaEngine::importExtImage(const ExtImageDesc& image_desc)
 {
     static std::unordered_map<VkFormat, cudaChannelFormatDesc> channel_map {
             { VK_FORMAT_R32_SFLOAT, { 32, 0, 0, 0, cudaChannelFormatKindFloat } },
+            { VK_FORMAT_R16_SFLOAT, { 16, 0, 0, 0, cudaChannelFormatKindFloat } },
             { VK_FORMAT_R8_UINT,    { 8, 0, 0, 0, cudaChannelFormatKindUnsigned } },
             { VK_FORMAT_R32G32B32A32_SFLOAT, { 32, 32, 32, 32, cudaChannelFormatKindFloat } }
     };
 
     assert(image_desc.width * image_desc.height * image_desc.depth == image_desc.image_size / image_desc.element_size);
-    assert(channel_map.contains(image_desc.format));
+    // normalized and block compressed fields aren't exported, see Field::initFieldImage
+    if (!channel_map.contains(image_desc.format))
+        throw std::runtime_error("can't import the image " + image_desc.name + ", its format has no CUDA channel format");
 
     cudaExternalMemoryHandleDesc externalMemoryDesc = {};
     {
@@ -39,6 +39,8 @@ void RenderEngine::initRenderGraph(std::function<void(VkCommandBuffer)> fn, std:
 
     if (render_graph_cfg.name == "default") {
         render_graph = std::make_unique<DefaultGraph>();
+    } else if (render_graph_cfg.name == "deferred") {
+        render_graph = std::make_unique<DeferredGraph>();
     } else if (render_graph_cfg.name == "voxelization") {
         render_graph = std::make_unique<VoxelizationGraph>();
     } else if (render_graph_cfg.name == "smoke_field") {
@@ -66,14 +68,25 @@ void RenderEngine::render()
 }
 
 void RenderEngine::update() const {
-    for (auto& obj : g_ctx->rm->objects) {
-        obj.updatePosition(g_ctx->frame_time);
+    auto& objects = g_ctx->rm->objects;
+    for (uint32_t i = 0; i < objects.size(); i++) {
+        if (objects[i].updatePosition(g_ctx->frame_time)) {
+            g_ctx->rm->object_bvh.update(i, objects[i].bounds);
+            g_ctx->rm->object_buffer.markDirty(i);
+        }
     }
+    g_ctx->rm->object_bvh.refit();
+    g_ctx->rm->cullObjects();
+    g_ctx->rm->selectLods();
 }
 
 void RenderEngine::draw()
 {
     vkWaitForFences(g_ctx->vk.device, 1, &g_ctx->vk.inFlightFences[g_ctx->currentFrame % MAX_FRAMES_IN_FLIGHT], VK_TRUE, UINT64_MAX);
+    // the only frame in flight is done, streamed textures can swap their images and object params change
+    static_assert(MAX_FRAMES_IN_FLIGHT == 1);
+    g_ctx->rm->texture_streamer.update();
+    g_ctx->rm->object_buffer.update(g_ctx->rm->objects);
 
     uint32_t swapchain_index;
     VkResult result = vkAcquireNextImageKHR(
@@ -202,6 +215,7 @@ void RenderEngine::onResize()
 
     vkDeviceWaitIdle(g_ctx->vk.device);
 
+    auto reload_lock = render_graph->pauseShaderReload();
     g_ctx->vk.recreateSwapChain();
     render_graph->onResize();
     g_ctx->rm->camera.update_aspect_ratio(
@@ -2,6 +2,10 @@
 
 void DefaultGraph::init(Configuration& cfg)
 {
+    nodes["OcclusionCulling"]
+        = std::move(std::make_unique<OcclusionCulling>("OcclusionCulling", "depth"));
+    nodes["DepthPrepass"]
+        = std::move(std::make_unique<DepthPrepass>("DepthPrepass", "depth"));
     nodes["DefaultObject"]
         = std::move(std::make_unique<DefaultObject>("DefaultObject", "object_color", "depth"));
     nodes["HDRToSDR"]
@@ -16,11 +20,15 @@ void DefaultGraph::init(Configuration& cfg)
         = std::move(std::make_unique<Record>("Record", RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()));
     initAttachments();
 
-    for (auto& node : nodes) {
-        node.second->init(cfg, attachments);
-    }
+    initNodes(cfg);
+    dynamic_cast<OcclusionCulling*>(nodes["OcclusionCulling"].get())
+        ->addDraws(dynamic_cast<DefaultObject*>(nodes["DefaultObject"].get())->objectDraws());
+    dynamic_cast<DepthPrepass*>(nodes["DepthPrepass"].get())
+        ->setDraws(dynamic_cast<DefaultObject*>(nodes["DefaultObject"].get())->objectDraws());
 
     graph = {
+        { "DepthPrepass", { "OcclusionCulling" } },
+        { "DefaultObject", { "DepthPrepass" } },
         { "HDRToSDR", { "DefaultObject" } },
         { "CalculateLuminance", { "HDRToSDR" } },
         { "FXAA", { "CalculateLuminance" } },
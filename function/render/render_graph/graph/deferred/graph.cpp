@@ -0,0 +1,60 @@
+#include "graph.h"
+#include "function/global_context.h"
+#include "function/resource_manager/resource_manager.h"
+
+void DeferredGraph::init(Configuration& cfg)
+{
+    // fire lights and the fire field only when the fields have a temperature
+    const bool fire = g_ctx.rm->fields.has_temperature;
+
+    nodes["OcclusionCulling"]
+        = std::move(std::make_unique<OcclusionCulling>("OcclusionCulling", "depth"));
+    nodes["GBuffer"]
+        = std::move(std::make_unique<GBuffer>("GBuffer", "gbuffer_normal", "gbuffer_albedo", "depth"));
+    nodes["DeferredLighting"]
+        = std::move(std::make_unique<DeferredLighting>("DeferredLighting", "gbuffer_normal", "gbuffer_albedo", "depth", "object_color"));
+    if (fire) {
+        nodes["LightCulling"]
+            = std::move(std::make_unique<LightCulling>("LightCulling"));
+        nodes["MacrocellGrid"]
+            = std::move(std::make_unique<MacrocellGrid>("MacrocellGrid"));
+        nodes["FireField"]
+            = std::move(std::make_unique<FireFieldNode>("FireField", "object_color", "depth", "field_object_color"));
+    }
+    nodes["HDRToSDR"]
+        = std::move(std::make_unique<HDRToSDR>("HDRToSDR", fire ? "field_object_color" : "object_color", "sdr_buf"));
+    nodes["CalculateLuminance"]
+        = std::move(std::make_unique<CalculateLuminance>("CalculateLuminance", "sdr_buf", "sdr_buf_alpha_illuminance"));
+    nodes["FXAA"]
+        = std::move(std::make_unique<FXAANode>("FXAA", "sdr_buf_alpha_illuminance", RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()));
+    nodes["UI"]
+        = std::move(std::make_unique<UI>("UI", RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME(), fn));
+    nodes["Record"]
+        = std::move(std::make_unique<Record>("Record", RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()));
+    initAttachments();
+
+    initNodes(cfg);
+    dynamic_cast<OcclusionCulling*>(nodes["OcclusionCulling"].get())
+        ->addDraws(dynamic_cast<GBuffer*>(nodes["GBuffer"].get())->objectDraws());
+
+    graph = {
+        { "GBuffer", { "OcclusionCulling" } },
+        { "CalculateLuminance", { "HDRToSDR" } },
+        { "FXAA", { "CalculateLuminance" } },
+        { "Record", { "FXAA" } },
+        { "UI", { "Record", "FXAA" } },
+    };
+    if (fire) {
+        auto* light_culling = dynamic_cast<LightCulling*>(nodes["LightCulling"].get());
+        dynamic_cast<DeferredLighting*>(nodes["DeferredLighting"].get())
+            ->setFireLights(light_culling->clusterHandle(), light_culling->indexHandle());
+
+        graph["DeferredLighting"] = { "GBuffer", "LightCulling" };
+        graph["FireField"]        = { "DeferredLighting", "MacrocellGrid" };
+        graph["HDRToSDR"]         = { "FireField" };
+    } else {
+        graph["DeferredLighting"] = { "GBuffer" };
+        graph["HDRToSDR"]         = { "DeferredLighting" };
+    }
+    initGraph();
+}
@@ -2,8 +2,16 @@
 
 void FireFieldGraph::init(Configuration& cfg)
 {
+    nodes["OcclusionCulling"]
+        = std::move(std::make_unique<OcclusionCulling>("OcclusionCulling", "depth"));
+    nodes["DepthPrepass"]
+        = std::move(std::make_unique<DepthPrepass>("DepthPrepass", "depth"));
+    nodes["LightCulling"]
+        = std::move(std::make_unique<LightCulling>("LightCulling"));
     nodes["FireObject"]
         = std::move(std::make_unique<FireObject>("FireObject", "object_color", "depth"));
+    nodes["MacrocellGrid"]
+        = std::move(std::make_unique<MacrocellGrid>("MacrocellGrid"));
     nodes["FireField"]
         = std::move(std::make_unique<FireFieldNode>("FireField", "object_color", "depth", "field_object_color"));
     nodes["HDRToSDR"]
@@ -18,12 +26,19 @@ void FireFieldGraph::init(Configuration& cfg)
         = std::move(std::make_unique<Record>("Record", RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()));
     initAttachments();
 
-    for (auto& node : nodes) {
-        node.second->init(cfg, attachments);
-    }
+    initNodes(cfg);
+    dynamic_cast<OcclusionCulling*>(nodes["OcclusionCulling"].get())
+        ->addDraws(dynamic_cast<FireObject*>(nodes["FireObject"].get())->objectDraws());
+    dynamic_cast<DepthPrepass*>(nodes["DepthPrepass"].get())
+        ->setDraws(dynamic_cast<FireObject*>(nodes["FireObject"].get())->objectDraws());
+    auto* light_culling = dynamic_cast<LightCulling*>(nodes["LightCulling"].get());
+    dynamic_cast<FireObject*>(nodes["FireObject"].get())
+        ->setLightClusters(light_culling->clusterHandle(), light_culling->indexHandle());
 
     graph = {
-        { "FireField", { "FireObject" } },
+        { "DepthPrepass", { "OcclusionCulling" } },
+        { "FireObject", { "DepthPrepass", "LightCulling" } },
+        { "FireField", { "FireObject", "MacrocellGrid" } },
         { "HDRToSDR", { "FireField" } },
         { "CalculateLuminance", { "HDRToSDR" } },
         { "FXAA", { "CalculateLuminance" } },
@@ -1,4 +1,5 @@
 #include "./default/graph.h"
+#include "./deferred/graph.h"
 #include "./fire_field/graph.h"
 #include "./smoke_field/graph.h"
 #include "./vorticity_field/graph.h"
@@ -2,8 +2,14 @@
 
 void SmokeFieldGraph::init(Configuration& cfg)
 {
+    nodes["OcclusionCulling"]
+        = std::move(std::make_unique<OcclusionCulling>("OcclusionCulling", "depth"));
+    nodes["DepthPrepass"]
+        = std::move(std::make_unique<DepthPrepass>("DepthPrepass", "depth"));
     nodes["DefaultObject"]
         = std::move(std::make_unique<DefaultObject>("DefaultObject", "object_color", "depth"));
+    nodes["MacrocellGrid"]
+        = std::move(std::make_unique<MacrocellGrid>("MacrocellGrid"));
     nodes["SmokeField"]
         = std::move(std::make_unique<SmokeFieldNode>("SmokeField", "object_color", "depth", "field_object_color"));
     nodes["HDRToSDR"]
@@ -18,12 +24,16 @@ void SmokeFieldGraph::init(Configuration& cfg)
         = std::move(std::make_unique<Record>("Record", RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()));
     initAttachments();
 
-    for (auto& node : nodes) {
-        node.second->init(cfg, attachments);
-    }
+    initNodes(cfg);
+    dynamic_cast<OcclusionCulling*>(nodes["OcclusionCulling"].get())
+        ->addDraws(dynamic_cast<DefaultObject*>(nodes["DefaultObject"].get())->objectDraws());
+    dynamic_cast<DepthPrepass*>(nodes["DepthPrepass"].get())
+        ->setDraws(dynamic_cast<DefaultObject*>(nodes["DefaultObject"].get())->objectDraws());
 
     graph = {
-        { "SmokeField", { "DefaultObject" } },
+        { "DepthPrepass", { "OcclusionCulling" } },
+        { "DefaultObject", { "DepthPrepass" } },
+        { "SmokeField", { "DefaultObject", "MacrocellGrid" } },
         { "HDRToSDR", { "SmokeField" } },
         { "CalculateLuminance", { "HDRToSDR" } },
         { "FXAA", { "CalculateLuminance" } },
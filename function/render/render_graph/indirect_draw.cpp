@@ -0,0 +1,293 @@
+#include "indirect_draw.h"
+#include "function/global_context.h"
+#include "function/resource_manager/resource_manager.h"
+#include "function/tool/radix_sort.h"
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+using namespace Vk;
+
+namespace {
+void deleteRegistered(Buffer& buffer)
+{
+    if (buffer.size == 0)
+        return;
+    g_ctx.dm.removeResourceRegistration(buffer.id);
+    Buffer::Delete(g_ctx.vk, buffer);
+    buffer = Buffer {};
+}
+
+// a registered storage buffer holding data, size at least 4 bytes
+Buffer newRegistered(const void* data, size_t size, VkBufferUsageFlags usage = 0)
+{
+    Buffer buffer = Buffer::New(
+        g_ctx.vk,
+        std::max<size_t>(size, sizeof(uint32_t)),
+        usage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    if (size > 0)
+        buffer.Update(g_ctx.vk, data, size);
+    g_ctx.dm.registerResource(buffer, DescriptorType::Storage);
+    return buffer;
+}
+}
+
+void IndirectDraw::init(Filter filter, uint32_t instances, Culling culling)
+{
+    this->filter    = std::move(filter);
+    this->instances = instances;
+    this->culling   = culling;
+    build();
+}
+
+void IndirectDraw::setCulling(Culling culling)
+{
+    // the buffers go with the mode they were built for
+    release();
+    this->culling = culling;
+    build();
+}
+
+void IndirectDraw::update()
+{
+    // a depth pre-pass and the object pass after it share the list, only the first update of a frame culls
+    if (version == g_ctx.rm->object_buffer.version && updated_frame == g_ctx.currentFrame)
+        return;
+    updated_frame = g_ctx.currentFrame;
+    if (version != g_ctx.rm->object_buffer.version)
+        build();
+    if (culling == Culling::Frustum)
+        cull();
+}
+
+void IndirectDraw::build()
+{
+    const auto& objects = g_ctx.rm->objects;
+    // the materials are in the objects' Params, only the mesh decides the batch
+    std::unordered_map<std::string, std::vector<uint32_t>> mesh_objects;
+    std::vector<std::string> mesh_order;
+    for (uint32_t i = 0; i < objects.size(); i++) {
+        if (filter && !filter(objects[i]))
+            continue;
+        auto& batch = mesh_objects[objects[i].mesh];
+        if (batch.empty())
+            mesh_order.emplace_back(objects[i].mesh);
+        batch.emplace_back(i);
+    }
+
+    slots.clear();
+    batches.clear();
+    draws.clear();
+    table.clear();
+    object_slots.assign(objects.size(), NO_SLOT);
+    lod_count = 1;
+    for (const auto& name : mesh_order) {
+        const auto& mesh  = g_ctx.rm->meshes.at(name);
+        const auto& batch = mesh_objects.at(name);
+        // the passes that aren't culled, like voxelization, want the full meshes
+        const Batch range {
+            .first_slot    = static_cast<uint32_t>(slots.size()),
+            .slot_count    = static_cast<uint32_t>(batch.size()),
+            .first_command = 0,
+            .command_count = static_cast<uint32_t>(mesh.submeshes.size()),
+            .lod_count     = culling == Culling::None ? 1 : static_cast<uint32_t>(mesh.lods.size()) + 1,
+        };
+        for (uint32_t object : batch) {
+            object_slots[object] = static_cast<uint32_t>(slots.size());
+            slots.emplace_back(Slot { object, static_cast<uint32_t>(batches.size()) });
+            table.emplace_back(object);
+        }
+        lod_count = std::max(lod_count, range.lod_count);
+        batches.emplace_back(range);
+    }
+    // LOD l of every batch draws from copy l of the table
+    table.resize(slots.size() * lod_count);
+    for (auto& batch : batches) {
+        const auto& mesh    = g_ctx.rm->meshes.at(objects[slots[batch.first_slot].object].mesh);
+        batch.first_command = static_cast<uint32_t>(draws.size());
+        for (uint32_t lod = 0; lod < batch.lod_count; lod++) {
+            for (const auto& submesh : mesh.lodSubmeshes(lod)) {
+                draws.emplace_back(VkDrawIndexedIndirectCommand {
+                    .indexCount    = submesh.indexCount,
+                    .instanceCount = batch.slot_count * instances,
+                    .firstIndex    = mesh.firstIndex + submesh.firstIndex,
+                    .vertexOffset  = mesh.vertexOffset + static_cast<int32_t>(submesh.firstVertex),
+                    .firstInstance = (lod * static_cast<uint32_t>(slots.size()) + batch.first_slot) * instances,
+                });
+            }
+        }
+    }
+
+    // nothing is in flight while the objects change, the old buffers can go right away
+    release();
+    draw_count = static_cast<uint32_t>(draws.size());
+    version    = g_ctx.rm->object_buffer.version;
+
+    // the pipelines' Params hold the table's handle, keep it
+    Buffer old       = instance_objects;
+    instance_objects = Buffer::New(
+        g_ctx.vk,
+        std::max<size_t>(1, table.size()) * sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        culling == Culling::Occlusion ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        culling != Culling::Occlusion);
+    if (old.size > 0) {
+        instance_objects.id = old.id;
+        g_ctx.dm.updateResourceRegistration(instance_objects);
+        Buffer::Delete(g_ctx.vk, old);
+    } else {
+        g_ctx.dm.registerResource(instance_objects, DescriptorType::Storage);
+    }
+    if (culling != Culling::Occlusion && !table.empty())
+        instance_objects.Update(g_ctx.vk, table.data(), table.size() * sizeof(uint32_t));
+
+    if (draws.empty())
+        return;
+    if (culling != Culling::Occlusion) {
+        commands = Buffer::New(
+            g_ctx.vk,
+            sizeof(VkDrawIndexedIndirectCommand) * draws.size(),
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            true);
+        commands.Update(g_ctx.vk, draws.data(), commands.size);
+        return;
+    }
+
+    commands     = newRegistered(draws.data(), sizeof(VkDrawIndexedIndirectCommand) * draws.size());
+    slot_buffer  = newRegistered(slots.data(), sizeof(Slot) * slots.size());
+    batch_buffer = newRegistered(batches.data(), sizeof(Batch) * batches.size());
+    culled       = Buffer::New(
+        g_ctx.vk,
+        commands.size,
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    g_ctx.dm.registerResource(culled, DescriptorType::Storage);
+    culled_count = Buffer::New(
+        g_ctx.vk,
+        sizeof(uint32_t) * (1 + batches.size() * lod_count),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    g_ctx.dm.registerResource(culled_count, DescriptorType::Storage);
+}
+
+void IndirectDraw::cull()
+{
+    // visible_objects is short when most of the scene is out of view, only its slots are touched. The
+    // visible objects of a batch go to the front of its slots in the copy for their LOD, so firstInstance
+    // stays as built. The pipeline is the pass's and the materials are bindless, the only state a command
+    // has is its batch: keyed by batch and LOD, then view depth, every run of a batch's LOD is drawn front
+    // to back and the runs in the order of their nearest object, for early-Z
+    const auto& objects = g_ctx.rm->objects;
+    const auto& camera  = g_ctx.rm->camera.data;
+    instance_keys.clear();
+    for (uint32_t object : g_ctx.rm->visible_objects) {
+        const uint32_t slot = object_slots[object];
+        if (slot == NO_SLOT)
+            continue;
+        const uint32_t batch   = slots[slot].batch;
+        const uint32_t lod     = std::min(objects[object].lod, batches[batch].lod_count - 1);
+        const glm::vec3 center = 0.5f * (objects[object].bounds.bmin + objects[object].bounds.bmax);
+        const uint32_t depth   = RadixSort::floatKey(glm::dot(center - camera.eye_w, camera.view_dir));
+        instance_keys.emplace_back(RadixSort::Item { static_cast<uint64_t>(batch * lod_count + lod) << 32 | depth, object });
+    }
+    RadixSort::sort(instance_keys, sort_scratch);
+
+    run_keys.clear();
+    for (uint32_t first = 0, last; first < instance_keys.size(); first = last) {
+        const uint32_t run = static_cast<uint32_t>(instance_keys[first].key >> 32);
+        for (last = first + 1; last < instance_keys.size() && instance_keys[last].key >> 32 == run; last++) { }
+        const uint32_t batch     = run / lod_count;
+        const uint32_t lod       = run % lod_count;
+        const size_t table_first = lod * slots.size() + batches[batch].first_slot;
+        for (uint32_t i = first; i < last; i++) {
+            table[table_first + i - first] = instance_keys[i].value;
+        }
+        instance_objects.Update(g_ctx.vk, table.data() + table_first, (last - first) * sizeof(uint32_t), table_first * sizeof(uint32_t));
+        // the nearest object of the run comes first, its depth orders the runs
+        run_keys.emplace_back(RadixSort::Item { (instance_keys[first].key & 0xffffffffu) << 32 | run, last - first });
+    }
+    RadixSort::sort(run_keys, sort_scratch);
+
+    draw_count = 0;
+    for (const auto& run : run_keys) {
+        const uint32_t batch         = static_cast<uint32_t>(run.key & 0xffffffffu) / lod_count;
+        const uint32_t lod           = static_cast<uint32_t>(run.key & 0xffffffffu) % lod_count;
+        const uint32_t first_command = batches[batch].first_command + lod * batches[batch].command_count;
+        for (uint32_t c = first_command; c < first_command + batches[batch].command_count; c++) {
+            VkDrawIndexedIndirectCommand command = draws[c];
+            command.instanceCount                = run.value * instances;
+            commands.Update(g_ctx.vk, &command, sizeof(VkDrawIndexedIndirectCommand), draw_count++ * sizeof(VkDrawIndexedIndirectCommand));
+        }
+    }
+}
+
+void IndirectDraw::draw(VkCommandBuffer cmd) const
+{
+    if (culling != Culling::Occlusion) {
+        drawRange(cmd, 0, draw_count);
+        return;
+    }
+    if (draw_count == 0)
+        return;
+    // a GPU count above the device limit is clamped, the limit is at least 2^16 - 1 and 2^32 - 1 in practice
+    vkCmdDrawIndexedIndirectCount(
+        cmd,
+        culled.buffer,
+        0,
+        culled_count.buffer,
+        0,
+        std::min(draw_count, g_ctx.vk.maxDrawIndirectCount),
+        sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void IndirectDraw::drawObject(VkCommandBuffer cmd, uint32_t object) const
+{
+    assert(culling == Culling::None);
+    const uint32_t slot = object_slots[object];
+    if (slot == NO_SLOT)
+        return;
+    // the table of a list that isn't culled holds every object at its slot
+    const Batch& batch = batches[slots[slot].batch];
+    for (uint32_t c = batch.first_command; c < batch.first_command + batch.command_count; c++) {
+        vkCmdDrawIndexed(cmd, draws[c].indexCount, instances, draws[c].firstIndex, draws[c].vertexOffset, slot * instances);
+    }
+}
+
+void IndirectDraw::drawRange(VkCommandBuffer cmd, uint32_t first, uint32_t count) const
+{
+    // split at the device limit, one call in practice
+    while (count > 0) {
+        const uint32_t batch = std::min(count, g_ctx.vk.maxDrawIndirectCount);
+        vkCmdDrawIndexedIndirect(cmd, commands.buffer, first * sizeof(VkDrawIndexedIndirectCommand), batch, sizeof(VkDrawIndexedIndirectCommand));
+        first += batch;
+        count -= batch;
+    }
+}
+
+DescriptorHandle IndirectDraw::instanceHandle() const
+{
+    return g_ctx.dm.getResourceHandle(instance_objects.id);
+}
+
+void IndirectDraw::release()
+{
+    if (culling == Culling::Occlusion) {
+        deleteRegistered(commands);
+        deleteRegistered(slot_buffer);
+        deleteRegistered(batch_buffer);
+        deleteRegistered(culled);
+        deleteRegistered(culled_count);
+    } else if (commands.size > 0) {
+        Buffer::Delete(g_ctx.vk, commands);
+        commands = Buffer {};
+    }
+}
+
+void IndirectDraw::destroy()
+{
+    release();
+    deleteRegistered(instance_objects);
+}
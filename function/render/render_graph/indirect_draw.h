@@ -0,0 +1,107 @@
+#pragma once
+
+#include "core/vulkan/descriptor_manager.h"
+#include "core/vulkan/type/buffer.h"
+#include "function/tool/radix_sort.h"
+#include "function/type/object.h"
+#include <functional>
+#include <vector>
+
+// The draws of a pass over the scene's objects as VkDrawIndexedIndirectCommands. Built once and rebuilt
+// only when the objects change, so recording costs the same for 10 objects or 100k. Accepted objects
+// sharing a mesh are one batch and every submesh of a batch is one instanced command. Instance j of a
+// batch draws the object the instance table holds at slot (firstInstance + j) / instances, the shaders
+// look it up with GetInstanceObject and fetch its Param (and so its material) from the ObjectBuffer.
+// Culled lists draw every object at its Object::lod, with commands per LOD of a batch and a copy of
+// the batch's slots per LOD in the instance table. Frustum culled lists sort the visible objects front
+// to back every update.
+class IndirectDraw {
+    friend class OcclusionCulling;
+
+public:
+    using Filter = std::function<bool(const Object&)>;
+
+    enum class Culling {
+        None,
+        // only the instances of g_ctx.rm->visible_objects, packed on the CPU every update
+        Frustum,
+        // every batch goes to the GPU, an OcclusionCulling node packs the instances passing the frustum
+        // and its Hi-Z and the commands of the batches left into a second buffer, draw() reads the count
+        // it wrote
+        Occlusion,
+    };
+
+    // every object when filter is empty
+    void init(Filter filter = nullptr, uint32_t instances = 1, Culling culling = Culling::None);
+    // switches an initialized list, OcclusionCulling::addDraws sets Occlusion
+    void setCulling(Culling culling);
+    // rebuilds the batches when the objects changed since the last build and packs the visible instances
+    // of a frustum culled list, call before recording. Once per frame, later calls in a frame return early
+    void update();
+    // all commands, the GeometryPool must be bound
+    void draw(VkCommandBuffer cmd) const;
+    // only the instances of objects[object], for passes that change state between objects. Not culled lists only
+    void drawObject(VkCommandBuffer cmd, uint32_t object) const;
+    // the instance table for the pipeline's Param, the same across rebuilds
+    Vk::DescriptorHandle instanceHandle() const;
+    void destroy();
+
+private:
+    // an object of a batch, ObjectSlot in cull.comp
+    struct Slot {
+        uint32_t object;
+        uint32_t batch;
+    };
+    // BatchRange in cull.comp, the commands of LOD l start at first_command + l * command_count
+    struct Batch {
+        uint32_t first_slot;
+        uint32_t slot_count;
+        uint32_t first_command;
+        uint32_t command_count;
+        uint32_t lod_count;
+    };
+
+    void build();
+    void release();
+    void drawRange(VkCommandBuffer cmd, uint32_t first, uint32_t count) const;
+
+    void cull();
+
+    Filter filter;
+    uint32_t instances = 1;
+    Culling culling    = Culling::None;
+    // of the ObjectBuffer the batches were built for
+    uint32_t version = 0;
+    // g_ctx.currentFrame of the last update
+    uint32_t updated_frame = ~0u;
+    // the slots of a batch are contiguous, in the order of the objects
+    std::vector<Slot> slots;
+    std::vector<Batch> batches;
+    // slot of every object, NO_SLOT when the filter rejects it
+    std::vector<uint32_t> object_slots;
+    // every command with all instances of its batch, a frustum culled list writes only the visible ones
+    std::vector<VkDrawIndexedIndirectCommand> draws;
+    Vk::Buffer commands;
+    uint32_t draw_count = 0;
+    // object of every slot, culled lists pack the visible ones to the front of their batch's range in
+    // the copy for their LOD, copy l starts at l * slots.size()
+    std::vector<uint32_t> table;
+    // the most LODs of a batch, 1 when the list isn't culled
+    uint32_t lod_count = 1;
+    Vk::Buffer instance_objects;
+
+    // Frustum only, kept across updates: the visible objects keyed by batch * lod_count + LOD and view
+    // depth, then the runs of one batch and LOD keyed by their nearest depth
+    std::vector<RadixSort::Item> instance_keys;
+    std::vector<RadixSort::Item> run_keys;
+    std::vector<RadixSort::Item> sort_scratch;
+
+    // Occlusion only: the slots and batches the GPU culls, and written by it the commands left and
+    // their count followed by the visible instances of every batch and LOD
+    Vk::Buffer slot_buffer;
+    Vk::Buffer batch_buffer;
+    Vk::Buffer culled;
+    Vk::Buffer culled_count;
+
+    static constexpr uint32_t NO_SLOT = ~0u;
+};
@@ -0,0 +1,122 @@
+#include "light_transmittance.h"
+#include "core/filesystem/file.h"
+#include "core/vulkan/vulkan_util.h"
+#include "function/global_context.h"
+#include "function/resource_manager/resource_manager.h"
+#include <algorithm>
+#include <array>
+
+using namespace Vk;
+
+void LightTransmittance::init(const std::string& shader, uint32_t resolution)
+{
+    if (resolution == 0)
+        throw std::runtime_error("fields need a positive transmittance_resolution");
+    this->shader = shader;
+    // a volume without lights still needs a texel to be sampled
+    light_count = std::max(static_cast<uint32_t>(g_ctx.rm->lights.data.size()), 1u);
+
+    pipeline.param = Param {
+        .lights     = g_ctx.dm.getResourceHandle(g_ctx.rm->lights.buffer.id),
+        .resolution = resolution,
+        .step       = g_ctx.rm->fields.step * 4.0f,
+    };
+
+    const VkExtent3D extent { resolution, resolution, resolution * light_count };
+    texels = Buffer::New(
+        g_ctx.vk,
+        static_cast<VkDeviceSize>(extent.width) * extent.height * extent.depth * 4 * sizeof(uint16_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    g_ctx.dm.registerResource(texels, DescriptorType::Storage);
+    pipeline.param.texels = g_ctx.dm.getResourceHandle(texels.id);
+
+    volume = Image::New(
+        g_ctx.vk,
+        VK_FORMAT_R16G16B16A16_SFLOAT,
+        extent,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        1,
+        1,
+        false,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_TYPE_3D,
+        VK_IMAGE_VIEW_TYPE_3D);
+    // points outside the box take the transmittance at its edge
+    volume.AddSampler(g_ctx.vk, VK_FILTER_LINEAR, std::vector<VkSamplerAddressMode>(3, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE));
+    volume.TransitionLayoutSingleTime(g_ctx.vk, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    g_ctx.dm.registerResource(volume, DescriptorType::CombinedImageSampler);
+}
+
+void LightTransmittance::createPipeline(const std::string& name, const VkSpecializationInfo* constants)
+{
+    std::vector<VkDescriptorSetLayout> descLayouts = {
+        g_ctx.dm.BINDLESS_LAYOUT(),
+        g_ctx.dm.PARAMETER_LAYOUT(),
+    };
+    pipeline.initLayout(descLayouts, { { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Param) } });
+
+    auto shaderCode   = readFile(shader);
+    auto shaderModule = g_ctx.pipelines.createShaderModule(shaderCode);
+
+    VkComputePipelineCreateInfo pipelineInfo {};
+    pipelineInfo.sType              = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage              = Pipeline<Param>::shaderStageDefault(shaderModule, VK_SHADER_STAGE_COMPUTE_BIT, constants);
+    pipelineInfo.layout             = pipeline.layout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+    pipelineInfo.basePipelineIndex  = -1; // Optional
+    pipeline.setPipeline(g_ctx.pipelines.getComputePipeline(pipelineInfo, name));
+    g_ctx.pipelines.destroyShaderModule(shaderModule);
+}
+
+void LightTransmittance::record()
+{
+    // the previous frame's copy reads the texels
+    texels.Barrier(
+        g_ctx.vk,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        VK_ACCESS_SHADER_WRITE_BIT);
+
+    vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+    const std::array<VkDescriptorSet, 2> sets = {
+        *g_ctx.dm.BINDLESS_SET(),
+        *g_ctx.dm.getParameterSet(g_ctx.rm->fields.paramBuffer.id),
+    };
+    vkCmdBindDescriptorSets(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+    vkCmdPushConstants(g_ctx.vk.commandBuffer, pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Param), &pipeline.param);
+    const uint32_t groups = (pipeline.param.resolution + GROUP_SIZE - 1) / GROUP_SIZE;
+    vkCmdDispatch(g_ctx.vk.commandBuffer, groups, groups, (pipeline.param.resolution * light_count + GROUP_SIZE - 1) / GROUP_SIZE);
+
+    texels.Barrier(
+        g_ctx.vk,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_SHADER_WRITE_BIT,
+        VK_ACCESS_TRANSFER_READ_BIT);
+    volume.TransitionLayout(g_ctx.vk, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    texels.CopyTo(g_ctx.vk, volume, volume.extent);
+    volume.TransitionLayout(g_ctx.vk, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+DescriptorHandle LightTransmittance::handle() const
+{
+    return g_ctx.dm.getResourceHandle(volume.id);
+}
+
+PipelineHandles* LightTransmittance::pipelineHandles()
+{
+    return &pipeline;
+}
+
+void LightTransmittance::destroy()
+{
+    pipeline.destroy();
+    g_ctx.dm.removeResourceRegistration(texels.id);
+    Buffer::Delete(g_ctx.vk, texels);
+    g_ctx.dm.removeResourceRegistration(volume.id);
+    Image::Delete(g_ctx.vk, volume);
+}
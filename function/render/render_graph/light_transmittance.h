@@ -0,0 +1,43 @@
+#pragma once
+
+#include "core/vulkan/descriptor_manager.h"
+#include "core/vulkan/type/buffer.h"
+#include "core/vulkan/type/image.h"
+#include "function/render/render_graph/pipeline.hpp"
+#include <string>
+
+// The transmittance from the fields to every scene light, so a field pass lights a sample with one
+// fetch instead of marching towards every light from it, see light_transmittance.glsl. Its compute
+// pass marches once from every texel each frame, as the fields change every frame. A field pass owns
+// one, built from the pass' transmittance.comp so the densities follow its own map_density
+class LightTransmittance {
+public:
+    // shader is the .comp.spv
+    void init(const std::string& shader, uint32_t resolution);
+    // constants holds FIELD_COUNT and MAX_FIELDS as for the pass' node.frag
+    void createPipeline(const std::string& name, const VkSpecializationInfo* constants);
+    // outside of a render pass, before the field pass
+    void record();
+    // the volume for the field pass' Param
+    Vk::DescriptorHandle handle() const;
+    PipelineHandles* pipelineHandles();
+    void destroy();
+
+private:
+    // the push constants
+    struct Param {
+        Vk::DescriptorHandle lights;
+        Vk::DescriptorHandle texels;
+        uint32_t resolution;
+        float step;
+    };
+
+    Pipeline<Param> pipeline;
+    std::string shader;
+    uint32_t light_count = 1;
+    // written by the pass as R16G16B16A16, then copied into the sampled volume
+    Vk::Buffer texels;
+    Vk::Image volume;
+
+    static constexpr uint32_t GROUP_SIZE = 4;
+};
@@ -49,9 +49,21 @@ CalculateLuminance::CalculateLuminance(
 void CalculateLuminance::init(Configuration& cfg, RenderAttachments& attachments)
 {
     this->attachments = &attachments;
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    shader_directory = rg_cfg.shader_directory;
     createRenderPass();
     createFramebuffer();
-    createPipeline(cfg);
+    createPipelineParam();
+}
+
+std::vector<std::function<void()>> CalculateLuminance::pipelineTasks()
+{
+    return { [this] { createPipeline(); } };
+}
+
+std::vector<PipelineHandles*> CalculateLuminance::pipelines()
+{
+    return { &pipeline };
 }
 
 void CalculateLuminance::createFramebuffer()
@@ -99,7 +111,7 @@ void CalculateLuminance::updateDescriptor() {
     pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
 }
 
-void CalculateLuminance::createPipeline(Configuration& cfg)
+void CalculateLuminance::createPipeline()
 {
     {
         std::vector<VkDescriptorSetLayout> descLayouts = {
@@ -117,11 +129,10 @@ void CalculateLuminance::createPipeline(Configuration& cfg)
         auto rasterization = Pipeline<Param>::rasterizationDefault();
         auto multisample   = Pipeline<Param>::multisampleDefault();
 
-        JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
-        auto vertShaderCode                                       = readFile(rg_cfg.shader_directory + "/calculate_luminance/node.vert.spv");
-        auto fragShaderCode                                       = readFile(rg_cfg.shader_directory + "/calculate_luminance/node.frag.spv");
-        auto vertShaderModule                                     = createShaderModule(g_ctx.vk, vertShaderCode);
-        auto fragShaderModule                                     = createShaderModule(g_ctx.vk, fragShaderCode);
+        auto vertShaderCode                                       = readFile(shader_directory + "/calculate_luminance/node.vert.spv");
+        auto fragShaderCode                                       = readFile(shader_directory + "/calculate_luminance/node.frag.spv");
+        auto vertShaderModule                                     = g_ctx.pipelines.createShaderModule(vertShaderCode);
+        auto fragShaderModule                                     = g_ctx.pipelines.createShaderModule(fragShaderCode);
         std::vector<VkPipelineShaderStageCreateInfo> shaderStages = {
             Pipeline<Param>::shaderStageDefault(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT),
             Pipeline<Param>::shaderStageDefault(fragShaderModule, VK_SHADER_STAGE_FRAGMENT_BIT),
@@ -159,25 +170,24 @@ void CalculateLuminance::createPipeline(Configuration& cfg)
         pipelineInfo.subpass             = 0;
         pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE; // Optional
         pipelineInfo.basePipelineIndex   = -1; // Optional
-        if (vkCreateGraphicsPipelines(g_ctx.vk.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline.pipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create graphics pipeline!");
-        }
-        vkDestroyShaderModule(g_ctx.vk.device, vertShaderModule, nullptr);
-        vkDestroyShaderModule(g_ctx.vk.device, fragShaderModule, nullptr);
+        pipeline.setPipeline(g_ctx.pipelines.getGraphicsPipeline(pipelineInfo, name));
+        g_ctx.pipelines.destroyShaderModule(vertShaderModule);
+        g_ctx.pipelines.destroyShaderModule(fragShaderModule);
     }
+}
 
-    {
-        pipeline.param.sdr_img = g_ctx.dm.getResourceHandle(
-            attachments->getAttachment(attachment_descriptions["sdr"].name).id);
-        pipeline.param_buf = Buffer::New(
-            g_ctx.vk,
-            sizeof(Param),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            true);
-        pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
-        g_ctx.dm.registerParameter(pipeline.param_buf);
-    }
+void CalculateLuminance::createPipelineParam()
+{
+    pipeline.param.sdr_img = g_ctx.dm.getResourceHandle(
+        attachments->getAttachment(attachment_descriptions["sdr"].name).id);
+    pipeline.param_buf = Buffer::New(
+        g_ctx.vk,
+        sizeof(Param),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
+    g_ctx.dm.registerParameter(pipeline.param_buf);
 }
 
 void CalculateLuminance::record(uint32_t swapchain_index)
@@ -46,9 +46,24 @@ DefaultObject::DefaultObject(const std::string& name, const std::string& color_b
 void DefaultObject::init(Configuration& cfg, RenderAttachments& attachments)
 {
     this->attachments = &attachments;
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    shader_directory = rg_cfg.shader_directory;
+    depth_prepass    = rg_cfg.depth_prepass;
     createRenderPass();
     createFramebuffer();
-    createPipeline(cfg);
+    // the Param holds the draws' instance table
+    draws.init(nullptr, 1, IndirectDraw::Culling::Frustum);
+    createPipelineParam();
+}
+
+std::vector<std::function<void()>> DefaultObject::pipelineTasks()
+{
+    return { [this] { createPipeline(); } };
+}
+
+std::vector<PipelineHandles*> DefaultObject::pipelines()
+{
+    return { &pipeline };
 }
 
 void DefaultObject::createFramebuffer()
@@ -79,7 +94,8 @@ void DefaultObject::createRenderPass()
 {
     std::vector<AttachmentDescriptionHelper> helpers = {
         { "color", VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE },
-        { "depth", VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE },
+        // a DepthPrepass already wrote it
+        { "depth", depth_prepass ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE },
     };
     VkSubpassDependency dependency = {};
     dependency.srcSubpass          = VK_SUBPASS_EXTERNAL;
@@ -87,18 +103,17 @@ void DefaultObject::createRenderPass()
     dependency.srcStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
     dependency.dstStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
     dependency.srcAccessMask       = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-    dependency.dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
     render_pass = DefaultRenderPass(attachment_descriptions, helpers, dependency);
 }
 
-void DefaultObject::createPipeline(Configuration& cfg)
+void DefaultObject::createPipeline()
 {
     {
         std::vector<VkDescriptorSetLayout> descLayouts = {
             g_ctx.dm.BINDLESS_LAYOUT(),
             g_ctx.dm.PARAMETER_LAYOUT(),
-            g_ctx.dm.PARAMETER_LAYOUT(),
         };
         pipeline.initLayout(descLayouts);
     }
@@ -111,11 +126,10 @@ void DefaultObject::createPipeline(Configuration& cfg)
         auto rasterization = Pipeline<Param>::rasterizationDefault();
         auto multisample   = Pipeline<Param>::multisampleDefault();
 
-        JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
-        auto vertShaderCode                                       = readFile(rg_cfg.shader_directory + "/default_object/node.vert.spv");
-        auto fragShaderCode                                       = readFile(rg_cfg.shader_directory + "/default_object/node.frag.spv");
-        auto vertShaderModule                                     = createShaderModule(g_ctx.vk, vertShaderCode);
-        auto fragShaderModule                                     = createShaderModule(g_ctx.vk, fragShaderCode);
+        auto vertShaderCode                                       = readFile(shader_directory + "/default_object/node.vert.spv");
+        auto fragShaderCode                                       = readFile(shader_directory + "/default_object/node.frag.spv");
+        auto vertShaderModule                                     = g_ctx.pipelines.createShaderModule(vertShaderCode);
+        auto fragShaderModule                                     = g_ctx.pipelines.createShaderModule(fragShaderCode);
         std::vector<VkPipelineShaderStageCreateInfo> shaderStages = {
             Pipeline<Param>::shaderStageDefault(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT),
             Pipeline<Param>::shaderStageDefault(fragShaderModule, VK_SHADER_STAGE_FRAGMENT_BIT),
@@ -132,8 +146,9 @@ void DefaultObject::createPipeline(Configuration& cfg)
         VkPipelineDepthStencilStateCreateInfo depthStencil {};
         depthStencil.sType                 = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
         depthStencil.depthTestEnable       = VK_TRUE;
-        depthStencil.depthWriteEnable      = VK_TRUE;
-        depthStencil.depthCompareOp        = VK_COMPARE_OP_LESS;
+        // only the nearest fragment of a pixel passes against the pre-pass depth
+        depthStencil.depthWriteEnable      = depth_prepass ? VK_FALSE : VK_TRUE;
+        depthStencil.depthCompareOp        = depth_prepass ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS;
         depthStencil.depthBoundsTestEnable = VK_FALSE;
         depthStencil.minDepthBounds        = 0.0f; // Optional
         depthStencil.maxDepthBounds        = 1.0f; // Optional
@@ -156,30 +171,32 @@ void DefaultObject::createPipeline(Configuration& cfg)
         pipelineInfo.subpass             = 0;
         pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE; // Optional
         pipelineInfo.basePipelineIndex   = -1; // Optional
-        if (vkCreateGraphicsPipelines(g_ctx.vk.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline.pipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create graphics pipeline!");
-        }
-        vkDestroyShaderModule(g_ctx.vk.device, vertShaderModule, nullptr);
-        vkDestroyShaderModule(g_ctx.vk.device, fragShaderModule, nullptr);
+        pipeline.setPipeline(g_ctx.pipelines.getGraphicsPipeline(pipelineInfo, name));
+        g_ctx.pipelines.destroyShaderModule(vertShaderModule);
+        g_ctx.pipelines.destroyShaderModule(fragShaderModule);
     }
+}
 
-    {
-        pipeline.param.camera = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer.id);
-        pipeline.param.lights = g_ctx.dm.getResourceHandle(g_ctx.rm->lights.buffer.id);
-        pipeline.param_buf    = Buffer::New(
-            g_ctx.vk,
-            sizeof(Param),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            true);
-        pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
-        g_ctx.dm.registerParameter(pipeline.param_buf);
-    }
+void DefaultObject::createPipelineParam()
+{
+    pipeline.param.camera    = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer.id);
+    pipeline.param.lights    = g_ctx.dm.getResourceHandle(g_ctx.rm->lights.buffer.id);
+    pipeline.param.objects   = g_ctx.dm.getResourceHandle(g_ctx.rm->object_buffer.buffer.id);
+    pipeline.param.instances = draws.instanceHandle();
+    pipeline.param_buf       = Buffer::New(
+        g_ctx.vk,
+        sizeof(Param),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
+    g_ctx.dm.registerParameter(pipeline.param_buf);
 }
 
 void DefaultObject::record(uint32_t swapchain_index)
 {
     setDefaultViewportAndScissor();
+    draws.update();
 
     std::array<VkClearValue, 2> clearValues {};
     clearValues[0].color        = { { 0.0f, 0.0f, 0.0f, 1.0f } }; // dummy
@@ -197,16 +214,8 @@ void DefaultObject::record(uint32_t swapchain_index)
     vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
     bindDescriptorSet(0, pipeline.layout, g_ctx.dm.BINDLESS_SET());
     bindDescriptorSet(1, pipeline.layout, g_ctx.dm.getParameterSet(pipeline.param_buf.id));
-
-    for (const auto& obj : g_ctx.rm->objects) {
-        bindDescriptorSet(2, pipeline.layout, g_ctx.dm.getParameterSet(obj.paramBuffer.id));
-        const auto& mesh = g_ctx.rm->meshes[obj.mesh];
-
-        VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(g_ctx.vk.commandBuffer, 0, 1, &mesh.vertexBuffer.buffer, offsets);
-        vkCmdBindIndexBuffer(g_ctx.vk.commandBuffer, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(g_ctx.vk.commandBuffer, mesh.data.indices.size(), 1, 0, 0, 0);
-    }
+    g_ctx.rm->geometry_pool.bind(g_ctx.vk.commandBuffer);
+    draws.draw(g_ctx.vk.commandBuffer);
 
     vkCmdEndRenderPass(g_ctx.vk.commandBuffer);
 }
@@ -222,6 +231,7 @@ void DefaultObject::onResize()
 void DefaultObject::destroy()
 {
     pipeline.destroy();
+    draws.destroy();
     vkDestroyRenderPass(g_ctx.vk.device, render_pass, nullptr);
     for (auto& framebuffer : framebuffers) {
         vkDestroyFramebuffer(g_ctx.vk.device, framebuffer, nullptr);
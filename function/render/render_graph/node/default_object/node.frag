@@ -4,6 +4,7 @@
 #extension GL_EXT_debug_printf : enable
 
 #include "../../shader/common.glsl"
+#include "../../shader/brdf.glsl"
 
 struct Light {
     vec3 posOrDir;
@@ -51,21 +52,14 @@ layout(set = 1, binding = 0) uniform PipelineParam
 {
     Handle camera;
     Handle lights;
+    Handle objects;
+    Handle instances;
 }
 pipelineParam;
 
-layout(set = 2, binding = 0) uniform ObjectParam
-{
-    mat4 model;
-    mat4 modelInvTrans;
-    Handle material;
-    Handle vertBuf;
-}
-objectParam;
-
 #define camera GetResource(camera, pipelineParam.camera)
 #define lights GetResource(lights, pipelineParam.lights)
-#define MATERIAL GetResource(material, objectParam.material)
+#define MATERIAL GetResource(material, materialHandle)
 #define COLOR_TEXTURE GetResource(textures, MATERIAL.color_texture)
 #define METALLIC_TEXTURE GetResource(textures, MATERIAL.metallic_texture)
 #define ROUGHNESS_TEXTURE GetResource(textures, MATERIAL.roughness_texture)
@@ -76,35 +70,10 @@ layout(location = 0) in vec3 position_w;
 layout(location = 1) in vec3 normal_w;
 layout(location = 2) in vec2 uv;
 layout(location = 3) in vec3 tangent_w;
+layout(location = 4) flat in Handle materialHandle;
 
 layout(location = 0) out vec4 outColor;
 
-const float PI = 3.14159265359;
-
-float D(vec3 h, vec3 normal, float roughness)
-{
-    float numerator = roughness * roughness;
-    float dot_h_n = max(dot(normalize(normal), h), 0.0);
-    float denominator = dot_h_n * dot_h_n * (roughness * roughness - 1) + 1;
-    denominator = PI * denominator * denominator;
-    return numerator / denominator;
-}
-
-vec3 F(vec3 F0, vec3 h, vec3 w_e)
-{
-    return F0 + (1 - F0) * pow(1 - max(dot(w_e, h), 0.0), 5);
-}
-
-float G(vec3 w_e, vec3 w_i, vec3 normal, float k)
-{
-    float dot_w_e_n = dot(w_e, normalize(normal));
-    float g1 = dot_w_e_n / (dot_w_e_n * (1 - k) + k);
-
-    float dot_w_i_n = dot(w_i, normalize(normal));
-    float g2 = dot_w_i_n / (dot_w_i_n * (1 - k) + k);
-    return g1 * g2;
-}
-
 vec3 mappedNormal(vec3 normal_w)
 {
     vec3 sampled_normal = texture(NORMAL_TEXTURE, uv).rgb;
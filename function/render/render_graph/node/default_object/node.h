@@ -1,21 +1,29 @@
 #pragma once
 
+#include "function/render/render_graph/indirect_draw.h"
 #include "function/render/render_graph/render_graph_node.h"
 
 class DefaultObject : public RenderGraphNode {
     struct Param {
         Vk::DescriptorHandle camera;
         Vk::DescriptorHandle lights;
+        Vk::DescriptorHandle objects;
+        Vk::DescriptorHandle instances;
     };
 
     void createRenderPass();
     void createFramebuffer();
-    void createPipeline(Configuration& cfg);
+    void createPipeline();
+    void createPipelineParam();
 
     Pipeline<Param> pipeline;
+    IndirectDraw draws;
     VkRenderPass render_pass;
     std::vector<VkFramebuffer> framebuffers;
     RenderAttachments* attachments;
+    std::string shader_directory;
+    // a DepthPrepass writes the depth, tested for equality here
+    bool depth_prepass = false;
 
 public:
     DefaultObject(
@@ -23,7 +31,12 @@ public:
         const std::string& color_buf_name,
         const std::string& depth_buf_name);
 
+    // frustum culled on the CPU until an OcclusionCulling node takes them over
+    IndirectDraw& objectDraws() { return draws; }
+
     virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
     virtual void record(uint32_t swapchain_index) override;
     virtual void onResize() override;
     virtual void destroy() override;
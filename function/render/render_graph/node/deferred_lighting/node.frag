@@ -0,0 +1,159 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+
+#include "../../shader/common.glsl"
+#include "../../shader/gbuffer.glsl"
+#include "../../shader/light_clusters.glsl"
+#include "../../shader/brdf.glsl"
+
+struct Light {
+    vec3 posOrDir;
+    vec3 intensity;
+};
+
+layout(set = BindlessDescriptorSet, binding = BindlessUniformBinding) uniform Camera
+{
+    mat4 view;
+    mat4 proj;
+    vec3 eye_w;
+    float fov;
+    vec3 view_dir;
+    float aspect_ratio;
+    vec3 up;
+    float focal_distance;
+    int width;
+    int height;
+}
+GetLayoutVariableName(camera)[];
+
+layout(set = BindlessDescriptorSet, binding = BindlessStorageBinding) readonly buffer Lights
+{
+    Light data[];
+}
+GetLayoutVariableName(lights)[];
+
+layout(set = BindlessDescriptorSet, binding = BindlessSamplerBinding)
+    uniform sampler2D GetLayoutVariableName(textures)[];
+
+layout(set = 1, binding = 0) uniform PipelineParam
+{
+    mat4 invViewProj;
+    Handle camera;
+    Handle lights;
+    Handle fire_lights;
+    Handle lightClusters;
+    Handle clusterLights;
+    Handle normal;
+    Handle albedo;
+    Handle depth;
+    uint fire;
+}
+pipelineParam;
+
+#define camera GetResource(camera, pipelineParam.camera)
+#define LIGHTS GetResource(lights, pipelineParam.lights)
+#define FIRE_LIGHTS GetResource(lights, pipelineParam.fire_lights)
+#define CLUSTERS GetResource(lightClusters, pipelineParam.lightClusters)
+#define CLUSTER_LIGHTS GetResource(lightClusterIndices, pipelineParam.clusterLights)
+#define NORMAL_BUFFER GetResource(textures, pipelineParam.normal)
+#define ALBEDO_BUFFER GetResource(textures, pipelineParam.albedo)
+#define DEPTH_BUFFER GetResource(textures, pipelineParam.depth)
+
+layout(location = 0) out vec4 outColor;
+
+struct Surface {
+    vec3 position;
+    vec3 normal;
+    vec3 color;
+    float roughness;
+    float metallic;
+};
+
+// colorOnSingleLight of the forward object passes with the surface read from the G-buffer
+vec3 colorOnSingleLight(Surface surface, Light light)
+{
+    vec3 w_e = normalize(camera.eye_w - surface.position);
+    vec3 w_i = normalize(light.posOrDir - surface.position);
+
+    float dist = length(light.posOrDir - surface.position);
+    vec3 intensity = light.intensity / (dist * dist);
+
+    float dot_w_i_n = dot(surface.normal, w_i);
+    float dot_w_e_n = dot(surface.normal, w_e);
+    if (dot_w_e_n < 0 || dot_w_i_n < 0)
+        return vec3(0);
+
+    vec3 h = normalize(w_i + w_e);
+    vec3 F0 = vec3(0.04);
+    F0 = mix(F0, surface.color, surface.metallic);
+    float k = (surface.roughness + 1);
+    k = k * k / 8;
+
+    float D = D(h, surface.normal, surface.roughness);
+    vec3 F = F(F0, h, w_e);
+    float G = G(w_e, w_i, surface.normal, k);
+    float denominator = 4 * dot(w_e, surface.normal) * dot_w_i_n;
+
+    vec3 specular = intensity * D * F * G / denominator * dot_w_i_n;
+    vec3 diffuse = intensity * surface.color * dot_w_i_n / PI;
+
+    vec3 kd = (1 - F) * (1 - surface.metallic);
+    return kd * diffuse + specular;
+}
+
+// windowed to 0 at the radius LightCulling binned it with
+vec3 colorOnFireLight(Surface surface, Light light)
+{
+    float dist = length(light.posOrDir - surface.position);
+    light.intensity *= clusterLightWindow(dist, clusterLightRadius(light.intensity, CLUSTERS.cutoff));
+    return colorOnSingleLight(surface, light);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(DEPTH_BUFFER, pixel, 0).r;
+    if (depth == 1.0) {
+        outColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    vec2 ndc = gl_FragCoord.xy / vec2(camera.width, camera.height) * 2.0 - 1.0;
+    vec4 position = pipelineParam.invViewProj * vec4(ndc, depth, 1.0);
+    vec4 normal = texelFetch(NORMAL_BUFFER, pixel, 0);
+    vec4 albedo = texelFetch(ALBEDO_BUFFER, pixel, 0);
+
+    Surface surface;
+    surface.position = position.xyz / position.w;
+    surface.normal = decodeGBufferNormal(normal.xy);
+    surface.color = albedo.rgb;
+    surface.roughness = normal.z;
+    surface.metallic = normal.w;
+
+    vec3 color = vec3(0.0f);
+    int lightCount = LIGHTS.data.length();
+    for (int i = 0; i < lightCount; i++) {
+        color += colorOnSingleLight(surface, LIGHTS.data[i]);
+    }
+    if (pipelineParam.fire != 0) {
+        uvec2 tile = uvec2(pixel) / CLUSTERS.tileSize;
+        float viewDepth = -(camera.view * vec4(surface.position, 1.0)).z;
+        uint slice = clusterSlice(viewDepth, CLUSTERS.near, CLUSTERS.far, CLUSTERS.sliceCount);
+        uvec2 range = CLUSTERS.ranges[(slice * CLUSTERS.tilesY + tile.y) * CLUSTERS.tilesX + tile.x];
+        if (range.y == ALL_CLUSTER_LIGHTS) {
+            int fire_light_count = FIRE_LIGHTS.data.length();
+            for (int i = 0; i < fire_light_count; i++) {
+                color += colorOnFireLight(surface, FIRE_LIGHTS.data[i]);
+            }
+        } else {
+            for (uint i = 0; i < range.y; i++) {
+                color += colorOnFireLight(surface, FIRE_LIGHTS.data[CLUSTER_LIGHTS.indices[range.x + i]]);
+            }
+        }
+    }
+
+    color += vec3(0.03) * surface.color * albedo.a;
+
+    outColor = vec4(color, 1.0);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "function/render/render_graph/render_graph_node.h"
+#include <glm/glm.hpp>
+
+// The lighting pass of the deferred path: shades every pixel of the G-buffer once with the Lights and,
+// after setFireLights, the fire lights of its LightCulling cluster. Writes the color the object pass of
+// the forward graphs writes, the volumetric nodes read it and the depth the same way
+class DeferredLighting : public RenderGraphNode {
+    // std140, the matrix first
+    struct Param {
+        glm::mat4 inv_view_proj;
+        Vk::DescriptorHandle camera;
+        Vk::DescriptorHandle lights;
+        Vk::DescriptorHandle fire_lights;
+        Vk::DescriptorHandle light_clusters;
+        Vk::DescriptorHandle cluster_lights;
+        Vk::DescriptorHandle normal;
+        Vk::DescriptorHandle albedo;
+        Vk::DescriptorHandle depth;
+        uint32_t fire;
+    };
+
+    void createRenderPass();
+    void createFramebuffer();
+    void createPipeline();
+    void createPipelineParam();
+
+    Pipeline<Param> pipeline;
+    VkRenderPass render_pass;
+    std::vector<VkFramebuffer> framebuffers;
+    RenderAttachments* attachments;
+    std::string shader_directory;
+
+public:
+    DeferredLighting(
+        const std::string& name,
+        const std::string& normal_buf_name,
+        const std::string& albedo_buf_name,
+        const std::string& depth_buf_name,
+        const std::string& color_buf_name);
+
+    // shades with the fire lights binned by a LightCulling node recorded before this one, call after init
+    void setFireLights(Vk::DescriptorHandle clusters, Vk::DescriptorHandle indices);
+
+    virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
+    virtual void record(uint32_t swapchain_index) override;
+    virtual void onResize() override;
+    virtual void destroy() override;
+};
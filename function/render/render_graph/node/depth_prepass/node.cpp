@@ -0,0 +1,213 @@
+#include "./node.h"
+#include "core/filesystem/file.h"
+#include "core/vulkan/vulkan_util.h"
+#include "function/global_context.h"
+#include "function/render/render_graph/pipeline.hpp"
+#include "function/resource_manager/resource_manager.h"
+
+using namespace Vk;
+
+DepthPrepass::DepthPrepass(const std::string& name, const std::string& depth_buf_name)
+    : RenderGraphNode(name)
+{
+    attachment_descriptions = {
+        {
+            "depth",
+            RenderAttachmentDescription {
+                depth_buf_name,
+                0,
+                RenderAttachmentType::Depth,
+                RenderAttachmentRW::Write,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                VK_FORMAT_D32_SFLOAT,
+                g_ctx.vk.swapChainImages[0]->extent,
+                1,
+            },
+        },
+    };
+}
+
+void DepthPrepass::init(Configuration& cfg, RenderAttachments& attachments)
+{
+    this->attachments = &attachments;
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    shader_directory = rg_cfg.shader_directory;
+    enabled          = rg_cfg.depth_prepass;
+    createRenderPass();
+    createFramebuffer();
+    createPipelineParam();
+}
+
+std::vector<std::function<void()>> DepthPrepass::pipelineTasks()
+{
+    return { [this] { createPipeline(); } };
+}
+
+std::vector<PipelineHandles*> DepthPrepass::pipelines()
+{
+    return { &pipeline };
+}
+
+void DepthPrepass::setDraws(IndirectDraw& draws)
+{
+    this->draws              = &draws;
+    pipeline.param.instances = draws.instanceHandle();
+    pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
+}
+
+void DepthPrepass::createFramebuffer()
+{
+    framebuffers.resize(g_ctx.vk.swapChainImages.size());
+    for (int i = 0; i < g_ctx.vk.swapChainImages.size(); i++) {
+        VkImageView view = attachments->getAttachment(attachment_descriptions["depth"].name).view;
+
+        VkFramebufferCreateInfo framebufferInfo {};
+        framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass      = render_pass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments    = &view;
+        framebufferInfo.width           = g_ctx.vk.swapChainImages[i]->extent.width;
+        framebufferInfo.height          = g_ctx.vk.swapChainImages[i]->extent.height;
+        framebufferInfo.layers          = 1;
+
+        if (vkCreateFramebuffer(g_ctx.vk.device, &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create framebuffer!");
+        }
+    }
+}
+
+void DepthPrepass::createRenderPass()
+{
+    std::vector<AttachmentDescriptionHelper> helpers = {
+        { "depth", VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE },
+    };
+    // the previous frame's depth may still be sampled by the occlusion culling
+    VkSubpassDependency dependency = {};
+    dependency.srcSubpass          = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass          = 0;
+    dependency.srcStageMask        = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependency.dstStageMask        = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.srcAccessMask       = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dstAccessMask       = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    render_pass = DefaultRenderPass(attachment_descriptions, helpers, dependency);
+}
+
+void DepthPrepass::createPipeline()
+{
+    {
+        std::vector<VkDescriptorSetLayout> descLayouts = {
+            g_ctx.dm.BINDLESS_LAYOUT(),
+            g_ctx.dm.PARAMETER_LAYOUT(),
+        };
+        pipeline.initLayout(descLayouts);
+    }
+
+    {
+        VertexInputDefault(true);
+        DynamicStateDefault();
+        ViewportStateDefault();
+        auto inputAssembly = Pipeline<Param>::inputAssemblyDefault();
+        auto rasterization = Pipeline<Param>::rasterizationDefault();
+        auto multisample   = Pipeline<Param>::multisampleDefault();
+
+        auto vertShaderCode   = readFile(shader_directory + "/depth_prepass/node.vert.spv");
+        auto vertShaderModule = g_ctx.pipelines.createShaderModule(vertShaderCode);
+        // depth only, no fragment shader and no color attachment
+        std::vector<VkPipelineShaderStageCreateInfo> shaderStages = {
+            Pipeline<Param>::shaderStageDefault(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT),
+        };
+        VkPipelineDepthStencilStateCreateInfo depthStencil {};
+        depthStencil.sType                 = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable       = VK_TRUE;
+        depthStencil.depthWriteEnable      = VK_TRUE;
+        depthStencil.depthCompareOp        = VK_COMPARE_OP_LESS;
+        depthStencil.depthBoundsTestEnable = VK_FALSE;
+        depthStencil.minDepthBounds        = 0.0f; // Optional
+        depthStencil.maxDepthBounds        = 1.0f; // Optional
+        depthStencil.stencilTestEnable     = VK_FALSE;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo {};
+        pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount          = static_cast<uint32_t>(shaderStages.size());
+        pipelineInfo.pStages             = shaderStages.data();
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pVertexInputState   = &vertexInput;
+        pipelineInfo.pViewportState      = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterization;
+        pipelineInfo.pDepthStencilState  = &depthStencil;
+        pipelineInfo.pMultisampleState   = &multisample;
+        pipelineInfo.pColorBlendState    = nullptr;
+        pipelineInfo.pDynamicState       = &dynamicState;
+        pipelineInfo.layout              = pipeline.layout;
+        pipelineInfo.renderPass          = render_pass;
+        pipelineInfo.subpass             = 0;
+        pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE; // Optional
+        pipelineInfo.basePipelineIndex   = -1; // Optional
+        pipeline.setPipeline(g_ctx.pipelines.getGraphicsPipeline(pipelineInfo, name));
+        g_ctx.pipelines.destroyShaderModule(vertShaderModule);
+    }
+}
+
+void DepthPrepass::createPipelineParam()
+{
+    // the instance table comes with setDraws
+    pipeline.param.camera  = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer.id);
+    pipeline.param.objects = g_ctx.dm.getResourceHandle(g_ctx.rm->object_buffer.buffer.id);
+    pipeline.param_buf     = Buffer::New(
+        g_ctx.vk,
+        sizeof(Param),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
+    g_ctx.dm.registerParameter(pipeline.param_buf);
+}
+
+void DepthPrepass::record(uint32_t swapchain_index)
+{
+    if (!enabled || !draws)
+        return;
+
+    setDefaultViewportAndScissor();
+    // the object pass' update in the same frame reuses this one
+    draws->update();
+
+    VkClearValue clearValue {};
+    clearValue.depthStencil = { 1.0f, 0 };
+    VkRenderPassBeginInfo renderPassInfo {};
+    renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass        = render_pass;
+    renderPassInfo.framebuffer       = framebuffers[swapchain_index];
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = toVkExtent2D(g_ctx.vk.swapChainImages[swapchain_index]->extent);
+    renderPassInfo.clearValueCount   = 1;
+    renderPassInfo.pClearValues      = &clearValue;
+    vkCmdBeginRenderPass(g_ctx.vk.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+    bindDescriptorSet(0, pipeline.layout, g_ctx.dm.BINDLESS_SET());
+    bindDescriptorSet(1, pipeline.layout, g_ctx.dm.getParameterSet(pipeline.param_buf.id));
+    g_ctx.rm->geometry_pool.bind(g_ctx.vk.commandBuffer);
+    draws->draw(g_ctx.vk.commandBuffer);
+
+    vkCmdEndRenderPass(g_ctx.vk.commandBuffer);
+}
+
+void DepthPrepass::onResize()
+{
+    for (auto& framebuffer : framebuffers) {
+        vkDestroyFramebuffer(g_ctx.vk.device, framebuffer, nullptr);
+    }
+    createFramebuffer();
+}
+
+void DepthPrepass::destroy()
+{
+    pipeline.destroy();
+    vkDestroyRenderPass(g_ctx.vk.device, render_pass, nullptr);
+    for (auto& framebuffer : framebuffers) {
+        vkDestroyFramebuffer(g_ctx.vk.device, framebuffer, nullptr);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "function/render/render_graph/indirect_draw.h"
+#include "function/render/render_graph/render_graph_node.h"
+
+// Writes the depth of an object pass's draws before it shades them. With depth_prepass the object
+// pass tests VK_COMPARE_OP_EQUAL against it without writing, so it shades one fragment per pixel.
+// Does nothing without depth_prepass
+class DepthPrepass : public RenderGraphNode {
+    struct Param {
+        Vk::DescriptorHandle camera;
+        Vk::DescriptorHandle objects;
+        Vk::DescriptorHandle instances;
+    };
+
+    void createRenderPass();
+    void createFramebuffer();
+    void createPipeline();
+    void createPipelineParam();
+
+    Pipeline<Param> pipeline;
+    // owned by the object pass, it culls and updates them
+    IndirectDraw* draws = nullptr;
+    bool enabled        = false;
+    VkRenderPass render_pass;
+    std::vector<VkFramebuffer> framebuffers;
+    RenderAttachments* attachments;
+    std::string shader_directory;
+
+public:
+    DepthPrepass(const std::string& name, const std::string& depth_buf_name);
+
+    // the draws of the object pass recorded after this one, call after init
+    void setDraws(IndirectDraw& draws);
+
+    virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
+    virtual void record(uint32_t swapchain_index) override;
+    virtual void onResize() override;
+    virtual void destroy() override;
+};
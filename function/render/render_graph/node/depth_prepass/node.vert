@@ -0,0 +1,42 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+
+#include "../../shader/common.glsl"
+
+layout(set = 0, binding = BindlessUniformBinding) uniform Camera
+{
+    mat4 view;
+    mat4 proj;
+    vec3 eye_w;
+    float fov;
+    vec3 view_dir;
+    float aspect_ratio;
+    vec3 up;
+    float focal_distance;
+    float width;
+    float height;
+}
+camera[];
+
+layout(set = 1, binding = 0) uniform PipelineParam
+{
+    Handle camera;
+    Handle objects;
+    Handle instances;
+}
+pipelineParam;
+
+layout(location = 0) in vec3 inPosition;
+
+// the object pass tests for equal depth, both compute gl_Position the same way
+invariant gl_Position;
+
+#define GetCamera camera[pipelineParam.camera]
+#define GetObject GetObjectParam(pipelineParam.objects, GetInstanceObject(pipelineParam.instances, gl_InstanceIndex))
+
+void main()
+{
+    vec3 position = decodePosition(inPosition, GetObject.positionOffset, GetObject.positionScale);
+    gl_Position = GetCamera.proj * GetCamera.view * GetObject.model * vec4(position, 1.0);
+}
@@ -1,6 +1,5 @@
 #include "./node.h"
 #include "core/filesystem/file.h"
-#include "core/tool/sh.h"
 #include "core/vulkan/vulkan_util.h"
 #include "function/global_context.h"
 #include "function/render/render_graph/pipeline.hpp"
@@ -66,9 +65,33 @@ FireFieldNode::FireFieldNode(const std::string& name,
 void FireFieldNode::init(Configuration& cfg, RenderAttachments& attachments)
 {
     this->attachments = &attachments;
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    shader_directory = rg_cfg.shader_directory;
+
+    // constant ids match the layout(constant_id = N) declarations in node.frag and transmittance.comp
+    JSON_GET(FieldsConfiguration, fields_cfg, cfg, "fields");
+    frag_constants.add(0, static_cast<int32_t>(fields_cfg.arr.size())); // FIELD_COUNT
+    frag_constants.add(1, static_cast<int32_t>(MAX_FIELDS)); // MAX_FIELDS
+    frag_constants.add(2, fields_cfg.fire_configuration.at("self_illumination_boost").get<float>()); // FIRE_SELF_ILLUMINATION_BOOST
+    frag_constants.build();
+
     createRenderPass();
     createFramebuffer();
-    createPipeline(cfg);
+    transmittance.init(shader_directory + "/fire_field/transmittance.comp.spv", fields_cfg.transmittance_resolution);
+    createPipelineParam();
+}
+
+std::vector<std::function<void()>> FireFieldNode::pipelineTasks()
+{
+    return {
+        [this] { createPipeline(); },
+        [this] { transmittance.createPipeline(name + " transmittance", frag_constants.get()); },
+    };
+}
+
+std::vector<PipelineHandles*> FireFieldNode::pipelines()
+{
+    return { &pipeline, transmittance.pipelineHandles() };
 }
 
 void FireFieldNode::createFramebuffer()
@@ -110,7 +133,7 @@ void FireFieldNode::createRenderPass()
     render_pass = DefaultRenderPass(attachment_descriptions, helpers, dependency);
 }
 
-void FireFieldNode::createPipeline(Configuration& cfg)
+void FireFieldNode::createPipeline()
 {
     {
         std::vector<VkDescriptorSetLayout> descLayouts = {
@@ -118,20 +141,7 @@ void FireFieldNode::createPipeline(Configuration& cfg)
             g_ctx.dm.PARAMETER_LAYOUT(),
             g_ctx.dm.PARAMETER_LAYOUT(),
         };
-        VkPushConstantRange pushConstantRange {};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset     = 0;
-        pushConstantRange.size       = sizeof(float);
-
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
-        pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount         = descLayouts.size();
-        pipelineLayoutInfo.pSetLayouts            = descLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1; // Optional
-        pipelineLayoutInfo.pPushConstantRanges    = &pushConstantRange; // Optional
-        if (vkCreatePipelineLayout(g_ctx.vk.device, &pipelineLayoutInfo, nullptr, &pipeline.layout) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create pipeline layout!");
-        }
+        pipeline.initLayout(descLayouts, { { VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(float) } });
     }
 
     {
@@ -142,32 +152,14 @@ void FireFieldNode::createPipeline(Configuration& cfg)
         auto rasterization = Pipeline<Param>::rasterizationDefault();
         auto multisample   = Pipeline<Param>::multisampleDefault();
 
-        JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
-        auto vertShaderCode = readFile(rg_cfg.shader_directory + "/fire_field/node.vert.spv");
+        auto vertShaderCode = readFile(shader_directory + "/fire_field/node.vert.spv");
+        auto fragShaderCode = readFile(shader_directory + "/fire_field/node.frag.spv");
 
-        auto frag_shader_path = std::filesystem::path(cfg.at("engine_directory").get<std::string>()) / "function/render/render_graph/node/fire_field/node.frag";
-        auto filename         = frag_shader_path.filename().string();
-        auto generated_path   = rg_cfg.shader_directory + "/fire_field/generated/" + filename;
-        auto generated_spv    = rg_cfg.shader_directory + "/fire_field/" + (filename + ".spv");
-        if (!std::filesystem::exists(std::filesystem::path(generated_path).parent_path())) {
-            std::filesystem::create_directories(std::filesystem::path(generated_path).parent_path());
-        }
-        JSON_GET(FieldsConfiguration, fields_cfg, cfg, "fields");
-        replaceDefine("FIELD_COUNT", (int)fields_cfg.arr.size(), frag_shader_path, generated_path);
-        replaceDefine("MAX_FIELDS", (int)MAX_FIELDS, generated_path, generated_path);
-        replaceDefine("FIRE_SELF_ILLUMINATION_BOOST",
-                      (int)fields_cfg.fire_configuration.at("self_illumination_boost"), generated_path, generated_path);
-        replaceInclude("../../shader/common.glsl",
-                       "../../common.glsl",
-                       generated_path, generated_path);
-        glslc(generated_path, generated_spv);
-        auto fragShaderCode = readFile(generated_spv);
-
-        auto vertShaderModule                                     = createShaderModule(g_ctx.vk, vertShaderCode);
-        auto fragShaderModule                                     = createShaderModule(g_ctx.vk, fragShaderCode);
+        auto vertShaderModule                                     = g_ctx.pipelines.createShaderModule(vertShaderCode);
+        auto fragShaderModule                                     = g_ctx.pipelines.createShaderModule(fragShaderCode);
         std::vector<VkPipelineShaderStageCreateInfo> shaderStages = {
             Pipeline<Param>::shaderStageDefault(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT),
-            Pipeline<Param>::shaderStageDefault(fragShaderModule, VK_SHADER_STAGE_FRAGMENT_BIT),
+            Pipeline<Param>::shaderStageDefault(fragShaderModule, VK_SHADER_STAGE_FRAGMENT_BIT, frag_constants.get()),
         };
         VkPipelineColorBlendAttachmentState colorBlendAttachment {};
         colorBlendAttachment.colorWriteMask      = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
@@ -208,37 +200,38 @@ void FireFieldNode::createPipeline(Configuration& cfg)
         pipelineInfo.subpass             = 0;
         pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE; // Optional
         pipelineInfo.basePipelineIndex   = -1; // Optional
-        if (vkCreateGraphicsPipelines(g_ctx.vk.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline.pipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create graphics pipeline!");
-        }
-        vkDestroyShaderModule(g_ctx.vk.device, vertShaderModule, nullptr);
-        vkDestroyShaderModule(g_ctx.vk.device, fragShaderModule, nullptr);
+        pipeline.setPipeline(g_ctx.pipelines.getGraphicsPipeline(pipelineInfo, name));
+        g_ctx.pipelines.destroyShaderModule(vertShaderModule);
+        g_ctx.pipelines.destroyShaderModule(fragShaderModule);
     }
+}
 
-    {
-        pipeline.param.camera                   = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer.id);
-        pipeline.param.lights                   = g_ctx.dm.getResourceHandle(g_ctx.rm->lights.buffer.id);
-        pipeline.param.self_illumination_lights = g_ctx.dm.getResourceHandle(
-            g_ctx.rm->fields.self_illumination_lights.buffer.id);
-        pipeline.param.fire_color = g_ctx.dm.getResourceHandle(
-            g_ctx.rm->fields.fire_color_img.id);
-        pipeline.param.previous_color = g_ctx.dm.getResourceHandle(
-            attachments->getAttachment(attachment_descriptions["previous_color"].name).id);
-        pipeline.param.previous_depth = g_ctx.dm.getResourceHandle(
-            attachments->getAttachment(attachment_descriptions["previous_depth"].name).id);
-        pipeline.param_buf = Buffer::New(
-            g_ctx.vk,
-            sizeof(Param),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            true);
-        pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
-        g_ctx.dm.registerParameter(pipeline.param_buf);
-    }
+void FireFieldNode::createPipelineParam()
+{
+    pipeline.param.camera                   = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer.id);
+    pipeline.param.lights                   = g_ctx.dm.getResourceHandle(g_ctx.rm->lights.buffer.id);
+    pipeline.param.self_illumination_lights = g_ctx.dm.getResourceHandle(
+        g_ctx.rm->fields.self_illumination_lights.buffer.id);
+    pipeline.param.fire_color = g_ctx.dm.getResourceHandle(
+        g_ctx.rm->fields.fire_color_img.id);
+    pipeline.param.previous_color = g_ctx.dm.getResourceHandle(
+        attachments->getAttachment(attachment_descriptions["previous_color"].name).id);
+    pipeline.param.previous_depth = g_ctx.dm.getResourceHandle(
+        attachments->getAttachment(attachment_descriptions["previous_depth"].name).id);
+    pipeline.param.transmittance  = transmittance.handle();
+    pipeline.param_buf = Buffer::New(
+        g_ctx.vk,
+        sizeof(Param),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
+    g_ctx.dm.registerParameter(pipeline.param_buf);
 }
 
 void FireFieldNode::record(uint32_t swapchain_index)
 {
+    transmittance.record();
     setDefaultViewportAndScissor();
 
     std::array<VkClearValue, 2> clearValues {};
@@ -284,6 +277,7 @@ void FireFieldNode::onResize()
 void FireFieldNode::destroy()
 {
     pipeline.destroy();
+    transmittance.destroy();
     vkDestroyRenderPass(g_ctx.vk.device, render_pass, nullptr);
     for (auto& framebuffer : framebuffers) {
         vkDestroyFramebuffer(g_ctx.vk.device, framebuffer, nullptr);
@@ -1,12 +1,16 @@
 #version 450
 
-#define FIELD_COUNT 2
-#define MAX_FIELDS 2
-#define FIRE_SELF_ILLUMINATION_BOOST 20.0
-
 #extension GL_GOOGLE_include_directive : enable
 
 #include "../../shader/common.glsl"
+#include "../../shader/bricks.glsl"
+#include "../../shader/light_transmittance.glsl"
+#include "../../shader/macrocells.glsl"
+#include "density.glsl"
+
+layout(constant_id = 0) const int FIELD_COUNT = 2;
+layout(constant_id = 1) const int MAX_FIELDS = 2;
+layout(constant_id = 2) const float FIRE_SELF_ILLUMINATION_BOOST = 20.0;
 
 const float PI = 3.14159265359;
 const float EPSILON = 0.0001;
@@ -14,9 +18,6 @@ const int MAX_LIGHTS = 16;
 const float MAX = 100000000;
 const float MIN = -100000000;
 
-const int TYPE_CONCENTRATION = 0;
-const int TYPE_TEMPERATURE = 1;
-
 struct Light {
     vec3 posOrDir;
     vec3 intensity;
@@ -32,7 +33,12 @@ struct FieldData {
     vec3 scatter;
     int type;
     vec3 absorption;
+    uint macrocell_size;
     AABB aabb;
+    float scale;
+    float bias;
+    uint brick_size;
+    ivec3 dimension;
 };
 
 layout(push_constant) uniform PushConstants
@@ -81,6 +87,8 @@ layout(set = BindlessDescriptorSet, binding = BindlessSamplerBinding)
     uniform sampler2D GetLayoutVariableName(previous_depth)[];
 layout(set = BindlessDescriptorSet, binding = BindlessSamplerBinding)
     uniform sampler2D GetLayoutVariableName(fire_color_sampler)[];
+layout(set = BindlessDescriptorSet, binding = BindlessSamplerBinding)
+    uniform sampler3D GetLayoutVariableName(transmittance_sampler)[];
 
 layout(set = 1, binding = 0) uniform PipelineParam
 {
@@ -90,6 +98,7 @@ layout(set = 1, binding = 0) uniform PipelineParam
     Handle fire_color;
     Handle previous_color;
     Handle previous_depth;
+    Handle transmittance;
 }
 pipelineParam;
 
@@ -97,6 +106,8 @@ layout(set = 2, binding = 0) uniform FieldParam
 {
     Handle attr[MAX_FIELDS];
     Handle img[MAX_FIELDS];
+    Handle macrocells[MAX_FIELDS];
+    Handle bricks[MAX_FIELDS];
 }
 fieldParam;
 
@@ -110,6 +121,7 @@ layout(location = 0) out vec4 outColor;
 #define fire_color_sampler GetResource(fire_color_sampler, pipelineParam.fire_color)
 #define previous_color GetResource(previous_color, pipelineParam.previous_color)
 #define previous_depth GetResource(previous_depth, pipelineParam.previous_depth)
+#define transmittance_sampler GetResource(transmittance_sampler, pipelineParam.transmittance)
 
 float random(float x)
 {
@@ -133,16 +145,26 @@ bool intersect_aabb(vec3 origin, vec3 dir, in AABB aabb, out float tentry, out f
     return tentry <= texit && texit >= 0;
 }
 
-float map_density(float sampled_density, int type)
+// the value of field i at uvw, stored as (value - bias) / scale, see FieldConfiguration::format
+float sample_field(int i, vec3 uvw)
 {
-    // some fields may be sampled outside of the field
-    if (type == TYPE_TEMPERATURE) {
-        return sampled_density * 20;
-    }
-    if (type == TYPE_CONCENTRATION) {
-        return sampled_density * 180;
-    }
-    return 0;
+    uint size = field_data_arr(i).data.brick_size;
+    float value = fieldSample(field_image_sampler(i), fieldParam.bricks[i], size, field_data_arr(i).data.dimension, uvw);
+    return value * field_data_arr(i).data.scale + field_data_arr(i).data.bias;
+}
+
+// how far from t the march meets no density of field i, 0 when its macrocell may hold some. A
+// temperature of zero is taken to emit nothing
+float empty_distance(int i, vec3 local_origin, vec3 local_ray, float t)
+{
+    ivec3 voxels = field_data_arr(i).data.dimension;
+    uint size = field_data_arr(i).data.macrocell_size;
+    vec3 uvw = local_origin + local_ray * t;
+    vec2 range = macrocellRange(fieldParam.macrocells[i], voxels, size, uvw);
+    int type = field_data_arr(i).data.type;
+    if (map_density(range.x, type) != 0.0 || map_density(range.y, type) != 0.0)
+        return 0.0;
+    return macrocellExit(voxels, size, uvw, local_ray);
 }
 
 float phase(const float g, const float cos_theta)
@@ -151,56 +173,21 @@ float phase(const float g, const float cos_theta)
     return 1 / (4 * PI) * (1 - g * g) / (denom * sqrt(denom));
 }
 
-vec3 compute_light_in_scatter_multi(vec3 origin, vec3 ray_eye, Light light)
+// the transmittance towards the light is looked up in the volume LightTransmittance marched
+vec3 compute_light_in_scatter_multi(vec3 origin, vec3 ray_eye, int light_index)
 {
+    Light light = lights.data[light_index];
     vec3 ray = light.posOrDir - origin;
     float ray_length = length(ray);
     ray /= ray_length;
-    float step = in_step * 4;
-
-    float t_entry = MAX, t_exit = MIN;
-    for (int i = 0; i < FIELD_COUNT; i++) {
-        float t_entry_i = 0.0, t_exit_i = 0.0;
-
-        intersect_aabb(origin, ray, field_data_arr(i).data.aabb, t_entry_i, t_exit_i);
-        t_entry = min(t_entry, t_entry_i);
-        t_exit = max(t_exit, t_exit_i);
-    }
-
-    vec3 local_rays[MAX_FIELDS];
-    vec3 local_origins[MAX_FIELDS];
-    for (int i = 0; i < FIELD_COUNT; i++) {
-        local_rays[i] = (field_data_arr(i).data.to_local_uvw * vec4(ray, 0.0)).xyz;
-        local_origins[i] = (field_data_arr(i).data.to_local_uvw * vec4(origin, 1.0)).xyz;
-    }
-    vec3 sigma_ts[MAX_FIELDS];
-    for (int i = 0; i < FIELD_COUNT; i++) {
-        sigma_ts[i] = field_data_arr(i).data.scatter + field_data_arr(i).data.absorption;
-    }
-
-    float t = max(t_entry, 0.0);
-    vec3 transmittance = vec3(1.0f);
-    vec3 sigma_t_density_sum = vec3(0.0);
-    float densities[MAX_FIELDS];
-    vec3 sample_point = vec3(0.0);
-    while (true) {
-        float t_sample = t + random(t) * step;
-        if (t > t_exit)
-            break;
-
-        for (int i = 0; i < FIELD_COUNT; i++) {
-            sample_point = local_origins[i] + local_rays[i] * t_sample;
-            densities[i] = textureLod(field_image_sampler(i), sample_point, 0.0).r;
-            densities[i] = map_density(densities[i], field_data_arr(i).data.type);
-        }
-        for (int i = 0; i < FIELD_COUNT; i++) {
-            sigma_t_density_sum += densities[i] * sigma_ts[i];
-        }
 
-        t += step;
+    AABB box = field_data_arr(0).data.aabb;
+    for (int i = 1; i < FIELD_COUNT; i++) {
+        box.bmin = min(box.bmin, field_data_arr(i).data.aabb.bmin);
+        box.bmax = max(box.bmax, field_data_arr(i).data.aabb.bmax);
     }
+    vec3 transmittance = lightTransmittance(transmittance_sampler, box.bmin, box.bmax, origin, light_index);
 
-    transmittance *= exp(-sigma_t_density_sum * step);
     float dot_ray_light = dot(-ray_eye, ray);
     return light.intensity * transmittance * phase(0.0, dot_ray_light) / (ray_length * ray_length);
 }
@@ -246,10 +233,19 @@ vec3 compute_fire_in_scatter_multi(vec3 origin, vec3 ray_eye, vec3 sample_fire_p
         if (t > t_exit)
             break;
 
+        // the whole steps inside macrocells empty in every field sample nothing
+        float empty = MAX;
+        for (int i = 0; i < FIELD_COUNT; i++)
+            empty = min(empty, empty_distance(i, local_origins[i], local_rays[i], t));
+        if (empty >= step) {
+            t += floor(empty / step) * step;
+            continue;
+        }
+
         vec3 sigma_t_density_sum = vec3(0.0);
         for (int i = 0; i < FIELD_COUNT; i++) {
             sample_point = local_rays[i] * t_sample + local_origins[i];
-            float density = textureLod(field_image_sampler(i), sample_point, 0.0).r;
+            float density = sample_field(i, sample_point);
             float mapped_density = map_density(density, field_data_arr(i).data.type);
             sigma_t_density_sum += mapped_density * (field_data_arr(i).data.scatter + field_data_arr(i).data.absorption);
 
@@ -301,12 +297,21 @@ vec4 volumetric_color_multi(vec3 origin, vec3 ray, float depth, mat4x4 proj_view
         if (t > t_exit || clip_point.z / clip_point.w > depth)
             break;
 
+        // the whole steps inside macrocells empty in every field sample nothing
+        float empty = MAX;
+        for (int i = 0; i < FIELD_COUNT; i++)
+            empty = min(empty, empty_distance(i, local_origins[i], local_rays[i], t));
+        if (empty >= step) {
+            t += floor(empty / step) * step;
+            continue;
+        }
+
         vec3 sigma_t_density_sum = vec3(0.0);
         vec3 sigma_s_density_sum = vec3(0.0);
 
         for (int i = 0; i < FIELD_COUNT; i++) {
             vec3 sample_point = local_origins[i] + local_rays[i] * t_sample;
-            float density = textureLod(field_image_sampler(i), sample_point, 0.0).r;
+            float density = sample_field(i, sample_point);
             float mapped_density = map_density(density, field_data_arr(i).data.type);
             sigma_t_density_sum += mapped_density * (field_data_arr(i).data.scatter + field_data_arr(i).data.absorption);
 
@@ -319,7 +324,7 @@ vec4 volumetric_color_multi(vec3 origin, vec3 ray, float depth, mat4x4 proj_view
         if (length(sigma_s_density_sum) > 1e-3) {
             vec3 light_in_scatter = vec3(0.0);
             for (int i = 0; i < lights.data.length(); i++) {
-                light_in_scatter += compute_light_in_scatter_multi(origin + t_sample * ray, ray, lights.data[i]);
+                light_in_scatter += compute_light_in_scatter_multi(origin + t_sample * ray, ray, i);
             }
             for (int i = 0; i < self_illumination_light_count; i++) {
                 light_in_scatter += compute_fire_in_scatter_multi(origin + t_sample * ray, ray, self_illumination_light.positions[i]);
@@ -4,6 +4,8 @@
 #extension GL_EXT_debug_printf : enable
 
 #include "../../shader/common.glsl"
+#include "../../shader/light_clusters.glsl"
+#include "../../shader/brdf.glsl"
 
 struct Light {
     vec3 posOrDir;
@@ -52,21 +54,19 @@ layout(set = 1, binding = 0) uniform PipelineParam
     Handle camera;
     Handle lights;
     Handle fire_lights;
+    Handle objects;
+    Handle instances;
+    Handle lightClusters;
+    Handle clusterLights;
 }
 pipelineParam;
 
-layout(set = 2, binding = 0) uniform ObjectParam
-{
-    mat4 model;
-    mat4 modelInvTrans;
-    Handle material;
-}
-objectParam;
-
 #define camera GetResource(camera, pipelineParam.camera)
 #define FIRE_LIGHTS GetResource(lights, pipelineParam.fire_lights)
 #define LIGHTS GetResource(lights, pipelineParam.lights)
-#define MATERIAL GetResource(material, objectParam.material)
+#define CLUSTERS GetResource(lightClusters, pipelineParam.lightClusters)
+#define CLUSTER_LIGHTS GetResource(lightClusterIndices, pipelineParam.clusterLights)
+#define MATERIAL GetResource(material, materialHandle)
 #define COLOR_TEXTURE GetResource(textures, MATERIAL.color_texture)
 #define METALLIC_TEXTURE GetResource(textures, MATERIAL.metallic_texture)
 #define ROUGHNESS_TEXTURE GetResource(textures, MATERIAL.roughness_texture)
@@ -77,35 +77,10 @@ layout(location = 0) in vec3 position_w;
 layout(location = 1) in vec3 normal_w;
 layout(location = 2) in vec2 uv;
 layout(location = 3) in vec3 tangent_w;
+layout(location = 4) flat in Handle materialHandle;
 
 layout(location = 0) out vec4 outColor;
 
-const float PI = 3.14159265359;
-
-float D(vec3 h, vec3 normal, float roughness)
-{
-    float numerator = roughness * roughness;
-    float dot_h_n = max(dot(normalize(normal), h), 0.0);
-    float denominator = dot_h_n * dot_h_n * (roughness * roughness - 1) + 1;
-    denominator = PI * denominator * denominator;
-    return numerator / denominator;
-}
-
-vec3 F(vec3 F0, vec3 h, vec3 w_e)
-{
-    return F0 + (1 - F0) * pow(1 - max(dot(w_e, h), 0.0), 5);
-}
-
-float G(vec3 w_e, vec3 w_i, vec3 normal, float k)
-{
-    float dot_w_e_n = dot(w_e, normalize(normal));
-    float g1 = dot_w_e_n / (dot_w_e_n * (1 - k) + k);
-
-    float dot_w_i_n = dot(w_i, normalize(normal));
-    float g2 = dot_w_i_n / (dot_w_i_n * (1 - k) + k);
-    return g1 * g2;
-}
-
 vec3 mappedNormal(vec3 normal_w)
 {
     vec3 sampled_normal = texture(NORMAL_TEXTURE, uv).rgb;
@@ -157,6 +132,14 @@ vec3 colorOnSingleLight(Light light)
     return kd * diffuse + specular;
 }
 
+// windowed to 0 at the radius LightCulling binned it with
+vec3 colorOnFireLight(Light light)
+{
+    float dist = length(light.posOrDir - position_w);
+    light.intensity *= clusterLightWindow(dist, clusterLightRadius(light.intensity, CLUSTERS.cutoff));
+    return colorOnSingleLight(light);
+}
+
 void main()
 {
     vec3 color = vec3(0.0f);
@@ -164,9 +147,19 @@ void main()
     for (int i = 0; i < lightCount; i++) {
         color += colorOnSingleLight(LIGHTS.data[i]);
     }
-    int fire_light_count = FIRE_LIGHTS.data.length();
-    for (int i = 0; i < fire_light_count; i++) {
-        color += colorOnSingleLight(FIRE_LIGHTS.data[i]);
+    uvec2 tile = uvec2(gl_FragCoord.xy) / CLUSTERS.tileSize;
+    float depth = -(camera.view * vec4(position_w, 1.0)).z;
+    uint slice = clusterSlice(depth, CLUSTERS.near, CLUSTERS.far, CLUSTERS.sliceCount);
+    uvec2 range = CLUSTERS.ranges[(slice * CLUSTERS.tilesY + tile.y) * CLUSTERS.tilesX + tile.x];
+    if (range.y == ALL_CLUSTER_LIGHTS) {
+        int fire_light_count = FIRE_LIGHTS.data.length();
+        for (int i = 0; i < fire_light_count; i++) {
+            color += colorOnFireLight(FIRE_LIGHTS.data[i]);
+        }
+    } else {
+        for (uint i = 0; i < range.y; i++) {
+            color += colorOnFireLight(FIRE_LIGHTS.data[CLUSTER_LIGHTS.indices[range.x + i]]);
+        }
     }
 
     vec3 ambient = srgbToLinear(texture(COLOR_TEXTURE, uv).rgb * MATERIAL.color);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "function/render/render_graph/indirect_draw.h"
 #include "function/render/render_graph/render_graph_node.h"
 
 class FireObject : public RenderGraphNode {
@@ -7,16 +8,25 @@ class FireObject : public RenderGraphNode {
         Vk::DescriptorHandle camera;
         Vk::DescriptorHandle lights;
         Vk::DescriptorHandle fire_lights;
+        Vk::DescriptorHandle objects;
+        Vk::DescriptorHandle instances;
+        Vk::DescriptorHandle light_clusters;
+        Vk::DescriptorHandle cluster_lights;
     };
 
     void createRenderPass();
     void createFramebuffer();
-    void createPipeline(Configuration& cfg);
+    void createPipeline();
+    void createPipelineParam();
 
     Pipeline<Param> pipeline;
+    IndirectDraw draws;
     VkRenderPass render_pass;
     std::vector<VkFramebuffer> framebuffers;
     RenderAttachments* attachments;
+    std::string shader_directory;
+    // a DepthPrepass writes the depth, tested for equality here
+    bool depth_prepass = false;
 
 public:
     FireObject(
@@ -24,7 +34,14 @@ public:
         const std::string& color_buf_name,
         const std::string& depth_buf_name);
 
+    // frustum culled on the CPU until an OcclusionCulling node takes them over
+    IndirectDraw& objectDraws() { return draws; }
+    // the fire lights binned by a LightCulling node recorded before this one, call after init
+    void setLightClusters(Vk::DescriptorHandle clusters, Vk::DescriptorHandle indices);
+
     virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
     virtual void record(uint32_t swapchain_index) override;
     virtual void onResize() override;
     virtual void destroy() override;
@@ -22,17 +22,15 @@ camera[];
 layout(set = 1, binding = 0) uniform PipelineParam
 {
     Handle camera;
+    Handle lights;
+    Handle fire_lights;
+    Handle objects;
+    Handle instances;
+    Handle lightClusters;
+    Handle clusterLights;
 }
 pipelineParam;
 
-layout(set = 2, binding = 0) uniform ObjectParam
-{
-    mat4 model;
-    mat4 modelInvTrans;
-    Handle material;
-}
-objectParam;
-
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV;
@@ -42,15 +40,24 @@ layout(location = 0) out vec3 position_w;
 layout(location = 1) out vec3 normal_w;
 layout(location = 2) out vec2 uv;
 layout(location = 3) out vec3 tangent_w;
+layout(location = 4) flat out Handle materialHandle;
+
+// the DepthPrepass must compute the same depth
+invariant gl_Position;
 
 #define GetCamera camera[pipelineParam.camera]
-#define GetObject objectParam
+#define GetObject GetObjectParam(pipelineParam.objects, GetInstanceObject(pipelineParam.instances, gl_InstanceIndex))
 
 void main()
 {
-    gl_Position = GetCamera.proj * GetCamera.view * GetObject.model * vec4(inPosition, 1.0);
-    position_w = (GetObject.model * vec4(inPosition, 1.0)).xyz;
-    normal_w = normalize(mat3(GetObject.modelInvTrans) * inNormal);
+    vec3 position = decodePosition(inPosition, GetObject.positionOffset, GetObject.positionScale);
+    vec3 normal = decodeDirection(inNormal, GetObject.vertexFormat);
+    vec3 tangent = decodeDirection(inTangent, GetObject.vertexFormat);
+
+    gl_Position = GetCamera.proj * GetCamera.view * GetObject.model * vec4(position, 1.0);
+    position_w = (GetObject.model * vec4(position, 1.0)).xyz;
+    normal_w = normalize(mat3(GetObject.modelInvTrans) * normal);
     uv = inUV;
-    tangent_w = normalize(mat3(GetObject.model) * inTangent);
+    tangent_w = normalize(mat3(GetObject.model) * tangent);
+    materialHandle = GetObject.material;
 }
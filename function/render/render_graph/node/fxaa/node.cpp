@@ -50,9 +50,21 @@ FXAANode::FXAANode(
 void FXAANode::init(Configuration& cfg, RenderAttachments& attachments)
 {
     this->attachments = &attachments;
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    shader_directory = rg_cfg.shader_directory;
     createRenderPass();
     createFramebuffer();
-    createPipeline(cfg);
+    createPipelineParam();
+}
+
+std::vector<std::function<void()>> FXAANode::pipelineTasks()
+{
+    return { [this] { createPipeline(); } };
+}
+
+std::vector<PipelineHandles*> FXAANode::pipelines()
+{
+    return { &pipeline };
 }
 
 void FXAANode::createFramebuffer()
@@ -101,7 +113,7 @@ void FXAANode::updateDescriptor()
     pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
 }
 
-void FXAANode::createPipeline(Configuration& cfg)
+void FXAANode::createPipeline()
 {
     {
         std::vector<VkDescriptorSetLayout> descLayouts = {
@@ -119,11 +131,10 @@ void FXAANode::createPipeline(Configuration& cfg)
         auto rasterization = Pipeline<Param>::rasterizationDefault();
         auto multisample   = Pipeline<Param>::multisampleDefault();
 
-        JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
-        auto vertShaderCode                                       = readFile(rg_cfg.shader_directory + "/fxaa/node.vert.spv");
-        auto fragShaderCode                                       = readFile(rg_cfg.shader_directory + "/fxaa/node.frag.spv");
-        auto vertShaderModule                                     = createShaderModule(g_ctx.vk, vertShaderCode);
-        auto fragShaderModule                                     = createShaderModule(g_ctx.vk, fragShaderCode);
+        auto vertShaderCode                                       = readFile(shader_directory + "/fxaa/node.vert.spv");
+        auto fragShaderCode                                       = readFile(shader_directory + "/fxaa/node.frag.spv");
+        auto vertShaderModule                                     = g_ctx.pipelines.createShaderModule(vertShaderCode);
+        auto fragShaderModule                                     = g_ctx.pipelines.createShaderModule(fragShaderCode);
         std::vector<VkPipelineShaderStageCreateInfo> shaderStages = {
             Pipeline<Param>::shaderStageDefault(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT),
             Pipeline<Param>::shaderStageDefault(fragShaderModule, VK_SHADER_STAGE_FRAGMENT_BIT),
@@ -161,26 +172,25 @@ void FXAANode::createPipeline(Configuration& cfg)
         pipelineInfo.subpass             = 0;
         pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE; // Optional
         pipelineInfo.basePipelineIndex   = -1; // Optional
-        if (vkCreateGraphicsPipelines(g_ctx.vk.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline.pipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create graphics pipeline!");
-        }
-        vkDestroyShaderModule(g_ctx.vk.device, vertShaderModule, nullptr);
-        vkDestroyShaderModule(g_ctx.vk.device, fragShaderModule, nullptr);
+        pipeline.setPipeline(g_ctx.pipelines.getGraphicsPipeline(pipelineInfo, name));
+        g_ctx.pipelines.destroyShaderModule(vertShaderModule);
+        g_ctx.pipelines.destroyShaderModule(fragShaderModule);
     }
+}
 
-    {
-        pipeline.param.original_img = g_ctx.dm.getResourceHandle(
-            attachments->getAttachment(attachment_descriptions["original"].name).id);
-        pipeline.param.camera = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer.id);
-        pipeline.param_buf    = Buffer::New(
-            g_ctx.vk,
-            sizeof(Param),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            true);
-        pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
-        g_ctx.dm.registerParameter(pipeline.param_buf);
-    }
+void FXAANode::createPipelineParam()
+{
+    pipeline.param.original_img = g_ctx.dm.getResourceHandle(
+        attachments->getAttachment(attachment_descriptions["original"].name).id);
+    pipeline.param.camera = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer.id);
+    pipeline.param_buf    = Buffer::New(
+        g_ctx.vk,
+        sizeof(Param),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
+    g_ctx.dm.registerParameter(pipeline.param_buf);
 }
 
 void FXAANode::record(uint32_t swapchain_index)
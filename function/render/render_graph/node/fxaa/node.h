@@ -11,12 +11,14 @@ class FXAANode : public RenderGraphNode {
     void createRenderPass();
     void createFramebuffer();
     void updateDescriptor();
-    void createPipeline(Configuration& cfg);
+    void createPipeline();
+    void createPipelineParam();
 
     Pipeline<Param> pipeline;
     VkRenderPass render_pass;
     std::vector<VkFramebuffer> framebuffers;
     RenderAttachments* attachments;
+    std::string shader_directory;
 
 public:
     FXAANode(
@@ -25,6 +27,8 @@ public:
         const std::string& sdr_buf_alpha_illuminance);
 
     virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
     virtual void record(uint32_t swapchain_index) override;
     virtual void onResize() override;
     virtual void destroy() override;
@@ -0,0 +1,256 @@
+#include "./node.h"
+#include "core/filesystem/file.h"
+#include "core/vulkan/vulkan_util.h"
+#include "function/global_context.h"
+#include "function/render/render_graph/pipeline.hpp"
+#include "function/resource_manager/resource_manager.h"
+
+using namespace Vk;
+
+GBuffer::GBuffer(const std::string& name,
+                 const std::string& normal_buf_name,
+                 const std::string& albedo_buf_name,
+                 const std::string& depth_buf_name)
+    : RenderGraphNode(name)
+{
+    attachment_descriptions = {
+        {
+            "normal",
+            {
+                normal_buf_name,
+                0,
+                RenderAttachmentType::Color,
+                RenderAttachmentRW::Write,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                VK_FORMAT_R16G16B16A16_SFLOAT,
+                g_ctx.vk.swapChainImages[0]->extent,
+                1,
+            },
+        },
+        {
+            "albedo",
+            {
+                albedo_buf_name,
+                0,
+                RenderAttachmentType::Color,
+                RenderAttachmentRW::Write,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                VK_FORMAT_R8G8B8A8_SRGB,
+                g_ctx.vk.swapChainImages[0]->extent,
+                1,
+            },
+        },
+        {
+            "depth",
+            RenderAttachmentDescription {
+                depth_buf_name,
+                0,
+                RenderAttachmentType::Depth,
+                RenderAttachmentRW::Write,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                VK_FORMAT_D32_SFLOAT,
+                g_ctx.vk.swapChainImages[0]->extent,
+                1,
+            },
+        }
+    };
+}
+
+void GBuffer::init(Configuration& cfg, RenderAttachments& attachments)
+{
+    this->attachments = &attachments;
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    shader_directory = rg_cfg.shader_directory;
+    createRenderPass();
+    createFramebuffer();
+    // the Param holds the draws' instance table
+    draws.init(nullptr, 1, IndirectDraw::Culling::Frustum);
+    createPipelineParam();
+}
+
+std::vector<std::function<void()>> GBuffer::pipelineTasks()
+{
+    return { [this] { createPipeline(); } };
+}
+
+std::vector<PipelineHandles*> GBuffer::pipelines()
+{
+    return { &pipeline };
+}
+
+void GBuffer::createFramebuffer()
+{
+    framebuffers.resize(g_ctx.vk.swapChainImages.size());
+    for (int i = 0; i < g_ctx.vk.swapChainImages.size(); i++) {
+        std::array<VkImageView, 3> views = {
+            attachments->getAttachment(attachment_descriptions["normal"].name).view,
+            attachments->getAttachment(attachment_descriptions["albedo"].name).view,
+            attachments->getAttachment(attachment_descriptions["depth"].name).view,
+        };
+
+        VkFramebufferCreateInfo framebufferInfo {};
+        framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass      = render_pass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+        framebufferInfo.pAttachments    = views.data();
+        framebufferInfo.width           = g_ctx.vk.swapChainImages[i]->extent.width;
+        framebufferInfo.height          = g_ctx.vk.swapChainImages[i]->extent.height;
+        framebufferInfo.layers          = 1;
+
+        if (vkCreateFramebuffer(g_ctx.vk.device, &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create framebuffer!");
+        }
+    }
+}
+
+void GBuffer::createRenderPass()
+{
+    std::vector<AttachmentDescriptionHelper> helpers = {
+        { "normal", VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE },
+        { "albedo", VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE },
+        { "depth", VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE },
+    };
+    VkSubpassDependency dependency = {};
+    dependency.srcSubpass          = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass          = 0;
+    dependency.srcStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependency.dstStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.srcAccessMask       = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    render_pass = DefaultRenderPass(attachment_descriptions, helpers, dependency);
+}
+
+void GBuffer::createPipeline()
+{
+    {
+        std::vector<VkDescriptorSetLayout> descLayouts = {
+            g_ctx.dm.BINDLESS_LAYOUT(),
+            g_ctx.dm.PARAMETER_LAYOUT(),
+        };
+        pipeline.initLayout(descLayouts);
+    }
+
+    {
+        VertexInputDefault(true);
+        DynamicStateDefault();
+        ViewportStateDefault();
+        auto inputAssembly = Pipeline<Param>::inputAssemblyDefault();
+        auto rasterization = Pipeline<Param>::rasterizationDefault();
+        auto multisample   = Pipeline<Param>::multisampleDefault();
+
+        auto vertShaderCode                                       = readFile(shader_directory + "/gbuffer/node.vert.spv");
+        auto fragShaderCode                                       = readFile(shader_directory + "/gbuffer/node.frag.spv");
+        auto vertShaderModule                                     = g_ctx.pipelines.createShaderModule(vertShaderCode);
+        auto fragShaderModule                                     = g_ctx.pipelines.createShaderModule(fragShaderCode);
+        std::vector<VkPipelineShaderStageCreateInfo> shaderStages = {
+            Pipeline<Param>::shaderStageDefault(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT),
+            Pipeline<Param>::shaderStageDefault(fragShaderModule, VK_SHADER_STAGE_FRAGMENT_BIT),
+        };
+        std::array<VkPipelineColorBlendAttachmentState, 2> colorBlendAttachments {};
+        for (auto& colorBlendAttachment : colorBlendAttachments) {
+            colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+            colorBlendAttachment.blendEnable    = VK_FALSE;
+        }
+        VkPipelineColorBlendStateCreateInfo colorBlending {};
+        colorBlending.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.logicOpEnable   = VK_FALSE;
+        colorBlending.logicOp         = VK_LOGIC_OP_COPY; // Optional
+        colorBlending.attachmentCount = static_cast<uint32_t>(colorBlendAttachments.size());
+        colorBlending.pAttachments    = colorBlendAttachments.data();
+        VkPipelineDepthStencilStateCreateInfo depthStencil {};
+        depthStencil.sType                 = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable       = VK_TRUE;
+        depthStencil.depthWriteEnable      = VK_TRUE;
+        depthStencil.depthCompareOp        = VK_COMPARE_OP_LESS;
+        depthStencil.depthBoundsTestEnable = VK_FALSE;
+        depthStencil.minDepthBounds        = 0.0f; // Optional
+        depthStencil.maxDepthBounds        = 1.0f; // Optional
+        depthStencil.stencilTestEnable     = VK_FALSE;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo {};
+        pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount          = static_cast<uint32_t>(shaderStages.size());
+        pipelineInfo.pStages             = shaderStages.data();
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pVertexInputState   = &vertexInput;
+        pipelineInfo.pViewportState      = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterization;
+        pipelineInfo.pDepthStencilState  = &depthStencil;
+        pipelineInfo.pMultisampleState   = &multisample;
+        pipelineInfo.pColorBlendState    = &colorBlending;
+        pipelineInfo.pDynamicState       = &dynamicState;
+        pipelineInfo.layout              = pipeline.layout;
+        pipelineInfo.renderPass          = render_pass;
+        pipelineInfo.subpass             = 0;
+        pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE; // Optional
+        pipelineInfo.basePipelineIndex   = -1; // Optional
+        pipeline.setPipeline(g_ctx.pipelines.getGraphicsPipeline(pipelineInfo, name));
+        g_ctx.pipelines.destroyShaderModule(vertShaderModule);
+        g_ctx.pipelines.destroyShaderModule(fragShaderModule);
+    }
+}
+
+void GBuffer::createPipelineParam()
+{
+    pipeline.param.camera    = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer.id);
+    pipeline.param.objects   = g_ctx.dm.getResourceHandle(g_ctx.rm->object_buffer.buffer.id);
+    pipeline.param.instances = draws.instanceHandle();
+    pipeline.param_buf       = Buffer::New(
+        g_ctx.vk,
+        sizeof(Param),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
+    g_ctx.dm.registerParameter(pipeline.param_buf);
+}
+
+void GBuffer::record(uint32_t swapchain_index)
+{
+    setDefaultViewportAndScissor();
+    draws.update();
+
+    std::array<VkClearValue, 3> clearValues {};
+    clearValues[0].color        = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+    clearValues[1].color        = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+    clearValues[2].depthStencil = { 1.0f, 0 };
+    VkRenderPassBeginInfo renderPassInfo {};
+    renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass        = render_pass;
+    renderPassInfo.framebuffer       = framebuffers[swapchain_index];
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = toVkExtent2D(g_ctx.vk.swapChainImages[swapchain_index]->extent);
+    renderPassInfo.clearValueCount   = clearValues.size();
+    renderPassInfo.pClearValues      = clearValues.data();
+    vkCmdBeginRenderPass(g_ctx.vk.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+    bindDescriptorSet(0, pipeline.layout, g_ctx.dm.BINDLESS_SET());
+    bindDescriptorSet(1, pipeline.layout, g_ctx.dm.getParameterSet(pipeline.param_buf.id));
+    g_ctx.rm->geometry_pool.bind(g_ctx.vk.commandBuffer);
+    draws.draw(g_ctx.vk.commandBuffer);
+
+    vkCmdEndRenderPass(g_ctx.vk.commandBuffer);
+}
+
+void GBuffer::onResize()
+{
+    for (auto& framebuffer : framebuffers) {
+        vkDestroyFramebuffer(g_ctx.vk.device, framebuffer, nullptr);
+    }
+    createFramebuffer();
+}
+
+void GBuffer::destroy()
+{
+    pipeline.destroy();
+    draws.destroy();
+    vkDestroyRenderPass(g_ctx.vk.device, render_pass, nullptr);
+    for (auto& framebuffer : framebuffers) {
+        vkDestroyFramebuffer(g_ctx.vk.device, framebuffer, nullptr);
+    }
+}
@@ -0,0 +1,61 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+
+#include "../../shader/common.glsl"
+#include "../../shader/gbuffer.glsl"
+
+layout(set = 0, binding = BindlessUniformBinding) uniform Material
+{
+    vec3 color;
+    float roughness;
+    float metallic;
+    Handle color_texture;
+    Handle metallic_texture;
+    Handle roughness_texture;
+    Handle normal_texture;
+    Handle ao_texture;
+}
+GetLayoutVariableName(material)[];
+
+layout(set = BindlessDescriptorSet, binding = BindlessSamplerBinding)
+    uniform sampler2D GetLayoutVariableName(textures)[];
+
+#define MATERIAL GetResource(material, materialHandle)
+#define COLOR_TEXTURE GetResource(textures, MATERIAL.color_texture)
+#define METALLIC_TEXTURE GetResource(textures, MATERIAL.metallic_texture)
+#define ROUGHNESS_TEXTURE GetResource(textures, MATERIAL.roughness_texture)
+#define NORMAL_TEXTURE GetResource(textures, MATERIAL.normal_texture)
+#define AO_TEXTURE GetResource(textures, MATERIAL.ao_texture)
+
+layout(location = 0) in vec3 position_w;
+layout(location = 1) in vec3 normal_w;
+layout(location = 2) in vec2 uv;
+layout(location = 3) in vec3 tangent_w;
+layout(location = 4) flat in Handle materialHandle;
+
+layout(location = 0) out vec4 outNormal;
+layout(location = 1) out vec4 outAlbedo;
+
+vec3 mappedNormal(vec3 normal_w)
+{
+    vec3 sampled_normal = texture(NORMAL_TEXTURE, uv).rgb;
+    vec3 normal_t = 2 * sampled_normal - vec3(1.0f);
+
+    vec3 normal = normalize(normal_w);
+    vec3 tangent = normalize(tangent_w - dot(tangent_w, normal) * normal);
+    vec3 bitangent = cross(normal, tangent);
+
+    mat3 tbn = mat3(tangent, -bitangent, normal);
+    return normalize(tbn * normal_t);
+}
+
+void main()
+{
+    float roughness = texture(ROUGHNESS_TEXTURE, uv).r * MATERIAL.roughness;
+    float metallic = texture(METALLIC_TEXTURE, uv).r * MATERIAL.metallic;
+    outNormal = vec4(encodeGBufferNormal(mappedNormal(normal_w)), roughness, metallic);
+
+    vec3 color = srgbToLinear(texture(COLOR_TEXTURE, uv).rgb * MATERIAL.color);
+    outAlbedo = vec4(color, texture(AO_TEXTURE, uv).r);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "function/render/render_graph/indirect_draw.h"
+#include "function/render/render_graph/render_graph_node.h"
+
+// The geometry pass of the deferred path: writes the surface of every object to the G-buffer described
+// in gbuffer.glsl without lighting it, DeferredLighting shades every pixel once
+class GBuffer : public RenderGraphNode {
+    struct Param {
+        Vk::DescriptorHandle camera;
+        Vk::DescriptorHandle objects;
+        Vk::DescriptorHandle instances;
+    };
+
+    void createRenderPass();
+    void createFramebuffer();
+    void createPipeline();
+    void createPipelineParam();
+
+    Pipeline<Param> pipeline;
+    IndirectDraw draws;
+    VkRenderPass render_pass;
+    std::vector<VkFramebuffer> framebuffers;
+    RenderAttachments* attachments;
+    std::string shader_directory;
+
+public:
+    GBuffer(
+        const std::string& name,
+        const std::string& normal_buf_name,
+        const std::string& albedo_buf_name,
+        const std::string& depth_buf_name);
+
+    // frustum culled on the CPU until an OcclusionCulling node takes them over
+    IndirectDraw& objectDraws() { return draws; }
+
+    virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
+    virtual void record(uint32_t swapchain_index) override;
+    virtual void onResize() override;
+    virtual void destroy() override;
+};
@@ -45,9 +45,21 @@ HDRToSDR::HDRToSDR(const std::string& name, const std::string& hdr_buf, const st
 void HDRToSDR::init(Configuration& cfg, RenderAttachments& attachments)
 {
     this->attachments = &attachments;
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    shader_directory = rg_cfg.shader_directory;
     createRenderPass();
     createFramebuffer();
-    createPipeline(cfg);
+    createPipelineParam();
+}
+
+std::vector<std::function<void()>> HDRToSDR::pipelineTasks()
+{
+    return { [this] { createPipeline(); } };
+}
+
+std::vector<PipelineHandles*> HDRToSDR::pipelines()
+{
+    return { &pipeline };
 }
 
 void HDRToSDR::createFramebuffer()
@@ -95,7 +107,7 @@ void HDRToSDR::updateDescriptor() {
     pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
 }
 
-void HDRToSDR::createPipeline(Configuration& cfg)
+void HDRToSDR::createPipeline()
 {
     {
         std::vector<VkDescriptorSetLayout> descLayouts = {
@@ -113,11 +125,10 @@ void HDRToSDR::createPipeline(Configuration& cfg)
         auto rasterization = Pipeline<Param>::rasterizationDefault();
         auto multisample   = Pipeline<Param>::multisampleDefault();
 
-        JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
-        auto vertShaderCode                                       = readFile(rg_cfg.shader_directory + "/hdr_to_sdr/node.vert.spv");
-        auto fragShaderCode                                       = readFile(rg_cfg.shader_directory + "/hdr_to_sdr/node.frag.spv");
-        auto vertShaderModule                                     = createShaderModule(g_ctx.vk, vertShaderCode);
-        auto fragShaderModule                                     = createShaderModule(g_ctx.vk, fragShaderCode);
+        auto vertShaderCode                                       = readFile(shader_directory + "/hdr_to_sdr/node.vert.spv");
+        auto fragShaderCode                                       = readFile(shader_directory + "/hdr_to_sdr/node.frag.spv");
+        auto vertShaderModule                                     = g_ctx.pipelines.createShaderModule(vertShaderCode);
+        auto fragShaderModule                                     = g_ctx.pipelines.createShaderModule(fragShaderCode);
         std::vector<VkPipelineShaderStageCreateInfo> shaderStages = {
             Pipeline<Param>::shaderStageDefault(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT),
             Pipeline<Param>::shaderStageDefault(fragShaderModule, VK_SHADER_STAGE_FRAGMENT_BIT),
@@ -155,25 +166,24 @@ void HDRToSDR::createPipeline(Configuration& cfg)
         pipelineInfo.subpass             = 0;
         pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE; // Optional
         pipelineInfo.basePipelineIndex   = -1; // Optional
-        if (vkCreateGraphicsPipelines(g_ctx.vk.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline.pipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create graphics pipeline!");
-        }
-        vkDestroyShaderModule(g_ctx.vk.device, vertShaderModule, nullptr);
-        vkDestroyShaderModule(g_ctx.vk.device, fragShaderModule, nullptr);
+        pipeline.setPipeline(g_ctx.pipelines.getGraphicsPipeline(pipelineInfo, name));
+        g_ctx.pipelines.destroyShaderModule(vertShaderModule);
+        g_ctx.pipelines.destroyShaderModule(fragShaderModule);
     }
+}
 
-    {
-        pipeline.param.hdr_img = g_ctx.dm.getResourceHandle(
-            attachments->getAttachment(attachment_descriptions["hdr"].name).id);
-        pipeline.param_buf = Buffer::New(
-            g_ctx.vk,
-            sizeof(Param),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            true);
-        pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
-        g_ctx.dm.registerParameter(pipeline.param_buf);
-    }
+void HDRToSDR::createPipelineParam()
+{
+    pipeline.param.hdr_img = g_ctx.dm.getResourceHandle(
+        attachments->getAttachment(attachment_descriptions["hdr"].name).id);
+    pipeline.param_buf = Buffer::New(
+        g_ctx.vk,
+        sizeof(Param),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
+    g_ctx.dm.registerParameter(pipeline.param_buf);
 }
 
 void HDRToSDR::record(uint32_t swapchain_index)
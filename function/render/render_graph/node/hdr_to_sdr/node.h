@@ -10,12 +10,14 @@ class HDRToSDR : public RenderGraphNode {
     void createRenderPass();
     void createFramebuffer();
     void updateDescriptor();
-    void createPipeline(Configuration& cfg);
+    void createPipeline();
+    void createPipelineParam();
 
     Pipeline<Param> pipeline;
     VkRenderPass render_pass;
     std::vector<VkFramebuffer> framebuffers;
     RenderAttachments* attachments;
+    std::string shader_directory;
 
 public:
     HDRToSDR(
@@ -24,6 +26,8 @@ public:
         const std::string& sdr_buf);
 
     virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
     virtual void record(uint32_t swapchain_index) override;
     virtual void onResize() override;
     virtual void destroy() override;
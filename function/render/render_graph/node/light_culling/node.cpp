@@ -0,0 +1,165 @@
+#include "./node.h"
+#include "core/filesystem/file.h"
+#include "core/vulkan/vulkan_util.h"
+#include "function/global_context.h"
+#include "function/render/render_graph/pipeline.hpp"
+#include "function/resource_manager/resource_manager.h"
+#include <algorithm>
+
+using namespace Vk;
+
+LightCulling::LightCulling(const std::string& name)
+    : RenderGraphNode(name)
+{
+}
+
+void LightCulling::init(Configuration& cfg, RenderAttachments& attachments)
+{
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    shader_directory = rg_cfg.shader_directory;
+
+    json light_culling_json = cfg["light_culling"];
+    if (!light_culling_json.is_null()) {
+        config = light_culling_json.get<LightCullingConfiguration>();
+    }
+    if (config.tile_size == 0 || config.slices == 0 || config.cutoff <= 0.0f)
+        throw std::runtime_error("light_culling needs a positive tile_size, slices and cutoff");
+    createClusters();
+    createPipelineParam();
+}
+
+std::vector<std::function<void()>> LightCulling::pipelineTasks()
+{
+    return { [this] { createPipeline(); } };
+}
+
+std::vector<PipelineHandles*> LightCulling::pipelines()
+{
+    return { &pipeline };
+}
+
+DescriptorHandle LightCulling::clusterHandle() const
+{
+    return g_ctx.dm.getResourceHandle(clusters.id);
+}
+
+DescriptorHandle LightCulling::indexHandle() const
+{
+    return g_ctx.dm.getResourceHandle(indices.id);
+}
+
+void LightCulling::createClusters()
+{
+    const auto& extent         = g_ctx.vk.swapChainImages[0]->extent;
+    pipeline.param.tile_size   = config.tile_size;
+    pipeline.param.tiles_x     = (extent.width + config.tile_size - 1) / config.tile_size;
+    pipeline.param.tiles_y     = (extent.height + config.tile_size - 1) / config.tile_size;
+    pipeline.param.slice_count = config.slices;
+    pipeline.param.cutoff      = config.cutoff;
+    cluster_count              = pipeline.param.tiles_x * pipeline.param.tiles_y * config.slices;
+    const uint32_t lights      = static_cast<uint32_t>(g_ctx.rm->fields.lights.data.size());
+    pipeline.param.capacity    = std::max(cluster_count * std::min(lights, AVERAGE_CLUSTER_LIGHTS), 1u);
+
+    // keeps the ids, the shading pass' Param holds them
+    auto replace = [](Buffer& buffer, VkDeviceSize size) {
+        Buffer old = buffer;
+        buffer     = Buffer::New(
+            g_ctx.vk,
+            size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (old.size > 0) {
+            buffer.id = old.id;
+            g_ctx.dm.updateResourceRegistration(buffer);
+            Buffer::Delete(g_ctx.vk, old);
+        } else {
+            g_ctx.dm.registerResource(buffer, DescriptorType::Storage);
+        }
+    };
+    replace(clusters, HEADER_SIZE + cluster_count * 2 * sizeof(uint32_t));
+    replace(indices, pipeline.param.capacity * sizeof(uint32_t));
+    replace(counter, sizeof(uint32_t));
+}
+
+void LightCulling::createPipeline()
+{
+    std::vector<VkDescriptorSetLayout> descLayouts = {
+        g_ctx.dm.BINDLESS_LAYOUT(),
+        g_ctx.dm.PARAMETER_LAYOUT(),
+    };
+    pipeline.initLayout(descLayouts);
+
+    auto shaderCode   = readFile(shader_directory + "/light_culling/node.comp.spv");
+    auto shaderModule = g_ctx.pipelines.createShaderModule(shaderCode);
+
+    VkComputePipelineCreateInfo pipelineInfo {};
+    pipelineInfo.sType              = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage              = Pipeline<Param>::shaderStageDefault(shaderModule, VK_SHADER_STAGE_COMPUTE_BIT);
+    pipelineInfo.layout             = pipeline.layout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+    pipelineInfo.basePipelineIndex  = -1; // Optional
+    pipeline.setPipeline(g_ctx.pipelines.getComputePipeline(pipelineInfo, name));
+    g_ctx.pipelines.destroyShaderModule(shaderModule);
+}
+
+void LightCulling::createPipelineParam()
+{
+    pipeline.param.camera   = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer.id);
+    pipeline.param.lights   = g_ctx.dm.getResourceHandle(g_ctx.rm->fields.lights.buffer.id);
+    pipeline.param.clusters = g_ctx.dm.getResourceHandle(clusters.id);
+    pipeline.param.indices  = g_ctx.dm.getResourceHandle(indices.id);
+    pipeline.param.counter  = g_ctx.dm.getResourceHandle(counter.id);
+    pipeline.param_buf      = Buffer::New(
+        g_ctx.vk,
+        sizeof(Param),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    g_ctx.dm.registerParameter(pipeline.param_buf);
+    // near and far follow the projection, written by every record
+}
+
+void LightCulling::record(uint32_t swapchain_index)
+{
+    // glm::perspective with GLM_FORCE_DEPTH_ZERO_TO_ONE
+    const auto& proj     = g_ctx.rm->camera.data.proj;
+    pipeline.param.near  = proj[3][2] / proj[2][2];
+    pipeline.param.far   = proj[3][2] / (proj[2][2] + 1.0f);
+    pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
+
+    counter.Clear(g_ctx.vk);
+    counter.Barrier(
+        g_ctx.vk,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+    bindDescriptorSet(0, pipeline.layout, g_ctx.dm.BINDLESS_SET(), VK_PIPELINE_BIND_POINT_COMPUTE);
+    bindDescriptorSet(1, pipeline.layout, g_ctx.dm.getParameterSet(pipeline.param_buf.id), VK_PIPELINE_BIND_POINT_COMPUTE);
+    vkCmdDispatch(g_ctx.vk.commandBuffer, (cluster_count + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+    for (const auto* buffer : { &clusters, &indices }) {
+        buffer->Barrier(
+            g_ctx.vk,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT);
+    }
+}
+
+void LightCulling::onResize()
+{
+    createClusters();
+}
+
+void LightCulling::destroy()
+{
+    pipeline.destroy();
+    for (auto* buffer : { &clusters, &indices, &counter }) {
+        g_ctx.dm.removeResourceRegistration(buffer->id);
+        Buffer::Delete(g_ctx.vk, *buffer);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "function/render/render_graph/render_graph_node.h"
+
+// Bins the fire lights into view space clusters every frame, see light_clusters.glsl. A light reaches
+// as far as its intensity falls to light_culling.cutoff, the FireObject pass shades a fragment with the
+// lights of its cluster only
+class LightCulling : public RenderGraphNode {
+    // std140
+    struct Param {
+        Vk::DescriptorHandle camera;
+        Vk::DescriptorHandle lights;
+        Vk::DescriptorHandle clusters;
+        Vk::DescriptorHandle indices;
+        Vk::DescriptorHandle counter;
+        uint32_t tile_size;
+        uint32_t tiles_x;
+        uint32_t tiles_y;
+        uint32_t slice_count;
+        float near;
+        float far;
+        uint32_t capacity;
+        float cutoff;
+    };
+
+    void createClusters();
+    void createPipeline();
+    void createPipelineParam();
+
+    Pipeline<Param> pipeline;
+    LightCullingConfiguration config;
+    std::string shader_directory;
+
+    // the grid header and the index range of every cluster, then the fire light indices
+    Vk::Buffer clusters;
+    Vk::Buffer indices;
+    Vk::Buffer counter;
+    uint32_t cluster_count = 0;
+
+    static constexpr uint32_t GROUP_SIZE = 64;
+    // index list capacity per cluster on average, a cluster past it is shaded with every light
+    static constexpr uint32_t AVERAGE_CLUSTER_LIGHTS = 32;
+    // LightClusters in light_clusters.glsl before its ranges
+    static constexpr uint32_t HEADER_SIZE = 32;
+
+public:
+    LightCulling(const std::string& name);
+
+    // the buffers for the shading pass' Param, the same across resizes
+    Vk::DescriptorHandle clusterHandle() const;
+    Vk::DescriptorHandle indexHandle() const;
+
+    virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
+    virtual void record(uint32_t swapchain_index) override;
+    virtual void onResize() override;
+    virtual void destroy() override;
+};
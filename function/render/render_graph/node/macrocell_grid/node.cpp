@@ -0,0 +1,90 @@
+#include "./node.h"
+#include "core/filesystem/file.h"
+#include "core/vulkan/vulkan_util.h"
+#include "function/global_context.h"
+#include "function/render/render_graph/pipeline.hpp"
+#include "function/resource_manager/resource_manager.h"
+
+using namespace Vk;
+
+MacrocellGrid::MacrocellGrid(const std::string& name)
+    : RenderGraphNode(name)
+{
+}
+
+void MacrocellGrid::init(Configuration& cfg, RenderAttachments& attachments)
+{
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    shader_directory = rg_cfg.shader_directory;
+}
+
+std::vector<std::function<void()>> MacrocellGrid::pipelineTasks()
+{
+    return { [this] { createPipeline(); } };
+}
+
+std::vector<PipelineHandles*> MacrocellGrid::pipelines()
+{
+    return { &pipeline };
+}
+
+void MacrocellGrid::createPipeline()
+{
+    std::vector<VkDescriptorSetLayout> descLayouts = {
+        g_ctx.dm.BINDLESS_LAYOUT(),
+    };
+    pipeline.initLayout(descLayouts, { { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Param) } });
+
+    auto shaderCode   = readFile(shader_directory + "/macrocell_grid/node.comp.spv");
+    auto shaderModule = g_ctx.pipelines.createShaderModule(shaderCode);
+
+    VkComputePipelineCreateInfo pipelineInfo {};
+    pipelineInfo.sType              = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage              = Pipeline<Param>::shaderStageDefault(shaderModule, VK_SHADER_STAGE_COMPUTE_BIT);
+    pipelineInfo.layout             = pipeline.layout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+    pipelineInfo.basePipelineIndex  = -1; // Optional
+    pipeline.setPipeline(g_ctx.pipelines.getComputePipeline(pipelineInfo, name));
+    g_ctx.pipelines.destroyShaderModule(shaderModule);
+}
+
+void MacrocellGrid::record(uint32_t swapchain_index)
+{
+    vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+    bindDescriptorSet(0, pipeline.layout, g_ctx.dm.BINDLESS_SET(), VK_PIPELINE_BIND_POINT_COMPUTE);
+
+    for (const auto& field : g_ctx.rm->fields.fields) {
+        const uint32_t size = field.data.macrocell_size;
+        const glm::uvec3 groups
+            = (glm::uvec3((field.dimension + static_cast<int>(size) - 1) / static_cast<int>(size)) + GROUP_SIZE - 1u) / GROUP_SIZE;
+        pipeline.param = Param {
+            .voxels     = field.dimension,
+            .field      = g_ctx.dm.getResourceHandle(field.field_img.id),
+            .cells      = g_ctx.dm.getResourceHandle(field.macrocells.id),
+            .bricks     = field.data.brick_size > 0 ? g_ctx.dm.getResourceHandle(field.bricks.id) : DescriptorHandle {},
+            .size       = size,
+            .brick_size = field.data.brick_size,
+            .scale      = field.data.scale,
+            .bias       = field.data.bias,
+        };
+        vkCmdPushConstants(g_ctx.vk.commandBuffer, pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Param), &pipeline.param);
+        vkCmdDispatch(g_ctx.vk.commandBuffer, groups.x, groups.y, groups.z);
+
+        field.macrocells.Barrier(
+            g_ctx.vk,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT);
+    }
+}
+
+void MacrocellGrid::onResize()
+{
+    // the grids follow the fields, not the swapchain
+}
+
+void MacrocellGrid::destroy()
+{
+    pipeline.destroy();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "function/render/render_graph/render_graph_node.h"
+
+// Builds the macrocell grid of every field, see macrocells.glsl, for the field passes to skip empty
+// space with. The fields are written behind the renderer's back (by CUDA), so the grids are rebuilt
+// every frame, reading every voxel about once where the marches read them many times per pixel
+class MacrocellGrid : public RenderGraphNode {
+    // the push constants of a field's dispatch
+    struct Param {
+        glm::ivec3 voxels;
+        Vk::DescriptorHandle field;
+        Vk::DescriptorHandle cells;
+        Vk::DescriptorHandle bricks;
+        uint32_t size;
+        uint32_t brick_size;
+        // the field's decoding, see FieldData
+        float scale;
+        float bias;
+    };
+
+    void createPipeline();
+
+    Pipeline<Param> pipeline;
+    std::string shader_directory;
+
+    static constexpr uint32_t GROUP_SIZE = 4;
+
+public:
+    MacrocellGrid(const std::string& name);
+
+    virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
+    virtual void record(uint32_t swapchain_index) override;
+    virtual void onResize() override;
+    virtual void destroy() override;
+};
@@ -1,9 +1,15 @@
 #include "./calculate_luminance/node.h"
 #include "./default_object/node.h"
+#include "./deferred_lighting/node.h"
+#include "./depth_prepass/node.h"
 #include "./fire_field/node.h"
 #include "./fire_object/node.h"
 #include "./fxaa/node.h"
+#include "./gbuffer/node.h"
 #include "./hdr_to_sdr/node.h"
+#include "./light_culling/node.h"
+#include "./macrocell_grid/node.h"
+#include "./occlusion_culling/node.h"
 #include "./recorder/node.h"
 #include "./smoke_field/node.h"
 #include "./ui/node.h"
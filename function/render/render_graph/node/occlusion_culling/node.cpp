@@ -0,0 +1,277 @@
+#include "./node.h"
+#include "core/filesystem/file.h"
+#include "core/vulkan/vulkan_util.h"
+#include "function/global_context.h"
+#include "function/render/render_graph/pipeline.hpp"
+#include "function/resource_manager/resource_manager.h"
+#include "function/tool/frustum.h"
+
+using namespace Vk;
+
+OcclusionCulling::OcclusionCulling(const std::string& name, const std::string& depth_buf_name)
+    : RenderGraphNode(name)
+{
+    attachment_descriptions = {
+        {
+            "depth",
+            RenderAttachmentDescription {
+                depth_buf_name,
+                0,
+                RenderAttachmentType::Depth | RenderAttachmentType::Sampler,
+                RenderAttachmentRW::Read,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                VK_FORMAT_D32_SFLOAT,
+                g_ctx.vk.swapChainImages[0]->extent,
+                1,
+            },
+        },
+    };
+}
+
+void OcclusionCulling::init(Configuration& cfg, RenderAttachments& attachments)
+{
+    this->attachments = &attachments;
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    shader_directory = rg_cfg.shader_directory;
+    enabled          = rg_cfg.occlusion_culling;
+    createPyramid();
+    createPipelineParam();
+}
+
+std::vector<std::function<void()>> OcclusionCulling::pipelineTasks()
+{
+    return { [this] { createPipeline(); } };
+}
+
+std::vector<PipelineHandles*> OcclusionCulling::pipelines()
+{
+    return { &hiz_pipeline, &cull_pipeline };
+}
+
+void OcclusionCulling::addDraws(IndirectDraw& draws)
+{
+    if (!enabled)
+        return;
+    draws.setCulling(IndirectDraw::Culling::Occlusion);
+    draw_lists.emplace_back(&draws);
+}
+
+void OcclusionCulling::createPyramid()
+{
+    const auto& extent = attachments->getAttachment(attachment_descriptions["depth"].name).extent;
+    size_t size        = 0;
+    levels             = 0;
+    for (uint32_t width = extent.width, height = extent.height;; levels++) {
+        width  = (width + 1) / 2;
+        height = (height + 1) / 2;
+        size += width * height;
+        if (width == 1 && height == 1) {
+            levels++;
+            break;
+        }
+    }
+
+    Buffer old = pyramid;
+    pyramid    = Buffer::New(
+        g_ctx.vk,
+        size * sizeof(float),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (old.size > 0) {
+        pyramid.id = old.id;
+        g_ctx.dm.updateResourceRegistration(pyramid);
+        Buffer::Delete(g_ctx.vk, old);
+    } else {
+        g_ctx.dm.registerResource(pyramid, DescriptorType::Storage);
+    }
+    pyramid_valid = false;
+}
+
+void OcclusionCulling::updateDescriptor()
+{
+    const auto& depth          = attachments->getAttachment(attachment_descriptions["depth"].name);
+    hiz_pipeline.param.depth   = g_ctx.dm.getResourceHandle(depth.id);
+    hiz_pipeline.param.pyramid = g_ctx.dm.getResourceHandle(pyramid.id);
+    hiz_pipeline.param.width   = depth.extent.width;
+    hiz_pipeline.param.height  = depth.extent.height;
+    hiz_pipeline.param_buf.Update(g_ctx.vk, &hiz_pipeline.param, sizeof(HiZParam));
+
+    cull_pipeline.param.bounds  = g_ctx.dm.getResourceHandle(g_ctx.rm->object_buffer.bounds.id);
+    cull_pipeline.param.pyramid = hiz_pipeline.param.pyramid;
+    cull_pipeline.param.width   = depth.extent.width;
+    cull_pipeline.param.height  = depth.extent.height;
+    cull_pipeline.param.levels  = levels;
+}
+
+void OcclusionCulling::createPipeline()
+{
+    std::vector<VkDescriptorSetLayout> descLayouts = {
+        g_ctx.dm.BINDLESS_LAYOUT(),
+        g_ctx.dm.PARAMETER_LAYOUT(),
+    };
+    hiz_pipeline.initLayout(descLayouts, { { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HiZPush) } });
+    cull_pipeline.initLayout(descLayouts, { { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPush) } });
+
+    auto build = [&](PipelineHandles& handles, const std::string& shader) {
+        auto shaderCode   = readFile(shader_directory + "/occlusion_culling/" + shader + ".comp.spv");
+        auto shaderModule = g_ctx.pipelines.createShaderModule(shaderCode);
+
+        VkComputePipelineCreateInfo pipelineInfo {};
+        pipelineInfo.sType              = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage              = Pipeline<HiZParam>::shaderStageDefault(shaderModule, VK_SHADER_STAGE_COMPUTE_BIT);
+        pipelineInfo.layout             = handles.layout;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+        pipelineInfo.basePipelineIndex  = -1; // Optional
+        handles.setPipeline(g_ctx.pipelines.getComputePipeline(pipelineInfo, name + " " + shader));
+        g_ctx.pipelines.destroyShaderModule(shaderModule);
+    };
+    build(hiz_pipeline, "hiz");
+    build(cull_pipeline, "cull");
+}
+
+void OcclusionCulling::createPipelineParam()
+{
+    hiz_pipeline.param_buf = Buffer::New(
+        g_ctx.vk,
+        sizeof(HiZParam),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    g_ctx.dm.registerParameter(hiz_pipeline.param_buf);
+    cull_pipeline.param_buf = Buffer::New(
+        g_ctx.vk,
+        sizeof(CullParam),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    g_ctx.dm.registerParameter(cull_pipeline.param_buf);
+    // the camera dependent cull parameters are written by every record
+    updateDescriptor();
+}
+
+void OcclusionCulling::buildPyramid()
+{
+    vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, hiz_pipeline.pipeline);
+    bindDescriptorSet(0, hiz_pipeline.layout, g_ctx.dm.BINDLESS_SET(), VK_PIPELINE_BIND_POINT_COMPUTE);
+    bindDescriptorSet(1, hiz_pipeline.layout, g_ctx.dm.getParameterSet(hiz_pipeline.param_buf.id), VK_PIPELINE_BIND_POINT_COMPUTE);
+
+    for (uint32_t level = 0; level < levels; level++) {
+        const uint32_t shift  = level + 1;
+        const uint32_t width  = std::max((hiz_pipeline.param.width + (1u << shift) - 1) >> shift, 1u);
+        const uint32_t height = std::max((hiz_pipeline.param.height + (1u << shift) - 1) >> shift, 1u);
+        const HiZPush push { level };
+        vkCmdPushConstants(g_ctx.vk.commandBuffer, hiz_pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HiZPush), &push);
+        vkCmdDispatch(g_ctx.vk.commandBuffer, (width + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (height + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+        // every level reads the one before, the last one is read by the culling
+        pyramid.Barrier(
+            g_ctx.vk,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT);
+    }
+}
+
+void OcclusionCulling::cull(IndirectDraw& draws)
+{
+    draws.update();
+    if (draws.draw_count == 0)
+        return;
+
+    draws.culled_count.Clear(g_ctx.vk);
+    draws.culled_count.Barrier(
+        g_ctx.vk,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    CullPush push {
+        .slots       = g_ctx.dm.getResourceHandle(draws.slot_buffer.id),
+        .batches     = g_ctx.dm.getResourceHandle(draws.batch_buffer.id),
+        .table       = draws.instanceHandle(),
+        .commands    = g_ctx.dm.getResourceHandle(draws.commands.id),
+        .culled      = g_ctx.dm.getResourceHandle(draws.culled.id),
+        .counts      = g_ctx.dm.getResourceHandle(draws.culled_count.id),
+        .slot_count  = static_cast<uint32_t>(draws.slots.size()),
+        .batch_count = static_cast<uint32_t>(draws.batches.size()),
+        .lod_count   = draws.lod_count,
+        .instances   = draws.instances,
+        .pass        = 0,
+    };
+    vkCmdPushConstants(g_ctx.vk.commandBuffer, cull_pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPush), &push);
+    vkCmdDispatch(g_ctx.vk.commandBuffer, (push.slot_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+    // the batches read the instance counts of the slots
+    draws.culled_count.Barrier(
+        g_ctx.vk,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    push.pass = 1;
+    vkCmdPushConstants(g_ctx.vk.commandBuffer, cull_pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPush), &push);
+    vkCmdDispatch(g_ctx.vk.commandBuffer, (push.batch_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    for (const auto* buffer : { &draws.culled, &draws.culled_count }) {
+        buffer->Barrier(
+            g_ctx.vk,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    }
+    draws.instance_objects.Barrier(
+        g_ctx.vk,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+        VK_ACCESS_SHADER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT);
+}
+
+void OcclusionCulling::record(uint32_t swapchain_index)
+{
+    if (draw_lists.empty())
+        return;
+
+    const auto& camera        = g_ctx.rm->camera.data;
+    const glm::mat4 view_proj = camera.proj * camera.view;
+    const Frustum frustum     = Frustum::fromMatrix(view_proj);
+    if (pyramid_valid)
+        buildPyramid();
+
+    cull_pipeline.param.previous_view_proj = previous_view_proj;
+    for (int i = 0; i < 6; i++) {
+        cull_pipeline.param.planes[i] = glm::vec4(frustum.nx[i], frustum.ny[i], frustum.nz[i], frustum.d[i]);
+    }
+    cull_pipeline.param.occlusion = pyramid_valid;
+    cull_pipeline.param_buf.Update(g_ctx.vk, &cull_pipeline.param, sizeof(CullParam));
+
+    vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cull_pipeline.pipeline);
+    bindDescriptorSet(0, cull_pipeline.layout, g_ctx.dm.BINDLESS_SET(), VK_PIPELINE_BIND_POINT_COMPUTE);
+    bindDescriptorSet(1, cull_pipeline.layout, g_ctx.dm.getParameterSet(cull_pipeline.param_buf.id), VK_PIPELINE_BIND_POINT_COMPUTE);
+    for (auto* draws : draw_lists) {
+        cull(*draws);
+    }
+
+    // the depth the object passes write next is what the next frame's pyramid is built from
+    previous_view_proj = view_proj;
+    pyramid_valid      = true;
+}
+
+void OcclusionCulling::onResize()
+{
+    createPyramid();
+    updateDescriptor();
+}
+
+void OcclusionCulling::destroy()
+{
+    hiz_pipeline.destroy();
+    cull_pipeline.destroy();
+    if (pyramid.size > 0) {
+        g_ctx.dm.removeResourceRegistration(pyramid.id);
+        Buffer::Delete(g_ctx.vk, pyramid);
+    }
+}
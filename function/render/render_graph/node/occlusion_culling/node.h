@@ -0,0 +1,84 @@
+#pragma once
+
+#include "function/render/render_graph/indirect_draw.h"
+#include "function/render/render_graph/render_graph_node.h"
+#include <glm/glm.hpp>
+
+// Culls the object draw lists on the GPU before they are recorded. Builds a max-depth pyramid (Hi-Z)
+// from the depth the previous frame left behind, then tests every command's object bounds against the
+// current frustum and the pyramid, reprojected with the previous frame's camera. The survivors are
+// packed into the instance tables of their batches and the commands of the batches left get a draw
+// count for vkCmdDrawIndexedIndirectCount. Objects uncovered by this frame's camera motion may show up
+// one frame late.
+class OcclusionCulling : public RenderGraphNode {
+    struct HiZParam {
+        Vk::DescriptorHandle depth;
+        Vk::DescriptorHandle pyramid;
+        uint32_t width;
+        uint32_t height;
+    };
+    // std140, matrices and planes first
+    struct CullParam {
+        glm::mat4 previous_view_proj;
+        glm::vec4 planes[6];
+        Vk::DescriptorHandle bounds;
+        Vk::DescriptorHandle pyramid;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levels;
+        uint32_t occlusion;
+    };
+    struct HiZPush {
+        uint32_t level;
+    };
+    struct CullPush {
+        Vk::DescriptorHandle slots;
+        Vk::DescriptorHandle batches;
+        Vk::DescriptorHandle table;
+        Vk::DescriptorHandle commands;
+        Vk::DescriptorHandle culled;
+        Vk::DescriptorHandle counts;
+        uint32_t slot_count;
+        uint32_t batch_count;
+        uint32_t lod_count;
+        uint32_t instances;
+        uint32_t pass;
+    };
+
+    void createPyramid();
+    void updateDescriptor();
+    void createPipeline();
+    void createPipelineParam();
+    void buildPyramid();
+    void cull(IndirectDraw& draws);
+
+    Pipeline<HiZParam> hiz_pipeline;
+    Pipeline<CullParam> cull_pipeline;
+    RenderAttachments* attachments;
+    std::string shader_directory;
+    bool enabled = true;
+    std::vector<IndirectDraw*> draw_lists;
+
+    // every level of the pyramid in one float buffer, level 0 is half the depth resolution
+    Vk::Buffer pyramid;
+    uint32_t levels = 0;
+    // the depth attachment holds a previous frame, false until one was rendered at this size
+    bool pyramid_valid = false;
+    glm::mat4 previous_view_proj;
+
+    static constexpr uint32_t HIZ_GROUP_SIZE  = 8;
+    static constexpr uint32_t CULL_GROUP_SIZE = 64;
+
+public:
+    OcclusionCulling(const std::string& name, const std::string& depth_buf_name);
+
+    // culls draws every frame from now on, call after init. Its node must record after this one
+    void addDraws(IndirectDraw& draws);
+
+    virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
+    virtual void record(uint32_t swapchain_index) override;
+    virtual void onResize() override;
+    virtual void destroy() override;
+};
@@ -0,0 +1,19 @@
+// The smoke pass' mapping from field values to density, shared by its raymarch and light transmittance
+
+const int TYPE_CONCENTRATION = 0;
+const int TYPE_TEMPERATURE = 1;
+
+float map_density(float sampled_density, int type)
+{
+    // some fields may be sampled outside of the field
+    if (type == TYPE_TEMPERATURE) {
+        return sampled_density * 20;
+    }
+    if (type == TYPE_CONCENTRATION) {
+        if (sampled_density < 0.035) {
+            return 0;
+        }
+        return pow(sampled_density, 1.0) * 180;
+    }
+    return 0;
+}
@@ -0,0 +1,23 @@
+// The vorticity pass' mapping from field values to density, shared by its raymarch and light
+// transmittance
+
+const float DENSITY_GLOBAL_SCALE = 1.0 / 300.0;
+const int TYPE_CONCENTRATION = 0;
+const int TYPE_TEMPERATURE = 1;
+
+float map_density(float sampled_density, int type)
+{
+    sampled_density = sampled_density * DENSITY_GLOBAL_SCALE;
+
+    // some fields may be sampled outside of the field
+    if (type == TYPE_TEMPERATURE) {
+        return sampled_density * 20;
+    }
+    if (type == TYPE_CONCENTRATION) {
+        if (sampled_density < 0.02) {
+            return 0;
+        }
+        return pow(sampled_density, 1.2) * 180;
+    }
+    return 0;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "function/render/render_graph/light_transmittance.h"
 #include "function/render/render_graph/render_graph_node.h"
 
 class VorticityFieldNode : public RenderGraphNode {
@@ -8,17 +9,22 @@ class VorticityFieldNode : public RenderGraphNode {
         Vk::DescriptorHandle lights;
         Vk::DescriptorHandle previous_color;
         Vk::DescriptorHandle previous_depth;
+        Vk::DescriptorHandle transmittance;
     };
 
     void createRenderPass();
     void createFramebuffer();
     void updateDescriptor();
-    void createPipeline(Configuration& cfg);
+    void createPipeline();
+    void createPipelineParam();
 
     Pipeline<Param> pipeline;
+    LightTransmittance transmittance;
     VkRenderPass render_pass;
     std::vector<VkFramebuffer> framebuffers;
     RenderAttachments* attachments;
+    std::string shader_directory;
+    SpecializationConstants frag_constants;
 
 public:
     VorticityFieldNode(
@@ -28,6 +34,8 @@ public:
         const std::string& color_buf);
 
     virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
     virtual void record(uint32_t swapchain_index) override;
     virtual void onResize() override;
     virtual void destroy() override;
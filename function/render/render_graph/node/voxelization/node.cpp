@@ -59,14 +59,22 @@ Voxelization::Voxelization(const std::string& name, const std::string& voxel_tex
 void Voxelization::init(Configuration& cfg, RenderAttachments& attachments)
 {
     this->attachments = &attachments;
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    shader_directory = rg_cfg.shader_directory;
+
     createMatsBuffer();
     createVertPosBuffer();
     createRenderPass();
     createFramebuffer();
     createVoxelTex();
-    createVoxelizationPipeline(cfg);
-    createVelocityRecordPipeline(cfg);
-    createVertexPosPipeline(cfg);
+    createFixedFunctionState();
+    // This voxelization method only apply to watertight mesh, exclude scene boundary meshes
+    auto watertight = [](const Object& obj) { return g_ctx.rm->meshes.at(obj.mesh).isWaterTight; };
+    layered_draws.init(watertight, config.dimension[1]);
+    object_draws.init(watertight);
+    createVoxelizationPipelineParam();
+    createVelocityRecordPipelineParam();
+    createVertexPosPipelineParam();
 
     assert(!g_ctx.rm->textures.contains("voxel"));
     assert(!g_ctx.rm->textures.contains("velocity"));
@@ -74,6 +82,20 @@ void Voxelization::init(Configuration& cfg, RenderAttachments& attachments)
     g_ctx.rm->textures["velocity"] = Texture { "velocity", velocity_tex };
 }
 
+std::vector<std::function<void()>> Voxelization::pipelineTasks()
+{
+    return {
+        [this] { createVoxelizationPipeline(); },
+        [this] { createVelocityRecordPipeline(); },
+        [this] { createVertexPosPipeline(); },
+    };
+}
+
+std::vector<PipelineHandles*> Voxelization::pipelines()
+{
+    return { &voxel_pipeline, &velocity_pipeline, &vertex_pos_pipeline };
+}
+
 void Voxelization::createMatsBuffer()
 {
     auto eye_pos = glm::vec3(config.start_pos[0] + config.size[0] / 2.0f, config.start_pos[1], config.start_pos[2] + config.size[2] / 2.0f);
@@ -237,19 +259,26 @@ void Voxelization::createFramebuffer()
     }
 }
 
-VkPipelineVertexInputStateCreateInfo Voxelization::getVertexInputState()
+void Voxelization::createFixedFunctionState()
 {
-    static VkVertexInputBindingDescription bindingDescription {};
-    bindingDescription.binding   = 0;
-    bindingDescription.stride    = sizeof(Vertex);
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    // Filled once before the pipeline tasks run, the create infos below only point into these members
+    // only the position is read, in whatever layout the meshes were uploaded
+    bindingDescription   = Vertex::getBindingDescription(g_ctx.rm->vertex_format);
+    attributeDescription = Vertex::getAttributeDescriptions(g_ctx.rm->vertex_format)[0];
 
-    static VkVertexInputAttributeDescription attributeDescription {};
-    attributeDescription.binding  = 0;
-    attributeDescription.location = 0;
-    attributeDescription.format   = VK_FORMAT_R32G32B32_SFLOAT;
-    attributeDescription.offset   = offsetof(Vertex, pos);
+    viewport.x        = 0.0f;
+    viewport.y        = 0.0f;
+    viewport.width    = static_cast<float>(config.dimension[0]);
+    viewport.height   = static_cast<float>(config.dimension[2]);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    scissor.offset = { 0, 0 };
+    scissor.extent = { config.dimension[0], config.dimension[2] };
+}
 
+VkPipelineVertexInputStateCreateInfo Voxelization::getVertexInputState() const
+{
     VkPipelineVertexInputStateCreateInfo vertexInput {};
     vertexInput.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertexInput.vertexBindingDescriptionCount   = 1;
@@ -259,7 +288,7 @@ VkPipelineVertexInputStateCreateInfo Voxelization::getVertexInputState()
     return vertexInput;
 }
 
-VkPipelineRasterizationStateCreateInfo Voxelization::getRasterizationState(bool rasterize)
+VkPipelineRasterizationStateCreateInfo Voxelization::getRasterizationState(bool rasterize) const
 {
     VkPipelineRasterizationStateCreateInfo rasterizer {};
     rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -273,20 +302,8 @@ VkPipelineRasterizationStateCreateInfo Voxelization::getRasterizationState(bool
     return rasterizer;
 }
 
-VkPipelineViewportStateCreateInfo Voxelization::getViewportState()
+VkPipelineViewportStateCreateInfo Voxelization::getViewportState() const
 {
-    static VkViewport viewport {};
-    viewport.x        = 0.0f;
-    viewport.y        = 0.0f;
-    viewport.width    = static_cast<float>(config.dimension[0]);
-    viewport.height   = static_cast<float>(config.dimension[2]);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    static VkRect2D scissor {};
-    scissor.offset = { 0, 0 };
-    scissor.extent = { config.dimension[0], config.dimension[2] };
-
     VkPipelineViewportStateCreateInfo viewportState {};
     viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportState.viewportCount = 1;
@@ -296,13 +313,12 @@ VkPipelineViewportStateCreateInfo Voxelization::getViewportState()
     return viewportState;
 }
 
-void Voxelization::createVoxelizationPipeline(Configuration& cfg)
+void Voxelization::createVoxelizationPipeline()
 {
     {
         std::vector<VkDescriptorSetLayout> descLayouts = {
             g_ctx.dm.BINDLESS_LAYOUT(),
             g_ctx.dm.PARAMETER_LAYOUT(),
-            g_ctx.dm.PARAMETER_LAYOUT(),
         };
         voxel_pipeline.initLayout(descLayouts);
     }
@@ -315,11 +331,10 @@ void Voxelization::createVoxelizationPipeline(Configuration& cfg)
         auto rasterization = getRasterizationState(true);
         auto multisample   = Pipeline<VoxelParam>::multisampleDefault();
 
-        JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
-        auto vertShaderCode    = readFile(rg_cfg.shader_directory + "/voxelization/voxelization.vert.spv");
-        auto fragShaderCode    = readFile(rg_cfg.shader_directory + "/voxelization/voxelization.frag.spv");
-        auto vertShaderModule  = createShaderModule(g_ctx.vk, vertShaderCode);
-        auto fragShaderModule  = createShaderModule(g_ctx.vk, fragShaderCode);
+        auto vertShaderCode    = readFile(shader_directory + "/voxelization/voxelization.vert.spv");
+        auto fragShaderCode    = readFile(shader_directory + "/voxelization/voxelization.frag.spv");
+        auto vertShaderModule  = g_ctx.pipelines.createShaderModule(vertShaderCode);
+        auto fragShaderModule  = g_ctx.pipelines.createShaderModule(fragShaderCode);
         std::vector shaderStages = {
             Pipeline<VoxelParam>::shaderStageDefault(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT),
             Pipeline<VoxelParam>::shaderStageDefault(fragShaderModule, VK_SHADER_STAGE_FRAGMENT_BIT),
@@ -372,34 +387,35 @@ void Voxelization::createVoxelizationPipeline(Configuration& cfg)
         pipelineInfo.layout              = voxel_pipeline.layout;
         pipelineInfo.renderPass          = render_pass;
         pipelineInfo.subpass             = 0;
-        if (vkCreateGraphicsPipelines(g_ctx.vk.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &voxel_pipeline.pipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create voxelization pipeline!");
-        }
-        vkDestroyShaderModule(g_ctx.vk.device, vertShaderModule, nullptr);
-        vkDestroyShaderModule(g_ctx.vk.device, fragShaderModule, nullptr);
+        voxel_pipeline.setPipeline(g_ctx.pipelines.getGraphicsPipeline(pipelineInfo, name + "/voxel"));
+        g_ctx.pipelines.destroyShaderModule(vertShaderModule);
+        g_ctx.pipelines.destroyShaderModule(fragShaderModule);
     }
+}
 
-    {
-        voxel_pipeline.param.voxelizationViewMat  = g_ctx.dm.getResourceHandle(view_mat_buffer.id);
-        voxel_pipeline.param.voxelizationProjMats = g_ctx.dm.getResourceHandle(proj_mats_buffer.id);
-        voxel_pipeline.param_buf                  = Buffer::New(
-            g_ctx.vk,
-            sizeof(VoxelParam),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            true
-        );
-        voxel_pipeline.param_buf.Update(g_ctx.vk, &voxel_pipeline.param, sizeof(VoxelParam));
-        g_ctx.dm.registerParameter(voxel_pipeline.param_buf);
-    }
+void Voxelization::createVoxelizationPipelineParam()
+{
+    voxel_pipeline.param.voxelizationViewMat  = g_ctx.dm.getResourceHandle(view_mat_buffer.id);
+    voxel_pipeline.param.voxelizationProjMats = g_ctx.dm.getResourceHandle(proj_mats_buffer.id);
+    voxel_pipeline.param.objects              = g_ctx.dm.getResourceHandle(g_ctx.rm->object_buffer.buffer.id);
+    voxel_pipeline.param.instances            = layered_draws.instanceHandle();
+    voxel_pipeline.param.layers               = config.dimension[1];
+    voxel_pipeline.param_buf                  = Buffer::New(
+        g_ctx.vk,
+        sizeof(VoxelParam),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true
+    );
+    voxel_pipeline.param_buf.Update(g_ctx.vk, &voxel_pipeline.param, sizeof(VoxelParam));
+    g_ctx.dm.registerParameter(voxel_pipeline.param_buf);
 }
 
-void Voxelization::createVelocityRecordPipeline(Configuration &cfg)
+void Voxelization::createVelocityRecordPipeline()
 {
     {
         std::vector<VkDescriptorSetLayout> descLayouts = {
             g_ctx.dm.BINDLESS_LAYOUT(),
-            g_ctx.dm.PARAMETER_LAYOUT(),
             g_ctx.dm.PARAMETER_LAYOUT()
         };
         velocity_pipeline.initLayout(descLayouts);
@@ -413,13 +429,12 @@ void Voxelization::createVelocityRecordPipeline(Configuration &cfg)
         auto rasterization = getRasterizationState(true);
         auto multisample   = Pipeline<VelocityParam>::multisampleDefault();
 
-        JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
-        auto vertShaderCode    = readFile(rg_cfg.shader_directory + "/voxelization/velocity.vert.spv");
-        auto geomShaderCode    = readFile(rg_cfg.shader_directory + "/voxelization/velocity.geom.spv");
-        auto fragShaderCode    = readFile(rg_cfg.shader_directory + "/voxelization/velocity.frag.spv");
-        auto vertShaderModule  = createShaderModule(g_ctx.vk, vertShaderCode);
-        auto geomShaderModule  = createShaderModule(g_ctx.vk, geomShaderCode);
-        auto fragShaderModule  = createShaderModule(g_ctx.vk, fragShaderCode);
+        auto vertShaderCode    = readFile(shader_directory + "/voxelization/velocity.vert.spv");
+        auto geomShaderCode    = readFile(shader_directory + "/voxelization/velocity.geom.spv");
+        auto fragShaderCode    = readFile(shader_directory + "/voxelization/velocity.frag.spv");
+        auto vertShaderModule  = g_ctx.pipelines.createShaderModule(vertShaderCode);
+        auto geomShaderModule  = g_ctx.pipelines.createShaderModule(geomShaderCode);
+        auto fragShaderModule  = g_ctx.pipelines.createShaderModule(fragShaderCode);
         std::vector shaderStages = {
             Pipeline<VelocityParam>::shaderStageDefault(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT),
             Pipeline<VelocityParam>::shaderStageDefault(geomShaderModule, VK_SHADER_STAGE_GEOMETRY_BIT),
@@ -456,36 +471,54 @@ void Voxelization::createVelocityRecordPipeline(Configuration &cfg)
         pipelineInfo.layout              = velocity_pipeline.layout;
         pipelineInfo.renderPass          = render_pass;
         pipelineInfo.subpass             = 1;
-        if (vkCreateGraphicsPipelines(g_ctx.vk.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &velocity_pipeline.pipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create vertices position feedback pipeline!");
-        }
-        vkDestroyShaderModule(g_ctx.vk.device, vertShaderModule, nullptr);
-        vkDestroyShaderModule(g_ctx.vk.device, geomShaderModule, nullptr);
-        vkDestroyShaderModule(g_ctx.vk.device, fragShaderModule, nullptr);
+        velocity_pipeline.setPipeline(g_ctx.pipelines.getGraphicsPipeline(pipelineInfo, name + "/velocity"));
+        g_ctx.pipelines.destroyShaderModule(vertShaderModule);
+        g_ctx.pipelines.destroyShaderModule(geomShaderModule);
+        g_ctx.pipelines.destroyShaderModule(fragShaderModule);
     }
+}
 
-    {
-        velocity_pipeline.param.projSpacePixDim      = glm::vec2(1.f / static_cast<float>(config.dimension[0]), 1.f / static_cast<float>(config.dimension[2]));
-        velocity_pipeline.param.deltaT               = 0.00555f; // default value, will be updated every frame
-        velocity_pipeline.param.voxelizationViewMat  = g_ctx.dm.getResourceHandle(view_mat_buffer.id);
-        velocity_pipeline.param.voxelizationProjMats = g_ctx.dm.getResourceHandle(proj_mats_buffer.id);
-
-        velocity_pipeline.param_buf = Buffer::New(
-            g_ctx.vk,
-            sizeof(VelocityParam),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            true
-        );
-        velocity_pipeline.param_buf.Update(g_ctx.vk, &velocity_pipeline.param, sizeof(VelocityParam));
-        g_ctx.dm.registerParameter(velocity_pipeline.param_buf);
-    }
+void Voxelization::createVelocityRecordPipelineParam()
+{
+    velocity_pipeline.param.projSpacePixDim      = glm::vec2(1.f / static_cast<float>(config.dimension[0]), 1.f / static_cast<float>(config.dimension[2]));
+    velocity_pipeline.param.deltaT               = 0.00555f; // default value, will be updated every frame
+    velocity_pipeline.param.voxelizationViewMat  = g_ctx.dm.getResourceHandle(view_mat_buffer.id);
+    velocity_pipeline.param.voxelizationProjMats = g_ctx.dm.getResourceHandle(proj_mats_buffer.id);
+    velocity_pipeline.param.objects              = g_ctx.dm.getResourceHandle(g_ctx.rm->object_buffer.buffer.id);
+    velocity_pipeline.param.instances            = layered_draws.instanceHandle();
+    velocity_pipeline.param.layers               = config.dimension[1];
+
+    velocity_pipeline.param_buf = Buffer::New(
+        g_ctx.vk,
+        sizeof(VelocityParam),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true
+    );
+    velocity_pipeline.param_buf.Update(g_ctx.vk, &velocity_pipeline.param, sizeof(VelocityParam));
+    g_ctx.dm.registerParameter(velocity_pipeline.param_buf);
 }
 
-void Voxelization::createVertexPosPipeline(Configuration &cfg)
+void Voxelization::createVertexPosPipelineParam()
+{
+    vertex_pos_pipeline.param.objects   = g_ctx.dm.getResourceHandle(g_ctx.rm->object_buffer.buffer.id);
+    vertex_pos_pipeline.param.instances = object_draws.instanceHandle();
+    vertex_pos_pipeline.param_buf       = Buffer::New(
+        g_ctx.vk,
+        sizeof(VertexPosParam),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true
+    );
+    vertex_pos_pipeline.param_buf.Update(g_ctx.vk, &vertex_pos_pipeline.param, sizeof(VertexPosParam));
+    g_ctx.dm.registerParameter(vertex_pos_pipeline.param_buf);
+}
+
+void Voxelization::createVertexPosPipeline()
 {
     {
         std::vector<VkDescriptorSetLayout> descLayouts = {
+            g_ctx.dm.BINDLESS_LAYOUT(),
             g_ctx.dm.PARAMETER_LAYOUT(),
         };
         vertex_pos_pipeline.initLayout(descLayouts);
@@ -495,15 +528,14 @@ void Voxelization::createVertexPosPipeline(Configuration &cfg)
         auto vertexInput   = getVertexInputState();
         DynamicStateDefault();
         auto viewportState = getViewportState();
-        auto inputAssembly = Pipeline<EmptyParam>::inputAssemblyDefault();
+        auto inputAssembly = Pipeline<VertexPosParam>::inputAssemblyDefault();
         auto rasterization = getRasterizationState(false);
-        auto multisample   = Pipeline<EmptyParam>::multisampleDefault();
+        auto multisample   = Pipeline<VertexPosParam>::multisampleDefault();
 
-        JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
-        auto vertShaderCode    = readFile(rg_cfg.shader_directory + "/voxelization/vertexPos.vert.spv");
-        auto vertShaderModule  = createShaderModule(g_ctx.vk, vertShaderCode);
+        auto vertShaderCode    = readFile(shader_directory + "/voxelization/vertexPos.vert.spv");
+        auto vertShaderModule  = g_ctx.pipelines.createShaderModule(vertShaderCode);
         std::vector shaderStages = {
-            Pipeline<EmptyParam>::shaderStageDefault(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT),
+            Pipeline<VertexPosParam>::shaderStageDefault(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT),
         };
 
         VkPipelineColorBlendStateCreateInfo colorBlending {};
@@ -533,10 +565,8 @@ void Voxelization::createVertexPosPipeline(Configuration &cfg)
         pipelineInfo.layout              = vertex_pos_pipeline.layout;
         pipelineInfo.renderPass          = render_pass;
         pipelineInfo.subpass             = 2;
-        if (vkCreateGraphicsPipelines(g_ctx.vk.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &vertex_pos_pipeline.pipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create vertices position feedback pipeline!");
-        }
-        vkDestroyShaderModule(g_ctx.vk.device, vertShaderModule, nullptr);
+        vertex_pos_pipeline.setPipeline(g_ctx.pipelines.getGraphicsPipeline(pipelineInfo, name + "/vertex_pos"));
+        g_ctx.pipelines.destroyShaderModule(vertShaderModule);
     }
 }
 
@@ -566,6 +596,8 @@ void Voxelization::record(uint32_t swapchain_index)
 {
     updateTime();
     setViewportAndScissor();
+    layered_draws.update();
+    object_draws.update();
 
     // Profile time for the entire voxelization pass
     VK_PROFILE_SCOPE(g_ctx.profiler, g_ctx.vk.commandBuffer, "Voxelization");
@@ -587,19 +619,9 @@ void Voxelization::record(uint32_t swapchain_index)
     vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, voxel_pipeline.pipeline);
     bindDescriptorSet(0, voxel_pipeline.layout, g_ctx.dm.BINDLESS_SET());
     bindDescriptorSet(1, voxel_pipeline.layout, g_ctx.dm.getParameterSet(voxel_pipeline.param_buf.id));
-
-    for (int i = 0; i < g_ctx.rm->objects.size(); ++i) {
-        const Object& obj = g_ctx.rm->objects[i];
-        const Mesh& mesh = g_ctx.rm->meshes[obj.mesh];
-        if (!mesh.isWaterTight) // This voxelization method only apply to watertight mesh, exclude scene boundary meshes
-            continue;
-
-        bindDescriptorSet(2, voxel_pipeline.layout, g_ctx.dm.getParameterSet(obj.paramBuffer.id));
-        constexpr VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(g_ctx.vk.commandBuffer, 0, 1, &mesh.vertexBuffer.buffer, offsets);
-        vkCmdBindIndexBuffer(g_ctx.vk.commandBuffer, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(g_ctx.vk.commandBuffer, mesh.data.indices.size(), config.dimension[1], 0, 0, 0);
-    }
+    // stays bound through all three subpasses
+    g_ctx.rm->geometry_pool.bind(g_ctx.vk.commandBuffer);
+    layered_draws.draw(g_ctx.vk.commandBuffer);
 
     // Subpass 1, each objects writes its velocity to the velocity texture
     // This is not a good pattern for using subpass since these two subpasses don't share any
@@ -608,28 +630,18 @@ void Voxelization::record(uint32_t swapchain_index)
     vkCmdNextSubpass(g_ctx.vk.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
     vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, velocity_pipeline.pipeline);
     bindDescriptorSet(1, velocity_pipeline.layout, g_ctx.dm.getParameterSet(velocity_pipeline.param_buf.id));
-
-    for (int i = 0; i < g_ctx.rm->objects.size(); ++i) {
-        const Object& obj = g_ctx.rm->objects[i];
-        const Mesh& mesh = g_ctx.rm->meshes[obj.mesh];
-        if (!mesh.isWaterTight) // This voxelization method only apply to watertight mesh, exclude scene boundary meshes
-            continue;
-
-        bindDescriptorSet(2, velocity_pipeline.layout, g_ctx.dm.getParameterSet(obj.paramBuffer.id));
-        constexpr VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(g_ctx.vk.commandBuffer, 0, 1, &mesh.vertexBuffer.buffer, offsets);
-        vkCmdBindIndexBuffer(g_ctx.vk.commandBuffer, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(g_ctx.vk.commandBuffer, mesh.data.indices.size(), config.dimension[1], 0, 0, 0);
-    }
+    layered_draws.draw(g_ctx.vk.commandBuffer);
 
     // Subpass 2, each object writes its vertices positions to object's own position buffer.
     // This is not a good pattern for using subpass since these two subpasses don't share any
-    // on-chip memory resource. And the way it uses the transform feedback is also inoptimal
-    // since it does not use any indirect draw commands but issuing of a bunch of commands in
-    // CPU side instead. However, the bottleneck is in the simulation side so we can keep the current
-    // design to achieve minimum modifications of the render engine for implementing voxelization.
+    // on-chip memory resource. The transform feedback buffer is per object, so this subpass still
+    // records one indirect draw per object instead of one for the whole scene. However, the bottleneck
+    // is in the simulation side so we can keep the current design to achieve minimum modifications of
+    // the render engine for implementing voxelization.
     vkCmdNextSubpass(g_ctx.vk.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
     vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vertex_pos_pipeline.pipeline);
+    bindDescriptorSet(0, vertex_pos_pipeline.layout, g_ctx.dm.BINDLESS_SET());
+    bindDescriptorSet(1, vertex_pos_pipeline.layout, g_ctx.dm.getParameterSet(vertex_pos_pipeline.param_buf.id));
 
     for (int i = 0; i < g_ctx.rm->objects.size(); ++i) {
         const Object& obj = g_ctx.rm->objects[i];
@@ -637,15 +649,10 @@ void Voxelization::record(uint32_t swapchain_index)
         if (!mesh.isWaterTight) // This voxelization method only apply to watertight mesh, exclude scene boundary meshes
             continue;
 
-        bindDescriptorSet(0, vertex_pos_pipeline.layout, g_ctx.dm.getParameterSet(obj.paramBuffer.id));
         constexpr VkDeviceSize offsets[] = { 0 };
         fpCmdBindTransformFeedbackBuffersEXTHandle(g_ctx.vk.commandBuffer, 0, 1, &vert_pos_buffers[i].buffer, offsets, nullptr);
         fpCmdBeginTransformFeedbackEXTHandle(g_ctx.vk.commandBuffer, 0, 0, nullptr, nullptr);
-
-        vkCmdBindVertexBuffers(g_ctx.vk.commandBuffer, 0, 1, &mesh.vertexBuffer.buffer, offsets);
-        vkCmdBindIndexBuffer(g_ctx.vk.commandBuffer, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(g_ctx.vk.commandBuffer, mesh.data.indices.size(), 1, 0, 0, 0);
-
+        object_draws.drawObject(g_ctx.vk.commandBuffer, i);
         fpCmdEndTransformFeedbackEXTHandle(g_ctx.vk.commandBuffer, 0, 0, nullptr, nullptr);
     }
 
@@ -670,6 +677,10 @@ void Voxelization::onResize()
 void Voxelization::destroy()
 {
     voxel_pipeline.destroy();
+    velocity_pipeline.destroy();
+    vertex_pos_pipeline.destroy();
+    layered_draws.destroy();
+    object_draws.destroy();
     vkDestroyRenderPass(g_ctx.vk.device, render_pass, nullptr);
     for (auto& framebuffer : framebuffers) {
         vkDestroyFramebuffer(g_ctx.vk.device, framebuffer, nullptr);
@@ -1,11 +1,15 @@
 #pragma once
 
+#include "function/render/render_graph/indirect_draw.h"
 #include "function/render/render_graph/render_graph_node.h"
 
 class Voxelization : public RenderGraphNode {
     struct VoxelParam {
         Vk::DescriptorHandle voxelizationViewMat;
         Vk::DescriptorHandle voxelizationProjMats;
+        Vk::DescriptorHandle objects;
+        Vk::DescriptorHandle instances;
+        uint32_t layers;
     };
 
     struct VelocityParam {
@@ -13,31 +17,51 @@ class Voxelization : public RenderGraphNode {
         float deltaT;
         Vk::DescriptorHandle voxelizationViewMat;
         Vk::DescriptorHandle voxelizationProjMats;
+        Vk::DescriptorHandle objects;
+        Vk::DescriptorHandle instances;
+        uint32_t layers;
     };
 
-    struct EmptyParam {};
+    struct VertexPosParam {
+        Vk::DescriptorHandle objects;
+        Vk::DescriptorHandle instances;
+    };
 
-    VkPipelineVertexInputStateCreateInfo getVertexInputState();
-    VkPipelineRasterizationStateCreateInfo getRasterizationState(bool rasterize);
-    VkPipelineViewportStateCreateInfo getViewportState();
+    VkPipelineVertexInputStateCreateInfo getVertexInputState() const;
+    VkPipelineRasterizationStateCreateInfo getRasterizationState(bool rasterize) const;
+    VkPipelineViewportStateCreateInfo getViewportState() const;
 
     void createMatsBuffer();
     void createVertPosBuffer();
     void createRenderPass();
     void createVoxelTex();
     void createFramebuffer();
-    void createVoxelizationPipeline(Configuration& cfg);
-    void createVelocityRecordPipeline(Configuration& cfg);
-    void createVertexPosPipeline(Configuration& cfg);
+    void createFixedFunctionState();
+    void createVoxelizationPipeline();
+    void createVoxelizationPipelineParam();
+    void createVelocityRecordPipeline();
+    void createVelocityRecordPipelineParam();
+    void createVertexPosPipeline();
+    void createVertexPosPipelineParam();
     void setViewportAndScissor();
     void updateTime();
 
     Pipeline<VoxelParam> voxel_pipeline;
     Pipeline<VelocityParam> velocity_pipeline;
-    Pipeline<EmptyParam> vertex_pos_pipeline;
+    Pipeline<VertexPosParam> vertex_pos_pipeline;
+    // watertight objects, one instance per layer for the voxel and velocity subpasses
+    IndirectDraw layered_draws;
+    // watertight objects, drawn one at a time into their transform feedback buffers
+    IndirectDraw object_draws;
     VkRenderPass render_pass;
     std::vector<VkFramebuffer> framebuffers;
     RenderAttachments* attachments;
+    std::string shader_directory;
+
+    VkVertexInputBindingDescription bindingDescription {};
+    VkVertexInputAttributeDescription attributeDescription {};
+    VkViewport viewport {};
+    VkRect2D scissor {};
 
     Vk::Buffer staging_buffer;
     Vk::Image voxel_tex;
@@ -59,6 +83,8 @@ public:
         const Configuration& cfg);
 
     void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual std::vector<std::function<void()>> pipelineTasks() override;
+    virtual std::vector<PipelineHandles*> pipelines() override;
     void record(uint32_t swapchain_index) override;
     void onResize() override;
     void destroy() override;
@@ -28,34 +28,30 @@ layout (set = 1, binding = 0) uniform PipelineParam
     float deltaT;
     Handle voxelizationViewMat;
     Handle voxelizationProjMats;
+    Handle objects;
+    Handle instances;
+    uint layers;
 }
 pipelineParam;
 
-layout(set = 2, binding = 0) uniform ObjectParam
-{
-    mat4 model;
-    mat4 modelInvTrans;
-    Handle material;
-    Handle vertBuf;
-}
-objectParam;
-
 layout(location = 0) in vec3 inPosition;
 
 layout(location = 0) out vec3 outVelocity;
 layout(location = 1) flat out int outInstanceIndex;
 
-#define GetModel objectParam.model
+#define GetObject GetObjectParam(pipelineParam.objects, GetInstanceObject(pipelineParam.instances, gl_InstanceIndex / int(pipelineParam.layers)))
+#define GetModel GetObject.model
 #define GetView voxelizationView[pipelineParam.voxelizationViewMat].view
 #define GetProj(index) voxelizationProjs[pipelineParam.voxelizationProjMats].projs[index]
-#define GetPrevVertexPos(index) vertexPosWorld[objectParam.vertBuf].positions[index]
+#define GetPrevVertexPos(index) vertexPosWorld[GetObject.vertBuf].positions[index]
 
 void main()
 {
-    int layer = gl_InstanceIndex;
+    int layer = gl_InstanceIndex % int(pipelineParam.layers);
 
-    vec4 prevPos = GetPrevVertexPos(gl_VertexIndex);
-    vec4 currPos = GetModel * vec4(inPosition, 1.0);
+    vec4 prevPos = GetPrevVertexPos(gl_VertexIndex - GetObject.vertexOffset);
+    vec3 position = decodePosition(inPosition, GetObject.positionOffset, GetObject.positionScale);
+    vec4 currPos = GetModel * vec4(position, 1.0);
     vec3 velocity = (currPos.xyz - prevPos.xyz) / pipelineParam.deltaT;
 
     outVelocity      = velocity;
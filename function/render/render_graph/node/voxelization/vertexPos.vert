@@ -5,22 +5,22 @@
 
 #include "../../shader/common.glsl"
 
-layout(set = 0, binding = 0) uniform ObjectParam
+layout(set = 1, binding = 0) uniform PipelineParam
 {
-    mat4 model;
-    mat4 modelInvTrans;
-    Handle material;
-    Handle vertBuf;
+    Handle objects;
+    Handle instances;
 }
-objectParam;
+pipelineParam;
 
 layout(location = 0) in vec3 inPosition;
 
 layout(location = 0, xfb_buffer = 0, xfb_offset = 0) out vec4 outPosition;
 
-#define GetModel objectParam.model
+#define GetObject GetObjectParam(pipelineParam.objects, GetInstanceObject(pipelineParam.instances, gl_InstanceIndex))
+#define GetModel GetObject.model
 
 void main()
 {
-    outPosition = GetModel * vec4(inPosition, 1.0);
+    vec3 position = decodePosition(inPosition, GetObject.positionOffset, GetObject.positionScale);
+    outPosition = GetModel * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -22,30 +22,25 @@ layout (set = 1, binding = 0) uniform VoxelizationPipelineParam
 {
     Handle voxelizationViewMat;
     Handle voxelizationProjMats;
+    Handle objects;
+    Handle instances;
+    uint layers;
 }
 pipelineParam;
 
-layout(set = 2, binding = 0) uniform ObjectParam
-{
-    mat4 model;
-    mat4 modelInvTrans;
-    Handle material;
-    Handle vertBuf;
-}
-objectParam;
-
 layout(location = 0) in vec3 inPosition;
 
 #define GetView voxelizationView[pipelineParam.voxelizationViewMat]
 #define GetProjs voxelizationProjs[pipelineParam.voxelizationProjMats]
-#define GetObject objectParam
+#define GetObject GetObjectParam(pipelineParam.objects, GetInstanceObject(pipelineParam.instances, gl_InstanceIndex / int(pipelineParam.layers)))
 
 void main()
 {
-    int layer = gl_InstanceIndex;
+    int layer = gl_InstanceIndex % int(pipelineParam.layers);
     gl_Layer = layer;
 
-    vec4 position_w = GetObject.model * vec4(inPosition, 1.0);
+    vec3 position = decodePosition(inPosition, GetObject.positionOffset, GetObject.positionScale);
+    vec4 position_w = GetObject.model * vec4(position, 1.0);
     mat4 view = GetView.view;
     mat4 proj = GetProjs.proj[layer];
 
@@ -3,14 +3,16 @@
 #include "core/vulkan/type/buffer.h"
 #include "core/vulkan/vulkan_util.h"
 #include "function/global_context.h"
+#include "function/resource_manager/resource_manager.h"
 #include "function/type/vertex.h"
+#include <cstring>
 #include <vulkan/vulkan_core.h>
 
 #define VertexInputDefault(hasVertexInput)                                                                 \
     VkPipelineVertexInputStateCreateInfo vertexInput {};                                                   \
     vertexInput.sType          = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;                \
-    auto bindingDescription    = Vertex::getBindingDescription();                                          \
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();                                       \
+    auto bindingDescription    = Vertex::getBindingDescription(g_ctx.rm->vertex_format);                   \
+    auto attributeDescriptions = Vertex::getAttributeDescriptions(g_ctx.rm->vertex_format);                \
     if (hasVertexInput) {                                                                                  \
         vertexInput.vertexBindingDescriptionCount   = 1;                                                   \
         vertexInput.pVertexBindingDescriptions      = &bindingDescription;                                 \
@@ -51,10 +53,69 @@
     viewportState.scissorCount  = 1;                                                     \
     viewportState.pScissors     = &scissor;
 
-template <typename T>
-struct Pipeline {
+// Values for `layout(constant_id = N) const ...` declarations of one shader stage. Filled with add()
+// then build() in the node's init, the pipeline tasks running on the thread pool only read get().
+// Must outlive the vkCreate*Pipelines call that consumes get().
+struct SpecializationConstants {
+    std::vector<VkSpecializationMapEntry> entries;
+    std::vector<uint8_t> data;
+    VkSpecializationInfo info {};
+
+    // bool constants must be passed as VkBool32
+    template <typename V>
+    SpecializationConstants& add(uint32_t constant_id, const V& value)
+    {
+        static_assert(sizeof(V) == 4, "specialization constants are 32-bit scalars");
+        assert(info.pMapEntries == nullptr && "add after build");
+        entries.push_back({ constant_id, static_cast<uint32_t>(data.size()), sizeof(V) });
+        data.resize(data.size() + sizeof(V));
+        std::memcpy(data.data() + entries.back().offset, &value, sizeof(V));
+        return *this;
+    }
+
+    void build()
+    {
+        info.mapEntryCount = static_cast<uint32_t>(entries.size());
+        info.pMapEntries   = entries.data();
+        info.dataSize      = data.size();
+        info.pData         = data.data();
+    }
+
+    const VkSpecializationInfo* get() const
+    {
+        assert(info.mapEntryCount == entries.size() && "get before build");
+        return &info;
+    }
+};
+
+// Handles of a pipeline without its parameter type, so the render graph can swap in reloaded shaders
+struct PipelineHandles {
     VkPipelineLayout layout = VK_NULL_HANDLE;
     VkPipeline pipeline     = VK_NULL_HANDLE;
+    // built by a shader reload on the watcher thread, swapped in by the render thread between frames
+    VkPipeline reloaded = VK_NULL_HANDLE;
+
+    void setPipeline(VkPipeline handle)
+    {
+        if (pipeline == VK_NULL_HANDLE)
+            pipeline = handle;
+        else
+            reloaded = handle;
+    }
+
+    // the previous pipeline may still be in flight, it is handed out for a deferred release
+    void swapReloaded(std::vector<VkPipeline>& retired)
+    {
+        if (reloaded == VK_NULL_HANDLE)
+            return;
+        retired.push_back(pipeline);
+        pipeline = reloaded;
+        reloaded = VK_NULL_HANDLE;
+    }
+};
+
+template <typename T>
+struct Pipeline : PipelineHandles {
     T param;
     Vk::Buffer param_buf;
 
@@ -62,13 +123,17 @@ struct Pipeline {
     {
         if (layout != VK_NULL_HANDLE) {
             assert(pipeline != VK_NULL_HANDLE);
-            vkDestroyPipelineLayout(g_ctx.vk.device, layout, nullptr);
+            g_ctx.pipelines.releaseLayout(layout);
             layout = VK_NULL_HANDLE;
-            vkDestroyPipeline(g_ctx.vk.device, pipeline, nullptr);
+            g_ctx.pipelines.releasePipeline(pipeline);
             pipeline = VK_NULL_HANDLE;
         } else {
             assert(pipeline == VK_NULL_HANDLE);
         }
+        if (reloaded != VK_NULL_HANDLE) {
+            g_ctx.pipelines.releasePipeline(reloaded);
+            reloaded = VK_NULL_HANDLE;
+        }
         if (param_buf.id != uuid::nil_uuid()) {
             Vk::Buffer::Delete(g_ctx.vk, param_buf);
         }
@@ -110,24 +175,26 @@ struct Pipeline {
         multisampling.alphaToOneEnable      = VK_FALSE; // Optional
         return multisampling;
     }
-    static VkPipelineShaderStageCreateInfo shaderStageDefault(VkShaderModule shaderModule, VkShaderStageFlagBits stage)
+    static VkPipelineShaderStageCreateInfo shaderStageDefault(
+        VkShaderModule shaderModule,
+        VkShaderStageFlagBits stage,
+        const VkSpecializationInfo* specialization = nullptr)
     {
         VkPipelineShaderStageCreateInfo info {};
-        info.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        info.stage  = stage;
-        info.module = shaderModule;
-        info.pName  = "main";
+        info.sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        info.stage               = stage;
+        info.module              = shaderModule;
+        info.pName               = "main";
+        info.pSpecializationInfo = specialization;
         return info;
     }
 
-    void initLayout(const std::vector<VkDescriptorSetLayout>& layouts)
+    // layouts and pipelines are shared through g_ctx.pipelines, never destroy them directly
+    void initLayout(const std::vector<VkDescriptorSetLayout>& layouts, const std::vector<VkPushConstantRange>& push_constants = {})
     {
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
-        pipelineLayoutInfo.sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = layouts.size();
-        pipelineLayoutInfo.pSetLayouts    = layouts.data();
-        if (vkCreatePipelineLayout(g_ctx.vk.device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create pipeline layout!");
-        }
+        // layouts don't depend on the shader code, a shader reload keeps the current one
+        if (layout != VK_NULL_HANDLE)
+            return;
+        layout = g_ctx.pipelines.getLayout(layouts, push_constants);
     }
 };
@@ -1,4 +1,8 @@
 #include "render_graph.h"
+#include "core/tool/logger.h"
+#include "core/tool/thread_pool.h"
+#include <algorithm>
+#include <filesystem>
 #include <queue>
 
 void RenderGraph::clearAttachments()
@@ -60,6 +64,82 @@ void RenderGraph::initGraph()
     }
 }
 
+void RenderGraph::initNodes(Configuration& cfg)
+{
+    std::vector<std::function<void()>> tasks;
+    for (auto& node : nodes) {
+        node.second->init(cfg, attachments);
+        for (auto& task : node.second->pipelineTasks()) {
+            tasks.emplace_back(std::move(task));
+        }
+    }
+    if (tasks.empty())
+        return;
+
+    ThreadPool pool(std::min<uint32_t>(tasks.size(), std::thread::hardware_concurrency()));
+    std::vector<std::future<void>> futures;
+    futures.reserve(tasks.size());
+    for (auto& task : tasks) {
+        futures.emplace_back(pool.submit(std::move(task)));
+    }
+    // join everything before rethrowing, the other tasks still reference the nodes
+    for (auto& future : futures) {
+        future.wait();
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    g_ctx.pipelines.logStatistics();
+
+    JSON_GET(RenderGraphConfiguration, rg_cfg, cfg, "render_graph");
+    if (rg_cfg.shader_hot_reload) {
+        if (!cfg.contains("engine_directory"))
+            throw std::runtime_error("shader_hot_reload needs engine_directory to locate the shader sources");
+        auto source_directory = std::filesystem::path(cfg.at("engine_directory").get<std::string>()) / "function/render/render_graph";
+        shader_watcher        = std::make_unique<ShaderWatcher>(source_directory, rg_cfg.shader_directory, [this] { rebuildPipelines(); });
+    }
+}
+
+void RenderGraph::rebuildPipelines()
+{
+    // unchanged pipelines are cache hits in g_ctx.pipelines, so rebuilding everything is cheap
+    for (auto& node : nodes) {
+        for (auto& task : node.second->pipelineTasks()) {
+            task();
+        }
+    }
+}
+
+void RenderGraph::swapReloadedPipelines()
+{
+    frame_index++;
+    while (!retired_pipelines.empty() && retired_pipelines.front().first + g_ctx.vk.MAX_FRAMES_IN_FLIGHT <= frame_index) {
+        for (VkPipeline pipeline : retired_pipelines.front().second) {
+            g_ctx.pipelines.releasePipeline(pipeline);
+        }
+        retired_pipelines.pop_front();
+    }
+
+    if (!shader_watcher || !shader_watcher->hasRebuilt())
+        return;
+    std::vector<VkPipeline> retired;
+    for (auto& node : nodes) {
+        for (PipelineHandles* handles : node.second->pipelines()) {
+            handles->swapReloaded(retired);
+        }
+    }
+    retired_pipelines.emplace_back(frame_index, std::move(retired));
+    shader_watcher->markSwapped();
+    INFO_ALL("Swapped in reloaded shaders");
+}
+
+std::unique_lock<std::mutex> RenderGraph::pauseShaderReload()
+{
+    if (!shader_watcher)
+        return {};
+    return std::unique_lock<std::mutex>(shader_watcher->buildMutex());
+}
+
 void RenderGraph::initAttachments()
 {
     std::unordered_map<std::string, RenderAttachmentDescription> descriptions;
@@ -96,6 +176,9 @@ void RenderGraph::prepareAttachmentsForNode(const auto& node, uint32_t swapchain
 
 void RenderGraph::record(uint32_t swapchain_index)
 {
+    // frame boundary, nothing of this frame has been recorded yet
+    swapReloadedPipelines();
+
     VkCommandBufferBeginInfo beginInfo {};
     beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
@@ -150,6 +233,13 @@ void RenderGraph::onResize()
 
 void RenderGraph::destroy()
 {
+    shader_watcher.reset();
+    for (auto& retired : retired_pipelines) {
+        for (VkPipeline pipeline : retired.second) {
+            g_ctx.pipelines.releasePipeline(pipeline);
+        }
+    }
+    retired_pipelines.clear();
     for (auto& node : nodes)
         node.second->destroy();
     attachments.cleanup();
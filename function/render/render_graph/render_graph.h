@@ -4,7 +4,10 @@
 #include "function/render/render_graph/node/node.h"
 #include "function/render/render_graph/render_attachments.h"
 #include "function/render/render_graph/render_graph_node.h"
+#include "function/render/render_graph/shader_watcher.h"
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -19,8 +22,19 @@ protected:
     std::unordered_map<std::string, int> in_degree;
     std::vector<std::string> starting_nodes;
 
+    // only set when render_graph.shader_hot_reload is enabled
+    std::unique_ptr<ShaderWatcher> shader_watcher;
+    // pipelines replaced by a shader reload, released once the frames using them have finished
+    std::deque<std::pair<uint64_t, std::vector<VkPipeline>>> retired_pipelines;
+    uint64_t frame_index = 0;
+
     virtual void clearAttachments();
     void initGraph();
+    // init all the nodes, then build their pipelines in parallel
+    void initNodes(Configuration& cfg);
+    // runs on the shader watcher thread
+    void rebuildPipelines();
+    void swapReloadedPipelines();
     void prepareAttachmentsForNode(const auto& node, uint32_t swapchain_index);
     void initAttachments();
 
@@ -31,6 +45,8 @@ public:
     virtual void record(uint32_t swapchain_index);
     virtual void onResize();
     virtual void destroy();
+    // keeps a shader reload from building pipelines while the swapchain is recreated
+    std::unique_lock<std::mutex> pauseShaderReload();
 
     // after init
     virtual VkRenderPass getUIRenderpass() { return nullptr; }
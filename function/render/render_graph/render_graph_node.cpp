@@ -168,11 +168,11 @@ VkRenderPass RenderGraphNode::MultiSubpassRenderPass(
     return render_pass;
 }
 
-void RenderGraphNode::bindDescriptorSet(uint32_t index, VkPipelineLayout layout, VkDescriptorSet* set)
+void RenderGraphNode::bindDescriptorSet(uint32_t index, VkPipelineLayout layout, VkDescriptorSet* set, VkPipelineBindPoint bind_point)
 {
     vkCmdBindDescriptorSets(
         g_ctx.vk.commandBuffer,
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        bind_point,
         layout,
         index,
         1,
@@ -3,6 +3,7 @@
 #include "core/config/config.h"
 #include "function/render/render_graph/pipeline.hpp"
 #include "function/render/render_graph/render_attachment_description.h"
+#include <functional>
 #include <string>
 #include <unordered_map>
 
@@ -32,7 +33,7 @@ protected:
         const std::unordered_map<std::string, RenderAttachmentDescription>& attachment_info_map,
         const std::vector<AttachmentDescriptionHelper>& attachment_configs,
         const std::vector<VkSubpassDependency>& dependencies);
-    void bindDescriptorSet(uint32_t index, VkPipelineLayout layout, VkDescriptorSet* set);
+    void bindDescriptorSet(uint32_t index, VkPipelineLayout layout, VkDescriptorSet* set, VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS);
     void setDefaultViewportAndScissor();
     Vk::Image* getAttachmentByName(const std::string& name, RenderAttachments* attachments, int swapchain_index);
 
@@ -42,6 +43,11 @@ public:
     virtual ~RenderGraphNode() = default;
 
     virtual void init(Configuration& cfg, RenderAttachments& attachments) = 0;
+    // Pipeline builds of this node, called after init(). The graph runs them on worker threads,
+    // so a task may only create shader modules, pipeline layouts and pipelines.
+    virtual std::vector<std::function<void()>> pipelineTasks() { return {}; }
+    // Pipelines built by pipelineTasks(), swapped by the graph when their shaders are hot-reloaded
+    virtual std::vector<PipelineHandles*> pipelines() { return {}; }
     virtual void record(uint32_t swapchain_index)                         = 0;
     virtual void onResize()                                               = 0;
     virtual void destroy()                                                = 0;
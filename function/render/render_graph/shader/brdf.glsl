@@ -0,0 +1,28 @@
+// Cook-Torrance terms shared by the forward object passes and DeferredLighting: GGX distribution D,
+// Schlick Fresnel F and Schlick-GGX geometry G with k = (roughness + 1)^2 / 8
+
+const float PI = 3.14159265359;
+
+float D(vec3 h, vec3 normal, float roughness)
+{
+    float numerator = roughness * roughness;
+    float dot_h_n = max(dot(normalize(normal), h), 0.0);
+    float denominator = dot_h_n * dot_h_n * (roughness * roughness - 1) + 1;
+    denominator = PI * denominator * denominator;
+    return numerator / denominator;
+}
+
+vec3 F(vec3 F0, vec3 h, vec3 w_e)
+{
+    return F0 + (1 - F0) * pow(1 - max(dot(w_e, h), 0.0), 5);
+}
+
+float G(vec3 w_e, vec3 w_i, vec3 normal, float k)
+{
+    float dot_w_e_n = dot(w_e, normalize(normal));
+    float g1 = dot_w_e_n / (dot_w_e_n * (1 - k) + k);
+
+    float dot_w_i_n = dot(w_i, normalize(normal));
+    float g2 = dot_w_i_n / (dot_w_i_n * (1 - k) + k);
+    return g1 * g2;
+}
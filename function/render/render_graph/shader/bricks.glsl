@@ -0,0 +1,60 @@
+// Sparse bricked fields, built by Field::updateFieldImage: the field's voxels in cubes of size voxels
+// along an edge, x fastest, and only the bricks holding a voxel other than zero stored in an atlas.
+// slots[b] is brick b's position in the atlas in bricks, 10 bits per axis, or EMPTY_BRICK. An atlas
+// brick keeps the one voxel ring around it, so the sampler filters across brick edges as it would in
+// the dense field. A field with brick size 0 is dense, its image holds the voxels themselves
+
+layout(set = BindlessDescriptorSet, binding = BindlessStorageBinding) readonly buffer Bricks
+{
+    uint slots[];
+}
+GetLayoutVariableName(bricks)[];
+
+const uint EMPTY_BRICK = 0xffffffffu;
+
+ivec3 brickCount(ivec3 voxels, uint size)
+{
+    return (voxels + int(size) - 1) / int(size);
+}
+
+uint brickSlot(Handle table, ivec3 voxels, uint size, ivec3 brick)
+{
+    ivec3 count = brickCount(voxels, size);
+    return GetResource(bricks, table).slots[(brick.z * count.y + brick.y) * count.x + brick.x];
+}
+
+// the atlas texel of the first voxel of the brick in slot, past its ring
+ivec3 brickOrigin(uint slot, uint size)
+{
+    return ivec3(slot & 0x3ffu, (slot >> 10) & 0x3ffu, slot >> 20) * int(size + 2) + 1;
+}
+
+// the stored value at uvw, filtered. A point outside the field blends in the zero border as the dense
+// field's sampler does
+float fieldSample(sampler3D image, Handle table, uint size, ivec3 voxels, vec3 uvw)
+{
+    if (size == 0)
+        return textureLod(image, uvw, 0.0).r;
+
+    vec3 position = uvw * vec3(voxels);
+    ivec3 brick = clamp(ivec3(floor(position / float(size))), ivec3(0), brickCount(voxels, size) - 1);
+    uint slot = brickSlot(table, voxels, size, brick);
+    if (slot == EMPTY_BRICK)
+        return 0.0;
+    // kept within the ring, the filter mustn't reach the next brick of the atlas
+    vec3 local = clamp(position - vec3(brick * int(size)), vec3(0.0), vec3(size));
+    return textureLod(image, (vec3(brickOrigin(slot, size)) + local) / vec3(textureSize(image, 0)), 0.0).r;
+}
+
+// the stored value of voxel, inside the field
+float fieldTexel(sampler3D image, Handle table, uint size, ivec3 voxels, ivec3 voxel)
+{
+    if (size == 0)
+        return texelFetch(image, voxel, 0).r;
+
+    ivec3 brick = voxel / int(size);
+    uint slot = brickSlot(table, voxels, size, brick);
+    if (slot == EMPTY_BRICK)
+        return 0.0;
+    return texelFetch(image, brickOrigin(slot, size) + voxel - brick * int(size), 0).r;
+}
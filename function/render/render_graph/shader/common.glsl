@@ -20,6 +20,60 @@ layout(set = BindlessDescriptorSet, binding = BindlessSamplerBinding)
 
 #define Handle uint
 
+// VertexFormat in function/type/vertex.h
+#define VertexFormatFloat 0
+#define VertexFormatPacked 1
+#define VertexFormatQuantized 2
+
+// Object::Param in function/type/object.h
+struct ObjectParam
+{
+    mat4 model;
+    mat4 modelInvTrans;
+    vec4 positionOffset;
+    vec4 positionScale;
+    Handle material;
+    Handle vertBuf;
+    uint vertexFormat;
+    int vertexOffset;
+};
+
+// ObjectBuffer, indexed like g_ctx.rm->objects
+layout(set = BindlessDescriptorSet, binding = BindlessStorageBinding) readonly buffer Objects
+{
+    ObjectParam params[];
+}
+objectBuffers[];
+
+// IndirectDraw's instance table, the object drawn by every slot
+layout(set = BindlessDescriptorSet, binding = BindlessStorageBinding) readonly buffer InstanceObjects
+{
+    uint objects[];
+}
+instanceBuffers[];
+
+#define GetObjectParam(objects, index) objectBuffers[objects].params[index]
+// indirect draws put the slot in gl_InstanceIndex, or gl_InstanceIndex / instances with several per object
+#define GetInstanceObject(instances, slot) instanceBuffers[instances].objects[slot]
+
+// Quantized positions are unorm16 in the mesh AABB, the other formats have offset 0 and scale 1
+vec3 decodePosition(vec3 position, vec4 offset, vec4 scale)
+{
+    return offset.xyz + scale.xyz * position;
+}
+
+// The packed formats store normals and tangents octahedral encoded in the first two components
+vec3 decodeDirection(vec3 direction, uint format)
+{
+    if (format == VertexFormatFloat)
+        return direction;
+    vec3 n = vec3(direction.xy, 1.0 - abs(direction.x) - abs(direction.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 const float gamma = 2.2;
 const float exposure = 1.0;
 
@@ -0,0 +1,18 @@
+// G-buffer of the deferred path, written by GBuffer and read by DeferredLighting:
+// normal   R16G16B16A16_SFLOAT  octahedral world normal, roughness, metallic
+// albedo   R8G8B8A8_SRGB        linear albedo, ambient occlusion
+// and the depth attachment, the world position is unprojected from it
+
+vec2 encodeGBufferNormal(vec3 normal)
+{
+    normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+    vec2 encoded = normal.xy;
+    if (normal.z < 0.0)
+        encoded = (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+    return encoded;
+}
+
+vec3 decodeGBufferNormal(vec2 encoded)
+{
+    return decodeDirection(vec3(encoded, 0.0), VertexFormatPacked);
+}
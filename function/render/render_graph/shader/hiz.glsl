@@ -0,0 +1,25 @@
+// Hi-Z pyramid of OcclusionCulling: the max depth of every level in one float buffer. Level 0 is the
+// depth attachment halved (rounding up), every next level halves the previous one down to 1x1, so
+// pixel p of the attachment falls in texel p >> (level + 1)
+
+layout(set = BindlessDescriptorSet, binding = BindlessStorageBinding) buffer HiZPyramid
+{
+    float depth[];
+}
+GetLayoutVariableName(pyramid)[];
+
+uvec2 hizLevelSize(uvec2 size, uint level)
+{
+    uint shift = level + 1;
+    return max((size + (1u << shift) - 1u) >> shift, uvec2(1));
+}
+
+uint hizLevelOffset(uvec2 size, uint level)
+{
+    uint offset = 0;
+    for (uint i = 0; i < level; i++) {
+        uvec2 levelSize = hizLevelSize(size, i);
+        offset += levelSize.x * levelSize.y;
+    }
+    return offset;
+}
@@ -0,0 +1,47 @@
+// Light clusters of LightCulling: the screen in tiles of tileSize pixels, every tile cut into sliceCount
+// view depth slices, exponential from near to far. The first slice reaches the eye and the last one
+// runs to infinity, so every fragment falls in one. Cluster c holds the fire lights
+// indices[ranges[c].x, ranges[c].x + ranges[c].y), ALL_CLUSTER_LIGHTS when the index list ran out
+
+#define ALL_CLUSTER_LIGHTS 0xffffffffu
+
+layout(set = BindlessDescriptorSet, binding = BindlessStorageBinding) buffer LightClusters
+{
+    uint tileSize;
+    uint tilesX;
+    uint tilesY;
+    uint sliceCount;
+    float near;
+    float far;
+    uint capacity;
+    float cutoff;
+    uvec2 ranges[];
+}
+GetLayoutVariableName(lightClusters)[];
+
+layout(set = BindlessDescriptorSet, binding = BindlessStorageBinding) buffer LightClusterIndices
+{
+    uint indices[];
+}
+GetLayoutVariableName(lightClusterIndices)[];
+
+uint clusterSlice(float depth, float near, float far, uint sliceCount)
+{
+    float slice = log(max(depth, 1e-6) / near) / log(far / near) * float(sliceCount);
+    return uint(clamp(slice, 0.0, float(sliceCount - 1)));
+}
+
+// the fraction of a light's 1 / d^2 falloff kept at distance d, fades to 0 at its radius so the cut
+// doesn't show
+float clusterLightWindow(float dist, float radius)
+{
+    float ratio = dist / max(radius, 1e-6);
+    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    return window * window;
+}
+
+// where the light of this intensity falls below cutoff
+float clusterLightRadius(vec3 intensity, float cutoff)
+{
+    return sqrt(max(max(intensity.r, intensity.g), intensity.b) / cutoff);
+}
@@ -0,0 +1,13 @@
+// Light transmittance volume of LightTransmittance: the transmittance from the points of the fields'
+// union box to every scene light, resolution texels along each axis per light with the lights stacked
+// along z. Texel centers are the points its pass marched from
+
+vec3 lightTransmittance(sampler3D volume, vec3 bmin, vec3 bmax, vec3 position, int light)
+{
+    ivec3 size = textureSize(volume, 0);
+    float resolution = float(size.x);
+    // clamped into the light's slab, the filter mustn't blend in the next light
+    vec3 uvw = clamp((position - bmin) / (bmax - bmin), vec3(0.5 / resolution), vec3(1.0 - 0.5 / resolution));
+    uvw.z = (uvw.z + float(light)) / float(size.z / size.x);
+    return textureLod(volume, uvw, 0.0).rgb;
+}
@@ -0,0 +1,189 @@
+// The compute pass of LightTransmittance, see light_transmittance.glsl. A field pass' transmittance.comp
+// declares FIELD_COUNT, MAX_FIELDS and its map_density, includes bricks.glsl and macrocells.glsl, then
+// this. A thread marches from the center of one texel towards its light the way the field pass'
+// secondary rays did
+
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+const float EPSILON = 0.0001;
+const float MAX = 100000000;
+const float MIN = -100000000;
+
+struct Light {
+    vec3 posOrDir;
+    vec3 intensity;
+};
+
+struct AABB {
+    vec3 bmin;
+    vec3 bmax;
+};
+
+struct FieldData {
+    mat4x4 to_local_uvw;
+    vec3 scatter;
+    int type;
+    vec3 absorption;
+    uint macrocell_size;
+    AABB aabb;
+    float scale;
+    float bias;
+    uint brick_size;
+    ivec3 dimension;
+};
+
+layout(set = BindlessDescriptorSet, binding = BindlessUniformBinding) uniform FieldDataArray
+{
+    FieldData data;
+}
+GetLayoutVariableName(field_data_arr)[];
+
+layout(set = BindlessDescriptorSet, binding = BindlessStorageBinding) readonly buffer Lights
+{
+    Light data[];
+}
+GetLayoutVariableName(lights)[];
+
+layout(set = BindlessDescriptorSet, binding = BindlessSamplerBinding)
+    uniform sampler3D GetLayoutVariableName(field_image_sampler)[];
+
+// the texels as half floats, copied into the volume after the pass
+layout(set = BindlessDescriptorSet, binding = BindlessStorageBinding) writeonly buffer TransmittanceTexels
+{
+    uvec2 texels[];
+}
+GetLayoutVariableName(transmittance_texels)[];
+
+layout(set = 1, binding = 0) uniform FieldParam
+{
+    Handle attr[MAX_FIELDS];
+    Handle img[MAX_FIELDS];
+    Handle macrocells[MAX_FIELDS];
+    Handle bricks[MAX_FIELDS];
+}
+fieldParam;
+
+layout(push_constant) uniform PushConstants
+{
+    Handle lights;
+    Handle texels;
+    uint resolution;
+    float step;
+}
+volume;
+
+#define lights GetResource(lights, volume.lights)
+#define field_data_arr(index) GetResource(field_data_arr, fieldParam.attr[index])
+#define field_image_sampler(index) GetResource(field_image_sampler, fieldParam.img[index])
+
+float random(float x)
+{
+    float y = fract(sin(x) * 100000.0);
+    return y;
+}
+
+bool intersect_aabb(vec3 origin, vec3 dir, in AABB aabb, out float tentry, out float texit)
+{
+    vec3 t_min = (aabb.bmin - origin) / (dir + EPSILON);
+    vec3 t_max = (aabb.bmax - origin) / (dir + EPSILON);
+    vec3 t_entry = min(t_min, t_max);
+    vec3 t_exit = max(t_min, t_max);
+    tentry = max(t_entry.x, max(t_entry.y, t_entry.z));
+    texit = min(t_exit.x, min(t_exit.y, t_exit.z));
+    return tentry <= texit && texit >= 0;
+}
+
+// the value of field i at uvw, stored as (value - bias) / scale, see FieldConfiguration::format
+float sample_field(int i, vec3 uvw)
+{
+    uint size = field_data_arr(i).data.brick_size;
+    float value = fieldSample(field_image_sampler(i), fieldParam.bricks[i], size, field_data_arr(i).data.dimension, uvw);
+    return value * field_data_arr(i).data.scale + field_data_arr(i).data.bias;
+}
+
+// how far from t the march meets no density of field i, 0 when its macrocell may hold some
+float empty_distance(int i, vec3 local_origin, vec3 local_ray, float t)
+{
+    ivec3 voxels = field_data_arr(i).data.dimension;
+    uint size = field_data_arr(i).data.macrocell_size;
+    vec3 uvw = local_origin + local_ray * t;
+    vec2 range = macrocellRange(fieldParam.macrocells[i], voxels, size, uvw);
+    int type = field_data_arr(i).data.type;
+    if (map_density(range.x, type) != 0.0 || map_density(range.y, type) != 0.0)
+        return 0.0;
+    return macrocellExit(voxels, size, uvw, local_ray);
+}
+
+vec3 transmittance_to(vec3 origin, Light light)
+{
+    vec3 ray = normalize(light.posOrDir - origin);
+    float step = volume.step;
+
+    float t_entry = MAX, t_exit = MIN;
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        float t_entry_i = 0.0, t_exit_i = 0.0;
+
+        intersect_aabb(origin, ray, field_data_arr(i).data.aabb, t_entry_i, t_exit_i);
+        t_entry = min(t_entry, t_entry_i);
+        t_exit = max(t_exit, t_exit_i);
+    }
+
+    vec3 local_rays[MAX_FIELDS];
+    vec3 local_origins[MAX_FIELDS];
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        local_rays[i] = (field_data_arr(i).data.to_local_uvw * vec4(ray, 0.0)).xyz;
+        local_origins[i] = (field_data_arr(i).data.to_local_uvw * vec4(origin, 1.0)).xyz;
+    }
+
+    float t = max(t_entry, 0.0);
+    vec3 sigma_t_density_sum = vec3(0.0);
+    while (true) {
+        float t_sample = t + random(t) * step;
+        if (t > t_exit)
+            break;
+
+        // the whole steps inside macrocells empty in every field sample nothing
+        float empty = MAX;
+        for (int i = 0; i < FIELD_COUNT; i++)
+            empty = min(empty, empty_distance(i, local_origins[i], local_rays[i], t));
+        if (empty >= step) {
+            t += floor(empty / step) * step;
+            continue;
+        }
+
+        for (int i = 0; i < FIELD_COUNT; i++) {
+            vec3 sample_point = local_origins[i] + local_rays[i] * t_sample;
+            float density = sample_field(i, sample_point);
+            sigma_t_density_sum += map_density(density, field_data_arr(i).data.type) * (field_data_arr(i).data.scatter + field_data_arr(i).data.absorption);
+        }
+
+        t += step;
+    }
+    return exp(-sigma_t_density_sum * step);
+}
+
+void main()
+{
+    uvec3 texel = gl_GlobalInvocationID;
+    uint lightCount = max(uint(lights.data.length()), 1u);
+    if (texel.x >= volume.resolution || texel.y >= volume.resolution || texel.z >= volume.resolution * lightCount)
+        return;
+
+    AABB box = field_data_arr(0).data.aabb;
+    for (int i = 1; i < FIELD_COUNT; i++) {
+        box.bmin = min(box.bmin, field_data_arr(i).data.aabb.bmin);
+        box.bmax = max(box.bmax, field_data_arr(i).data.aabb.bmax);
+    }
+    uint light = texel.z / volume.resolution;
+    vec3 cell = vec3(texel.x, texel.y, texel.z % volume.resolution);
+    vec3 origin = mix(box.bmin, box.bmax, (cell + 0.5) / float(volume.resolution));
+
+    // no lights, one slab left fully lit
+    vec3 transmittance = vec3(1.0);
+    if (light < uint(lights.data.length()))
+        transmittance = transmittance_to(origin, lights.data[light]);
+
+    uint index = (texel.z * volume.resolution + texel.y) * volume.resolution + texel.x;
+    GetResource(transmittance_texels, volume.texels).texels[index]
+        = uvec2(packHalf2x16(transmittance.rg), packHalf2x16(vec2(transmittance.b, 1.0)));
+}
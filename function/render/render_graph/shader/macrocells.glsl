@@ -0,0 +1,32 @@
+// Macrocell grid of a field, built by MacrocellGrid: the field's voxels in cubes of size voxels along
+// an edge, x fastest. ranges[c] is the min and max of the voxels a trilinear sample inside macrocell c
+// can blend, the one voxel ring around it included and the zero border for the macrocells at the edge.
+// A march can step over a macrocell whose range maps to no density
+
+layout(set = BindlessDescriptorSet, binding = BindlessStorageBinding) buffer Macrocells
+{
+    vec2 ranges[];
+}
+GetLayoutVariableName(macrocells)[];
+
+ivec3 macrocellCount(ivec3 voxels, uint size)
+{
+    return (voxels + int(size) - 1) / int(size);
+}
+
+// the range around uvw, a point outside the field gets the macrocell at its edge
+vec2 macrocellRange(Handle cells, ivec3 voxels, uint size, vec3 uvw)
+{
+    ivec3 count = macrocellCount(voxels, size);
+    ivec3 cell = clamp(ivec3(floor(uvw * vec3(voxels) / float(size))), ivec3(0), count - 1);
+    return GetResource(macrocells, cells).ranges[(cell.z * count.y + cell.y) * count.x + cell.x];
+}
+
+// how far along ray, in the field's uvw space, uvw is from leaving its macrocell
+float macrocellExit(ivec3 voxels, uint size, vec3 uvw, vec3 ray)
+{
+    vec3 scale = vec3(voxels) / float(size);
+    vec3 bound = (floor(uvw * scale) + step(0.0, ray)) / scale;
+    vec3 t = mix((bound - uvw) / ray, vec3(1e8), lessThan(abs(ray), vec3(1e-8)));
+    return min(t.x, min(t.y, t.z));
+}
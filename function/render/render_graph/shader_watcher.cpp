@@ -0,0 +1,108 @@
+#include "shader_watcher.h"
+#include "core/tool/logger.h"
+#include "core/tool/sh.h"
+#include <vector>
+
+namespace fs = std::filesystem;
+
+ShaderWatcher::ShaderWatcher(const fs::path& source_directory, const fs::path& shader_directory, std::function<void()> rebuild)
+    : source_directory(source_directory)
+    , shader_directory(shader_directory)
+    , rebuild(std::move(rebuild))
+{
+    if (!fs::is_directory(source_directory / "node"))
+        throw std::runtime_error("shader hot reload: no node directory in " + source_directory.string());
+
+    // the first pass only records the timestamps
+    compileChanged();
+    thread = std::thread(&ShaderWatcher::run, this);
+    INFO_ALL("Watching shaders in {}", source_directory.string());
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    thread.join();
+}
+
+void ShaderWatcher::run()
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (cv.wait_for(lock, POLL_INTERVAL, [this] { return stopping; }))
+                return;
+        }
+        // the previous rebuild hasn't been swapped in yet
+        if (hasRebuilt())
+            continue;
+        if (!compileChanged())
+            continue;
+
+        std::lock_guard<std::mutex> lock(build_mutex);
+        try {
+            rebuild();
+        } catch (const std::exception& e) {
+            ERROR_ALL("Shader reload failed: {}", e.what());
+        }
+        rebuilt.store(true, std::memory_order_release);
+    }
+}
+
+bool ShaderWatcher::changed(const fs::path& path)
+{
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec);
+    if (ec)
+        return false;
+    auto [it, inserted] = timestamps.try_emplace(path.string(), time);
+    if (inserted || it->second == time)
+        return false;
+    it->second = time;
+    return true;
+}
+
+bool ShaderWatcher::compileChanged()
+{
+    // a change in the shared includes recompiles every shader
+    bool common_changed = false;
+    for (const auto& entry : fs::directory_iterator(source_directory / "shader")) {
+        common_changed |= changed(entry.path());
+    }
+
+    std::vector<fs::path> sources;
+    for (const auto& node_dir : fs::directory_iterator(source_directory / "node")) {
+        if (!node_dir.is_directory())
+            continue;
+        // and a change in a node's own includes (e.g. density.glsl) recompiles the node's shaders
+        bool node_changed = common_changed;
+        for (const auto& entry : fs::directory_iterator(node_dir.path())) {
+            if (entry.path().extension() == ".glsl")
+                node_changed |= changed(entry.path());
+        }
+        for (const auto& entry : fs::directory_iterator(node_dir.path())) {
+            auto ext = entry.path().extension();
+            if (ext != ".vert" && ext != ".frag" && ext != ".geom" && ext != ".comp")
+                continue;
+            if (changed(entry.path()) || node_changed)
+                sources.emplace_back(entry.path());
+        }
+    }
+
+    bool compiled = false;
+    for (const auto& source : sources) {
+        // same layout as the build: <shader_directory>/<node>/<file>.spv
+        auto out = shader_directory / source.parent_path().filename() / (source.filename().string() + ".spv");
+        if (glslc(source, out)) {
+            INFO_ALL("Recompiled {}", source.string());
+            compiled = true;
+        } else {
+            ERROR_ALL("Failed to compile {}, keeping the previous version", source.string());
+        }
+    }
+    return compiled;
+}
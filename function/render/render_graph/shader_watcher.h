@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Polls the GLSL sources of the render graph on a background thread. Changed shaders are
+// recompiled into the shader directory, then `rebuild` runs on the same thread. The render
+// thread picks the result up with hasRebuilt() and acknowledges it with markSwapped().
+class ShaderWatcher {
+    void run();
+    bool compileChanged();
+    bool changed(const std::filesystem::path& path);
+
+    std::filesystem::path source_directory;
+    std::filesystem::path shader_directory;
+    std::function<void()> rebuild;
+    std::unordered_map<std::string, std::filesystem::file_time_type> timestamps;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    std::mutex build_mutex;
+    std::atomic<bool> rebuilt = false;
+
+public:
+    static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(500);
+
+    // source_directory is the render graph directory holding node/ and shader/
+    ShaderWatcher(
+        const std::filesystem::path& source_directory,
+        const std::filesystem::path& shader_directory,
+        std::function<void()> rebuild);
+    ~ShaderWatcher();
+
+    bool hasRebuilt() const { return rebuilt.load(std::memory_order_acquire); }
+    void markSwapped() { rebuilt.store(false, std::memory_order_release); }
+    // held while rebuilding, lock it around anything the pipeline builds read (e.g. the swapchain)
+    std::mutex& buildMutex() { return build_mutex; }
+};
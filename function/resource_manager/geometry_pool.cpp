@@ -0,0 +1,90 @@
+#include "geometry_pool.h"
+#include "core/tool/logger.h"
+#include "function/global_context.h"
+#include "function/tool/vertex_packer.h"
+#include <limits>
+
+using namespace Vk;
+
+void GeometryPool::build(std::unordered_map<std::string, Mesh>& meshes, VertexFormat format)
+{
+    size_t vertex_count = 0;
+    size_t index_count  = 0;
+    bool narrow         = true;
+    for (const auto& [name, mesh] : meshes) {
+        vertex_count += mesh.data.vertices.size();
+        index_count += mesh.data.indices.size();
+        for (const auto& submesh : mesh.submeshes) {
+            narrow = narrow && submesh.vertexCount <= std::numeric_limits<uint16_t>::max();
+        }
+    }
+    if (vertex_count == 0 || index_count == 0)
+        return;
+    if (vertex_count > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+        throw std::runtime_error("too many vertices for one geometry pool");
+    indexType = narrow ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+    // the CPU copies stay float and 32-bit, only the GPU buffers use the compact layouts
+    const size_t stride     = Vertex::getBindingDescription(format).stride;
+    const size_t index_size = narrow ? sizeof(uint16_t) : sizeof(uint32_t);
+    std::vector<uint8_t> vertices(vertex_count * stride);
+    std::vector<uint8_t> indices(index_count * index_size);
+    size_t vertex_offset = 0;
+    size_t index_offset  = 0;
+    for (auto& [name, mesh] : meshes) {
+        const auto packed = VertexPacker::pack(mesh.data.vertices, format, mesh.aabb);
+        std::copy(packed.begin(), packed.end(), vertices.begin() + vertex_offset * stride);
+        if (format == VertexFormat::Quantized) {
+            mesh.positionOffset = glm::vec4(mesh.aabb.bmin, 0.0f);
+            mesh.positionScale  = glm::vec4(mesh.aabb.bmax - mesh.aabb.bmin, 0.0f);
+        }
+
+        mesh.vertexOffset = static_cast<int32_t>(vertex_offset);
+        mesh.firstIndex   = static_cast<uint32_t>(index_offset);
+        // the LODs index the vertices of the full resolution submeshes
+        for (uint32_t lod = 0; lod <= mesh.lods.size(); lod++) {
+            for (const auto& submesh : mesh.lodSubmeshes(lod)) {
+                for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++) {
+                    const uint32_t index = mesh.data.indices[i] - submesh.firstVertex;
+                    if (narrow)
+                        reinterpret_cast<uint16_t*>(indices.data())[index_offset + i] = static_cast<uint16_t>(index);
+                    else
+                        reinterpret_cast<uint32_t*>(indices.data())[index_offset + i] = index;
+                }
+            }
+        }
+        vertex_offset += mesh.data.vertices.size();
+        index_offset += mesh.data.indices.size();
+    }
+
+    vertexBuffer = Buffer::New(
+        g_ctx.vk,
+        vertices.size(),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    vertexBuffer.Update(g_ctx.vk, vertices.data(), vertexBuffer.size);
+    indexBuffer = Buffer::New(
+        g_ctx.vk,
+        indices.size(),
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    indexBuffer.Update(g_ctx.vk, indices.data(), indexBuffer.size);
+
+    INFO_ALL("Geometry pool: {} meshes, {} vertices, {} indices ({}-bit), {} KB",
+             meshes.size(), vertex_count, index_count, narrow ? 16 : 32, (vertices.size() + indices.size()) >> 10);
+}
+
+void GeometryPool::bind(VkCommandBuffer cmd) const
+{
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(cmd, 0, 1, &vertexBuffer.buffer, offsets);
+    vkCmdBindIndexBuffer(cmd, indexBuffer.buffer, 0, indexType);
+}
+
+void GeometryPool::destroy()
+{
+    if (vertexBuffer.size > 0)
+        Buffer::Delete(g_ctx.vk, vertexBuffer);
+    if (indexBuffer.size > 0)
+        Buffer::Delete(g_ctx.vk, indexBuffer);
+}
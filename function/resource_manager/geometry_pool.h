@@ -0,0 +1,21 @@
+#pragma once
+
+#include "core/vulkan/type/buffer.h"
+#include "function/type/mesh.h"
+#include <string>
+#include <unordered_map>
+
+// One vertex buffer and one index buffer shared by every mesh, bound once per pass. Each submesh gets
+// its own range, its indices are relative to its first vertex and the draw adds the vertex offset.
+class GeometryPool {
+public:
+    // sub-allocates and uploads every mesh in the pool's vertex format, sets their placement
+    void build(std::unordered_map<std::string, Mesh>& meshes, VertexFormat format);
+    void bind(VkCommandBuffer cmd) const;
+    void destroy();
+
+    Vk::Buffer vertexBuffer;
+    Vk::Buffer indexBuffer;
+    // 16-bit when every submesh has under 65536 vertices
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+};
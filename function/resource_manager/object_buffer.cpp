@@ -0,0 +1,62 @@
+#include "object_buffer.h"
+#include "function/global_context.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace Vk;
+
+namespace {
+// replaces a storage buffer, keeping the bindless handle of the previous one
+void rebuild(Buffer& buffer, size_t size)
+{
+    Buffer old = buffer;
+    buffer     = Buffer::New(
+        g_ctx.vk,
+        size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    if (old.size > 0) {
+        buffer.id = old.id;
+        g_ctx.dm.updateResourceRegistration(buffer);
+        Buffer::Delete(g_ctx.vk, old);
+    } else {
+        g_ctx.dm.registerResource(buffer, DescriptorType::Storage);
+    }
+}
+}
+
+void ObjectBuffer::build(const std::vector<Object>& objects)
+{
+    rebuild(buffer, std::max<size_t>(1, objects.size()) * sizeof(Object::Param));
+    rebuild(bounds, std::max<size_t>(1, objects.size()) * sizeof(Bounds));
+    version++;
+    dirty.assign(objects.size(), true);
+    update(objects);
+}
+
+void ObjectBuffer::markDirty(uint32_t index)
+{
+    dirty[index] = true;
+}
+
+void ObjectBuffer::update(const std::vector<Object>& objects)
+{
+    assert(dirty.size() == objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (!dirty[i])
+            continue;
+        dirty[i] = false;
+        const Bounds box { objects[i].bounds.bmin, objects[i].lod, objects[i].bounds.bmax, 0.0f };
+        buffer.Update(g_ctx.vk, &objects[i].param, sizeof(Object::Param), i * sizeof(Object::Param));
+        bounds.Update(g_ctx.vk, &box, sizeof(Bounds), i * sizeof(Bounds));
+    }
+}
+
+void ObjectBuffer::destroy()
+{
+    if (buffer.size > 0)
+        Buffer::Delete(g_ctx.vk, buffer);
+    if (bounds.size > 0)
+        Buffer::Delete(g_ctx.vk, bounds);
+}
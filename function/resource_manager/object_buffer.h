@@ -0,0 +1,36 @@
+#pragma once
+
+#include "core/vulkan/type/buffer.h"
+#include "function/type/object.h"
+#include <vector>
+
+// Object::Param of every object in one storage buffer, indexed like g_ctx.rm->objects. Object passes
+// draw indirectly (see IndirectDraw) and fetch their object's Param with the index its instance table gives
+class ObjectBuffer {
+public:
+    // world space AABB of an object and the LOD it is drawn with, ObjectBounds in cull.comp
+    struct Bounds {
+        glm::vec3 bmin;
+        uint32_t lod;
+        glm::vec3 bmax;
+        float padding;
+    };
+
+    // (re)creates the buffer for the current objects, call whenever objects are added or removed.
+    // The bindless handle stays the same across rebuilds
+    void build(const std::vector<Object>& objects);
+    // the object moved or changed its LOD, the next update copies its param and bounds
+    void markDirty(uint32_t index);
+    // copies the params and bounds of the dirty objects, call while no frame is in flight
+    void update(const std::vector<Object>& objects);
+    void destroy();
+
+    Vk::Buffer buffer;
+    // Object::bounds of every object for GPU culling, same indexing and the same handle across rebuilds
+    Vk::Buffer bounds;
+    // bumped by every build, draw lists built for an older version are stale
+    uint32_t version = 0;
+
+private:
+    std::vector<bool> dirty;
+};
@@ -1,5 +1,8 @@
 #include "resource_manager.h"
+#include "core/tool/thread_pool.h"
 #include "function/global_context.h"
+#include <algorithm>
+#include <cmath>
 
 using namespace Vk;
 
@@ -13,34 +16,108 @@ void ResourceManager::load(Configuration& config)
     lights = Lights::fromConfiguration(lights_cfg);
 
     JSON_GET(std::vector<MeshConfiguration>, mesh_cfg, config, "meshes");
-    for (auto& cfg : mesh_cfg) {
-        auto mesh         = Mesh::fromConfiguration(cfg);
-        meshes[mesh.name] = mesh;
-    }
-
-    loadDefaultTextures();
     JSON_GET(std::vector<TextureConfiguration>, texture_cfg, config, "textures");
-    for (auto& cfg : texture_cfg) {
-        auto texture           = Texture::fromConfiguration(cfg);
-        textures[texture.name] = texture;
+    JSON_GET(std::vector<MaterialConfiguration>, material_cfg, config, "materials");
+    JSON_GET(std::vector<ObjectConfiguration>, objects_cfg, config, "objects");
+    if (config.contains("vertex_format")) {
+        const std::string format = config["vertex_format"];
+        if (format == "float") {
+            vertex_format = VertexFormat::Float;
+        } else if (format == "packed") {
+            vertex_format = VertexFormat::Packed;
+        } else if (format == "quantized") {
+            vertex_format = VertexFormat::Quantized;
+        } else {
+            throw std::runtime_error("vertex format not found: " + format);
+        }
+    }
+    json lod_json = config["lod"];
+    if (!lod_json.is_null()) {
+        lod_config = lod_json.get<LodConfiguration>();
+    }
+    json streaming_json = config["texture_streaming"];
+    if (!streaming_json.is_null()) {
+        texture_streamer.init(streaming_json.get<TextureStreamingConfiguration>());
     }
 
-    JSON_GET(std::vector<MaterialConfiguration>, material_cfg, config, "materials");
-    for (auto& cfg : material_cfg) {
-        auto material            = Material::fromConfiguration(cfg);
-        materials[material.name] = material;
+    // Parsing meshes and decoding images only touches the CPU, so it runs on the pool. Everything that
+    // talks to Vulkan or the descriptor manager stays on this thread and consumes the results in order.
+    // Declared after the configurations, the pool must finish its tasks before they go away.
+    ThreadPool pool(std::max<uint32_t>(1, std::min<uint32_t>(mesh_cfg.size() + texture_cfg.size(), std::thread::hardware_concurrency())));
+    std::vector<std::future<Mesh>> mesh_futures;
+    mesh_futures.reserve(mesh_cfg.size());
+    for (auto& cfg : mesh_cfg) {
+        mesh_futures.emplace_back(pool.submit([&cfg]() { return Mesh::loadFromConfiguration(cfg); }));
+    }
+    std::vector<std::future<DecodedImage>> texture_futures;
+    texture_futures.reserve(texture_cfg.size());
+    for (auto& cfg : texture_cfg) {
+        texture_futures.emplace_back(pool.submit([&cfg]() { return Texture::loadFromConfiguration(cfg); }));
     }
 
+    // independent of the loaded files, overlaps with the decoding
+    loadDefaultTextures();
     json fields_json = config["fields"];
     if (!fields_json.is_null()) {
         FieldsConfiguration fields_cfg = std::move(fields_json.get<FieldsConfiguration>());
         fields                         = Fields::fromConfiguration(fields_cfg);
     }
 
-    JSON_GET(std::vector<ObjectConfiguration>, objects_cfg, config, "objects");
+    // a material is created as soon as all of its textures are uploaded
+    std::vector<const MaterialConfiguration*> pending_materials;
+    for (const auto& cfg : material_cfg) {
+        pending_materials.emplace_back(&cfg);
+    }
+    auto createReadyMaterials = [&](bool force) {
+        std::erase_if(pending_materials, [&](const MaterialConfiguration* cfg) {
+            bool ready = force
+                || (textures.contains(cfg->color_texture)
+                    && textures.contains(cfg->metallic_texture)
+                    && textures.contains(cfg->roughness_texture)
+                    && textures.contains(cfg->normal_texture)
+                    && textures.contains(cfg->ao_texture));
+            if (!ready)
+                return false;
+            auto material            = Material::fromConfiguration(*cfg);
+            materials[material.name] = material;
+            return true;
+        });
+    };
+    createReadyMaterials(false);
+    if (texture_streamer.enabled()) {
+        for (const auto& cfg : material_cfg) {
+            texture_streamer.addMaterial(cfg);
+        }
+    }
+
+    for (size_t i = 0; i < texture_cfg.size(); i++) {
+        // streamed textures start as their mip tail, the streamer brings in the rest on demand
+        auto texture = texture_streamer.enabled()
+            ? texture_streamer.addTexture(texture_cfg[i], texture_futures[i].get())
+            : Texture::fromDecoded(texture_cfg[i].name, texture_futures[i].get());
+        textures[texture.name] = texture;
+        createReadyMaterials(false);
+    }
+    // materials naming a texture that doesn't exist, same result as before
+    createReadyMaterials(true);
+
+    for (auto& future : mesh_futures) {
+        auto mesh         = future.get();
+        meshes[mesh.name] = std::move(mesh);
+    }
+    // before the objects, they copy their mesh's placement and dequantization
+    geometry_pool.build(meshes, vertex_format);
+
     for (auto& cfg : objects_cfg) {
         objects.emplace_back(Object::fromConfiguration(cfg));
     }
+    object_buffer.build(objects);
+    std::vector<AABB> bounds;
+    bounds.reserve(objects.size());
+    for (const auto& object : objects) {
+        bounds.emplace_back(object.bounds);
+    }
+    object_bvh.build(bounds);
 
     if (config.contains("ofm")) {
         inlet_angle = config["ofm"]["inlet_angle"];
@@ -54,6 +131,37 @@ void ResourceManager::load(Configuration& config)
     recorder.init(config);
 }
 
+void ResourceManager::cullObjects()
+{
+    visible_objects.clear();
+    object_bvh.cull(Frustum::fromMatrix(camera.data.proj * camera.data.view), visible_objects);
+}
+
+void ResourceManager::selectLods()
+{
+    if (!lod_config.enable)
+        return;
+
+    const float focal = 0.5f * static_cast<float>(camera.data.height) / std::tan(0.5f * glm::radians(camera.data.fov_y));
+    for (uint32_t i : visible_objects) {
+        Object& object   = objects[i];
+        const Mesh& mesh = meshes.at(object.mesh);
+        if (mesh.lods.empty())
+            continue;
+        // the sphere around the world bounds, its diameter stands in for the diagonal the LOD errors are relative to
+        const glm::vec3 center = 0.5f * (object.bounds.bmin + object.bounds.bmax);
+        const float radius     = 0.5f * glm::length(object.bounds.bmax - object.bounds.bmin);
+        const float depth      = glm::dot(center - camera.data.eye_w, camera.data.view_dir);
+        // from inside the sphere the object can fill the screen
+        const float size = 2.0f * radius * focal / std::max(depth, radius);
+        const uint32_t lod = mesh.selectLod(size, lod_config.pixel_error, lod_config.hysteresis, object.lod);
+        if (lod != object.lod) {
+            object.lod = lod;
+            object_buffer.markDirty(i);
+        }
+    }
+}
+
 void ResourceManager::addResource(std::unique_ptr<Resource> resource)
 {
     if (resources.find(resource->name) != resources.end()) {
@@ -82,18 +190,18 @@ void ResourceManager::cleanup()
 
     camera.destroy();
     lights.destroy();
-    for (auto& mesh : meshes) {
-        mesh.second.destroy();
-    }
+    geometry_pool.destroy();
     for (auto& mat : materials) {
         mat.second.destroy();
     }
+    texture_streamer.destroy();
     for (auto& texture : textures) {
         texture.second.destroy();
     }
     for (auto& object : objects) {
         object.destroy();
     }
+    object_buffer.destroy();
 
     json fields_cfg = config["fields"];
     if (!fields_cfg.is_null()) {
@@ -2,7 +2,11 @@
 
 #include "core/config/config.h"
 #include "core/tool/recorder.h"
+#include "function/resource_manager/geometry_pool.h"
+#include "function/resource_manager/object_buffer.h"
 #include "function/resource_manager/resource.h"
+#include "function/resource_manager/texture_streamer.h"
+#include "function/tool/bvh.h"
 #include "function/type/camera.h"
 #include "function/type/field.h"
 #include "function/type/light.h"
@@ -16,10 +20,23 @@ public:
     Camera camera;
     Lights lights;
     std::unordered_map<std::string, Mesh> meshes;
+    // layout of every vertex buffer, from the top level "vertex_format"
+    VertexFormat vertex_format = VertexFormat::Float;
+    // the vertices and indices of every mesh
+    GeometryPool geometry_pool;
     std::unordered_map<std::string, Material> materials;
     std::unordered_map<std::string, Texture> textures;
+    TextureStreamer texture_streamer;
 
     std::vector<Object> objects;
+    // the param of every object, for the indirect object passes
+    ObjectBuffer object_buffer;
+    // over the objects' world bounds, refit as they move
+    BVH object_bvh;
+    // indices of the objects in the camera frustum, updated every frame by cullObjects()
+    std::vector<uint32_t> visible_objects;
+    // from the top level "lod"
+    LodConfiguration lod_config;
     Fields fields;
 
     Recorder recorder;
@@ -31,6 +48,9 @@ public:
     std::unordered_map<std::string, std::unique_ptr<Resource>> resources;
 
     void load(Configuration& config);
+    void cullObjects();
+    // picks Object::lod of the visible objects from their size on screen, after cullObjects()
+    void selectLods();
     void addResource(std::unique_ptr<Resource> resource);
     void removeResource(const std::string& name);
     void cleanup();
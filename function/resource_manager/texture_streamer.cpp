@@ -0,0 +1,264 @@
+#include "texture_streamer.h"
+#include "core/tool/logger.h"
+#include "function/global_context.h"
+#include "function/resource_manager/resource_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace Vk;
+
+void TextureStreamer::init(const TextureStreamingConfiguration& config)
+{
+    this->config = config;
+    budget       = static_cast<size_t>(config.budget_mb) << 20;
+    if (config.enable) {
+        pool = std::make_unique<ThreadPool>(LOADER_THREADS);
+        INFO_ALL("Texture streaming enabled, budget {} MB", config.budget_mb);
+    }
+}
+
+Texture TextureStreamer::addTexture(const TextureConfiguration& texture_config, const DecodedImage& decoded)
+{
+    uint32_t tail_level = 0;
+    while (tail_level + 1 < decoded.mip_levels
+           && (std::max(decoded.width, decoded.height) >> tail_level) > config.placeholder_size) {
+        tail_level++;
+    }
+    if (tail_level == 0)
+        return Texture::fromDecoded(texture_config.name, decoded);
+
+    StreamedTexture texture;
+    texture.name   = texture_config.name;
+    texture.config = texture_config;
+    texture.width  = decoded.width;
+    texture.height = decoded.height;
+    for (uint32_t level = 0; level < decoded.mip_levels; level++) {
+        texture.level_sizes.emplace_back(decoded.level_offsets[level + 1] - decoded.level_offsets[level]);
+    }
+    texture.tail_level     = tail_level;
+    texture.tail           = Texture::mipTail(decoded, tail_level);
+    texture.resident_level = tail_level;
+    texture.desired_level  = tail_level;
+    texture.coverage       = 0.0f;
+    textures.emplace_back(std::move(texture));
+
+    return Texture::fromDecoded(texture_config.name, textures.back().tail);
+}
+
+void TextureStreamer::addMaterial(const MaterialConfiguration& material_config)
+{
+    material_textures[material_config.name] = {
+        material_config.color_texture,
+        material_config.metallic_texture,
+        material_config.roughness_texture,
+        material_config.normal_texture,
+        material_config.ao_texture,
+    };
+}
+
+void TextureStreamer::update()
+{
+    if (!config.enable || textures.empty())
+        return;
+
+    finishLoads();
+    measureDemand();
+    requestLoads();
+}
+
+void TextureStreamer::destroy()
+{
+    // waits for the loads still running, their results are dropped with the textures
+    pool.reset();
+    textures.clear();
+    material_textures.clear();
+}
+
+float TextureStreamer::screenCoverage(const Object& object)
+{
+    const auto mesh = g_ctx.rm->meshes.find(object.mesh);
+    if (mesh == g_ctx.rm->meshes.end())
+        return 0.0f;
+    const auto& aabb   = mesh->second.aabb;
+    const auto& camera = g_ctx.rm->camera.data;
+
+    const glm::vec3 center = glm::vec3(object.param.model * glm::vec4(0.5f * (aabb.bmin + aabb.bmax), 1.0f));
+    float radius           = 0.0f;
+    for (uint32_t corner = 0; corner < 8; corner++) {
+        const glm::vec3 local(
+            corner & 1 ? aabb.bmax.x : aabb.bmin.x,
+            corner & 2 ? aabb.bmax.y : aabb.bmin.y,
+            corner & 4 ? aabb.bmax.z : aabb.bmin.z);
+        radius = std::max(radius, glm::distance(center, glm::vec3(object.param.model * glm::vec4(local, 1.0f))));
+    }
+
+    const float depth = glm::dot(center - camera.eye_w, camera.view_dir);
+    if (depth < -radius)
+        return 0.0f;
+    const float focal = 0.5f * static_cast<float>(camera.height) / std::tan(0.5f * glm::radians(camera.fov_y));
+    // from inside the sphere the object can fill the screen
+    return 2.0f * radius * focal / std::max(depth, radius);
+}
+
+size_t TextureStreamer::chainSize(const StreamedTexture& texture, uint32_t base_level)
+{
+    size_t size = 0;
+    for (uint32_t level = base_level; level < texture.level_sizes.size(); level++) {
+        size += texture.level_sizes[level];
+    }
+    return size;
+}
+
+size_t TextureStreamer::committedSize(const StreamedTexture& texture)
+{
+    return chainSize(texture, texture.pending.valid() ? texture.pending_level : texture.resident_level);
+}
+
+void TextureStreamer::measureDemand()
+{
+    std::unordered_map<std::string, float> material_coverage;
+    for (const auto& object : g_ctx.rm->objects) {
+        float& coverage = material_coverage[object.material];
+        coverage        = std::max(coverage, screenCoverage(object));
+    }
+    std::unordered_map<std::string, float> texture_coverage;
+    for (const auto& [material, coverage] : material_coverage) {
+        const auto names = material_textures.find(material);
+        if (names == material_textures.end())
+            continue;
+        for (const auto& name : names->second) {
+            float& texture = texture_coverage[name];
+            texture        = std::max(texture, coverage);
+        }
+    }
+
+    for (auto& texture : textures) {
+        const auto coverage   = texture_coverage.find(texture.name);
+        texture.coverage      = coverage == texture_coverage.end() ? 0.0f : coverage->second;
+        texture.desired_level = texture.tail_level;
+        if (texture.coverage > 0.0f) {
+            // assumes the UVs span the object once: one texel per pixel across its bounding sphere
+            const float texels = static_cast<float>(std::max(texture.width, texture.height));
+            const int level    = static_cast<int>(std::floor(std::log2(texels / texture.coverage)));
+            texture.desired_level = static_cast<uint32_t>(std::clamp(level, 0, static_cast<int>(texture.tail_level)));
+        }
+    }
+}
+
+void TextureStreamer::finishLoads()
+{
+    uint32_t uploads = 0;
+    for (auto& texture : textures) {
+        if (uploads == config.max_uploads_per_frame)
+            break;
+        if (!texture.pending.valid() || texture.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            continue;
+        try {
+            const auto decoded = texture.pending.get();
+            g_ctx.rm->textures.at(texture.name).replaceImage(decoded);
+            texture.resident_level = texture.pending_level;
+            uploads++;
+        } catch (const std::exception& e) {
+            // keeps what's resident and stops asking for this texture
+            WARN_ALL("Failed to stream texture {}: {}", texture.name, e.what());
+            texture.failed = true;
+        }
+    }
+}
+
+void TextureStreamer::evict(StreamedTexture& texture)
+{
+    g_ctx.rm->textures.at(texture.name).replaceImage(texture.tail);
+    texture.resident_level = texture.tail_level;
+}
+
+bool TextureStreamer::canEvictFor(const StreamedTexture& victim, const StreamedTexture& requester)
+{
+    if (&victim == &requester || victim.pending.valid() || victim.resident_level == victim.tail_level)
+        return false;
+    return victim.desired_level > victim.resident_level || victim.coverage < requester.coverage;
+}
+
+size_t TextureStreamer::committedTotal() const
+{
+    size_t total = 0;
+    for (const auto& texture : textures) {
+        total += committedSize(texture);
+    }
+    return total;
+}
+
+size_t TextureStreamer::reclaimableFor(const StreamedTexture& requester) const
+{
+    size_t reclaimable = 0;
+    for (const auto& texture : textures) {
+        if (canEvictFor(texture, requester))
+            reclaimable += chainSize(texture, texture.resident_level) - chainSize(texture, texture.tail_level);
+    }
+    return reclaimable;
+}
+
+void TextureStreamer::makeRoom(size_t bytes, const StreamedTexture& requester)
+{
+    size_t total = committedTotal();
+    while (total + bytes > budget) {
+        StreamedTexture* victim = nullptr;
+        for (auto& texture : textures) {
+            if (!canEvictFor(texture, requester))
+                continue;
+            // over-resident textures first, then the least coverage
+            const bool over = texture.desired_level > texture.resident_level;
+            if (!victim
+                || over > (victim->desired_level > victim->resident_level)
+                || (over == (victim->desired_level > victim->resident_level) && texture.coverage < victim->coverage)) {
+                victim = &texture;
+            }
+        }
+        if (!victim)
+            return;
+        total -= chainSize(*victim, victim->resident_level) - chainSize(*victim, victim->tail_level);
+        evict(*victim);
+    }
+}
+
+void TextureStreamer::requestLoads()
+{
+    std::vector<StreamedTexture*> wanting;
+    uint32_t in_flight = 0;
+    for (auto& texture : textures) {
+        if (texture.pending.valid())
+            in_flight++;
+        else if (!texture.failed && texture.desired_level < texture.resident_level)
+            wanting.emplace_back(&texture);
+    }
+    std::sort(wanting.begin(), wanting.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+        return a->coverage > b->coverage;
+    });
+
+    for (auto* texture : wanting) {
+        if (in_flight >= MAX_PENDING)
+            break;
+        const size_t committed = committedTotal();
+        const size_t available = (committed < budget ? budget - committed : 0) + reclaimableFor(*texture);
+        const size_t resident  = chainSize(*texture, texture->resident_level);
+        // settle for a coarser level when the one it wants doesn't fit
+        uint32_t level = texture->desired_level;
+        while (level < texture->resident_level && chainSize(*texture, level) - resident > available) {
+            level++;
+        }
+        if (level == texture->resident_level)
+            continue;
+        makeRoom(chainSize(*texture, level) - resident, *texture);
+
+        const auto mip_levels  = static_cast<uint32_t>(texture->level_sizes.size());
+        texture->pending_level = level;
+        texture->pending       = pool->submit([texture_config = texture->config, level, mip_levels]() {
+            auto decoded = Texture::loadFromConfiguration(texture_config);
+            if (decoded.mip_levels != mip_levels)
+                throw std::runtime_error("the mip chain changed since the scene was loaded");
+            return Texture::mipTail(decoded, level);
+        });
+        in_flight++;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "core/config/config.h"
+#include "core/tool/thread_pool.h"
+#include "function/type/texture.h"
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Object;
+
+// Keeps streamed textures at the mip level their on-screen size asks for. A texture starts as its mip
+// tail, finer levels are loaded again on a worker thread (a cache hit is a copy out of the mapped
+// .texcache) and swapped in behind the same bindless handle. Under the memory budget, the textures
+// covering the fewest pixels fall back to their tail first.
+class TextureStreamer {
+public:
+    void init(const TextureStreamingConfiguration& config);
+    bool enabled() const { return config.enable; }
+
+    // uploads the tail of a full mip chain and keeps the tail around for evictions. Textures
+    // without mips, or already as small as a placeholder, are uploaded whole and not streamed
+    Texture addTexture(const TextureConfiguration& texture_config, const DecodedImage& decoded);
+    // the textures a material samples, its objects' coverage is credited to them
+    void addMaterial(const MaterialConfiguration& material_config);
+
+    // Measures the demand, swaps in finished loads, evicts and requests. Call between frames while no
+    // frame is in flight, images are replaced and destroyed right away
+    void update();
+    void destroy();
+
+private:
+    struct StreamedTexture {
+        std::string name;
+        TextureConfiguration config;
+        uint32_t width;
+        uint32_t height;
+        // bytes of every level of the full chain
+        std::vector<size_t> level_sizes;
+        uint32_t tail_level;
+        DecodedImage tail;
+
+        uint32_t resident_level;
+        std::future<DecodedImage> pending;
+        uint32_t pending_level;
+        bool failed = false;
+
+        // recomputed every update
+        uint32_t desired_level;
+        float coverage;
+    };
+
+    // coverage of the object's bounding sphere in pixels across, 0 when it's behind the camera
+    static float screenCoverage(const Object& object);
+    static size_t chainSize(const StreamedTexture& texture, uint32_t base_level);
+    // the larger of the resident and the pending chain, what the texture holds once its load lands
+    static size_t committedSize(const StreamedTexture& texture);
+
+    void measureDemand();
+    void finishLoads();
+    void evict(StreamedTexture& texture);
+    // textures at finer levels than they need go first, then the ones covering less than the requester
+    static bool canEvictFor(const StreamedTexture& victim, const StreamedTexture& requester);
+    size_t committedTotal() const;
+    size_t reclaimableFor(const StreamedTexture& requester) const;
+    void makeRoom(size_t bytes, const StreamedTexture& requester);
+    void requestLoads();
+
+    TextureStreamingConfiguration config;
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<StreamedTexture> textures;
+    std::unordered_map<std::string, std::vector<std::string>> material_textures;
+    size_t budget = 0;
+
+    static constexpr uint32_t LOADER_THREADS = 2;
+    static constexpr uint32_t MAX_PENDING    = 2 * LOADER_THREADS;
+};
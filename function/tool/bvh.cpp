@@ -0,0 +1,122 @@
+#include "bvh.h"
+#include <algorithm>
+#include <limits>
+
+void BVH::build(const std::vector<AABB>& boxes)
+{
+    this->boxes = boxes;
+    items.resize(boxes.size());
+    for (uint32_t i = 0; i < items.size(); i++) {
+        items[i] = i;
+    }
+    item_leaf.assign(boxes.size(), 0);
+    nodes.clear();
+    nodes.reserve(2 * (boxes.size() / LEAF_SIZE + 1));
+    if (!boxes.empty())
+        buildNode(NO_PARENT, 0, static_cast<uint32_t>(boxes.size()));
+}
+
+uint32_t BVH::buildNode(uint32_t parent, uint32_t begin, uint32_t end)
+{
+    const auto index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    AABB box { .bmin = glm::vec3(std::numeric_limits<float>::max()), .bmax = glm::vec3(std::numeric_limits<float>::lowest()) };
+    AABB centers = box;
+    for (uint32_t i = begin; i < end; i++) {
+        const AABB& item       = boxes[items[i]];
+        const glm::vec3 center = 0.5f * (item.bmin + item.bmax);
+
+        box     = box.merge(item);
+        centers = centers.merge(AABB { .bmin = center, .bmax = center });
+    }
+
+    if (end - begin <= LEAF_SIZE) {
+        nodes[index] = Node { box, begin, end - begin, parent, false };
+        for (uint32_t i = begin; i < end; i++) {
+            item_leaf[items[i]] = index;
+        }
+        return index;
+    }
+
+    const glm::vec3 extent = centers.bmax - centers.bmin;
+    const int axis         = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    const uint32_t middle  = begin + (end - begin) / 2;
+    std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end, [&](uint32_t a, uint32_t b) {
+        return boxes[a].bmin[axis] + boxes[a].bmax[axis] < boxes[b].bmin[axis] + boxes[b].bmax[axis];
+    });
+
+    buildNode(index, begin, middle);
+    const uint32_t right = buildNode(index, middle, end);
+    nodes[index]         = Node { box, right, 0, parent, false };
+    return index;
+}
+
+void BVH::update(uint32_t item, const AABB& box)
+{
+    boxes[item] = box;
+    for (uint32_t node = item_leaf[item]; node != NO_PARENT && !nodes[node].dirty; node = nodes[node].parent) {
+        nodes[node].dirty = true;
+    }
+}
+
+void BVH::refit()
+{
+    // children come after their parent, so walking backwards refits bottom-up
+    for (uint32_t i = static_cast<uint32_t>(nodes.size()); i-- > 0;) {
+        Node& node = nodes[i];
+        if (!node.dirty)
+            continue;
+        if (node.count > 0) {
+            node.box = boxes[items[node.first]];
+            for (uint32_t j = node.first + 1; j < node.first + node.count; j++) {
+                node.box = node.box.merge(boxes[items[j]]);
+            }
+        } else {
+            node.box = nodes[i + 1].box.merge(nodes[node.first].box);
+        }
+        node.dirty = false;
+    }
+}
+
+void BVH::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+    if (nodes.empty())
+        return;
+
+    uint32_t stack[64];
+    uint32_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const uint32_t index = stack[--top];
+        const Node& node     = nodes[index];
+        const auto result    = frustum.test(node.box);
+        if (result == Frustum::Result::Outside)
+            continue;
+        if (result == Frustum::Result::Inside) {
+            appendSubtree(index, visible);
+        } else if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                if (frustum.test(boxes[items[i]]) != Frustum::Result::Outside)
+                    visible.emplace_back(items[i]);
+            }
+        } else {
+            stack[top++] = node.first;
+            stack[top++] = index + 1;
+        }
+    }
+}
+
+void BVH::appendSubtree(uint32_t node, std::vector<uint32_t>& visible) const
+{
+    // a subtree's leaves cover a contiguous range of items
+    uint32_t last = node;
+    while (nodes[last].count == 0) {
+        last = nodes[last].first;
+    }
+    uint32_t first = node;
+    while (nodes[first].count == 0) {
+        first = first + 1;
+    }
+    visible.insert(visible.end(), items.begin() + nodes[first].first, items.begin() + nodes[last].first + nodes[last].count);
+}
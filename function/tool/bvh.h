@@ -0,0 +1,42 @@
+#pragma once
+
+#include "function/tool/frustum.h"
+#include "function/type/aabb.h"
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over a fixed set of boxes, split at the median of the longest axis.
+// Moving boxes are refit instead of rebuilt: update() marks the path to the root and refit() recomputes
+// only the marked nodes, so a frame where few objects move costs a few paths
+class BVH {
+public:
+    void build(const std::vector<AABB>& boxes);
+    void update(uint32_t item, const AABB& box);
+    void refit();
+
+    // appends the items whose boxes touch the frustum, subtrees fully inside skip the plane tests
+    void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+    size_t size() const { return boxes.size(); }
+
+private:
+    struct Node {
+        AABB box;
+        // leaf: items[first, first + count), inner node: left child at index + 1, right child at first
+        uint32_t first;
+        uint32_t count;
+        uint32_t parent;
+        bool dirty;
+    };
+
+    uint32_t buildNode(uint32_t parent, uint32_t begin, uint32_t end);
+    void appendSubtree(uint32_t node, std::vector<uint32_t>& visible) const;
+
+    std::vector<Node> nodes;
+    std::vector<AABB> boxes;
+    std::vector<uint32_t> items;
+    std::vector<uint32_t> item_leaf;
+
+    static constexpr uint32_t LEAF_SIZE = 4;
+    static constexpr uint32_t NO_PARENT = UINT32_MAX;
+};
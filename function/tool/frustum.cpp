@@ -0,0 +1,69 @@
+#include "frustum.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+Frustum Frustum::fromMatrix(const glm::mat4& view_proj)
+{
+    auto row = [&](int i) {
+        return glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]);
+    };
+    const glm::vec4 planes[6] = {
+        row(3) + row(0), // left
+        row(3) - row(0), // right
+        row(3) + row(1), // bottom
+        row(3) - row(1), // top
+        row(2),          // near, depth is [0, 1]
+        row(3) - row(2), // far
+    };
+
+    Frustum frustum;
+    for (int i = 0; i < 8; i++) {
+        // normalized so distances are in world units, the padding planes accept everything
+        const glm::vec4 plane = i < 6 ? planes[i] / glm::length(glm::vec3(planes[i])) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+        frustum.nx[i] = plane.x;
+        frustum.ny[i] = plane.y;
+        frustum.nz[i] = plane.z;
+        frustum.d[i]  = plane.w;
+    }
+    return frustum;
+}
+
+Frustum::Result Frustum::test(const AABB& box) const
+{
+    // per plane, the corner furthest along the normal decides outside and the nearest one inside
+#ifdef FRUSTUM_SSE
+    const __m128 min_x = _mm_set1_ps(box.bmin.x), max_x = _mm_set1_ps(box.bmax.x);
+    const __m128 min_y = _mm_set1_ps(box.bmin.y), max_y = _mm_set1_ps(box.bmax.y);
+    const __m128 min_z = _mm_set1_ps(box.bmin.z), max_z = _mm_set1_ps(box.bmax.z);
+    const __m128 zero  = _mm_setzero_ps();
+    bool inside        = true;
+    for (int i = 0; i < 8; i += 4) {
+        const __m128 px = _mm_load_ps(nx + i), py = _mm_load_ps(ny + i), pz = _mm_load_ps(nz + i);
+        const __m128 ax = _mm_mul_ps(px, min_x), bx = _mm_mul_ps(px, max_x);
+        const __m128 ay = _mm_mul_ps(py, min_y), by = _mm_mul_ps(py, max_y);
+        const __m128 az = _mm_mul_ps(pz, min_z), bz = _mm_mul_ps(pz, max_z);
+        const __m128 pd = _mm_load_ps(d + i);
+        const __m128 far_dist  = _mm_add_ps(_mm_add_ps(_mm_max_ps(ax, bx), _mm_max_ps(ay, by)), _mm_add_ps(_mm_max_ps(az, bz), pd));
+        const __m128 near_dist = _mm_add_ps(_mm_add_ps(_mm_min_ps(ax, bx), _mm_min_ps(ay, by)), _mm_add_ps(_mm_min_ps(az, bz), pd));
+        if (_mm_movemask_ps(_mm_cmplt_ps(far_dist, zero)) != 0)
+            return Result::Outside;
+        inside = inside && _mm_movemask_ps(_mm_cmplt_ps(near_dist, zero)) == 0;
+    }
+    return inside ? Result::Inside : Result::Intersect;
+#else
+    bool inside = true;
+    for (int i = 0; i < 6; i++) {
+        const float ax = nx[i] * box.bmin.x, bx = nx[i] * box.bmax.x;
+        const float ay = ny[i] * box.bmin.y, by = ny[i] * box.bmax.y;
+        const float az = nz[i] * box.bmin.z, bz = nz[i] * box.bmax.z;
+        if (glm::max(ax, bx) + glm::max(ay, by) + glm::max(az, bz) + d[i] < 0.0f)
+            return Result::Outside;
+        inside = inside && glm::min(ax, bx) + glm::min(ay, by) + glm::min(az, bz) + d[i] >= 0.0f;
+    }
+    return inside ? Result::Inside : Result::Intersect;
+#endif
+}
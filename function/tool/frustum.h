@@ -0,0 +1,25 @@
+#pragma once
+
+#include "function/type/aabb.h"
+#include <glm/glm.hpp>
+
+// View frustum as 6 inward facing planes, tested against boxes 4 planes at a time with SSE on x86-64
+// and a scalar fallback elsewhere
+struct Frustum {
+    enum class Result {
+        Outside,
+        Intersect,
+        Inside,
+    };
+
+    // planes of a [0, 1] depth projection * view matrix (Gribb and Hartmann), world space
+    static Frustum fromMatrix(const glm::mat4& view_proj);
+
+    Result test(const AABB& box) const;
+
+    // structure of arrays, the last 2 planes always pass so the SSE loop runs twice without a tail
+    alignas(16) float nx[8];
+    alignas(16) float ny[8];
+    alignas(16) float nz[8];
+    alignas(16) float d[8];
+};
@@ -0,0 +1,223 @@
+#include "image_decoder.h"
+#include "function/tool/pixel_convert.h"
+#include <algorithm>
+#include <bit>
+#include <boost/gil.hpp>
+#include <boost/gil/extension/io/tiff.hpp>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <jpeglib.h>
+#include <png.h>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+constexpr uint16_t HALF_ONE = 0x3c00;
+
+// Per thread scratch for the intermediate rows, kept between images to avoid reallocating
+thread_local std::vector<uint8_t> scratch;
+thread_local std::vector<uint16_t> scratch_halves;
+thread_local std::vector<float> scratch_floats;
+
+// 1 channel stays R8, everything else is widened to RGBA8
+void toUploadFormat8(const uint8_t* src, uint32_t channels, DecodedImage& decoded)
+{
+    const size_t pixel_count = static_cast<size_t>(decoded.width) * decoded.height;
+    decoded.format           = channels == 1 ? VK_FORMAT_R8_UNORM : VK_FORMAT_R8G8B8A8_UNORM;
+    decoded.pixels.resize(pixel_count * (channels == 1 ? 1 : 4));
+    switch (channels) {
+    case 2:
+        PixelConvert::grayAlphaToRgba8(src, decoded.pixels.data(), pixel_count);
+        break;
+    case 3:
+        PixelConvert::rgbToRgba8(src, decoded.pixels.data(), pixel_count);
+        break;
+    default:
+        std::memcpy(decoded.pixels.data(), src, decoded.pixels.size());
+        break;
+    }
+}
+
+// halves holds pixel_count * channels values. 1 channel stays R16F, everything else is widened to RGBA16F
+void toUploadFormat16F(const uint16_t* halves, uint32_t channels, DecodedImage& decoded)
+{
+    const size_t pixel_count = static_cast<size_t>(decoded.width) * decoded.height;
+    if (channels == 1) {
+        decoded.format = VK_FORMAT_R16_SFLOAT;
+        decoded.pixels.resize(pixel_count * sizeof(uint16_t));
+        std::memcpy(decoded.pixels.data(), halves, decoded.pixels.size());
+        return;
+    }
+    decoded.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+    decoded.pixels.resize(pixel_count * 4 * sizeof(uint16_t));
+    PixelConvert::expandToRgba16(halves, channels, HALF_ONE, reinterpret_cast<uint16_t*>(decoded.pixels.data()), pixel_count);
+}
+
+struct JpegErrorManager {
+    jpeg_error_mgr manager;
+    std::jmp_buf jump;
+};
+
+void jpegErrorExit(j_common_ptr cinfo)
+{
+    std::longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+}
+}
+
+DecodedImage ImageDecoder::decodePng(const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        throw std::runtime_error("can't open " + path);
+
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info  = png_create_info_struct(png);
+    // everything with a destructor lives before setjmp, longjmp doesn't unwind
+    DecodedImage decoded;
+    std::vector<png_bytep> rows;
+    // libpng reports errors by jumping back here
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        std::fclose(file);
+        throw std::runtime_error("libpng failed to decode " + path);
+    }
+
+    png_init_io(png, file);
+    png_read_info(png, info);
+    // palette to RGB, low bit gray to 8 bits, tRNS chunks to alpha
+    png_set_expand(png);
+    if (png_get_bit_depth(png, info) == 16 && std::endian::native == std::endian::little)
+        png_set_swap(png);
+    png_read_update_info(png, info);
+
+    decoded.width            = png_get_image_width(png, info);
+    decoded.height           = png_get_image_height(png, info);
+    const uint32_t channels  = png_get_channels(png, info);
+    const uint32_t bit_depth = png_get_bit_depth(png, info);
+    const size_t row_bytes   = png_get_rowbytes(png, info);
+
+    // R8 and RGBA8 are already upload formats, decode them in place
+    const bool direct = bit_depth == 8 && (channels == 1 || channels == 4);
+    uint8_t* target;
+    if (direct) {
+        decoded.format = channels == 1 ? VK_FORMAT_R8_UNORM : VK_FORMAT_R8G8B8A8_UNORM;
+        decoded.pixels.resize(row_bytes * decoded.height);
+        target = decoded.pixels.data();
+    } else {
+        scratch.resize(row_bytes * decoded.height);
+        target = scratch.data();
+    }
+    rows.resize(decoded.height);
+    for (uint32_t y = 0; y < decoded.height; y++) {
+        rows[y] = target + y * row_bytes;
+    }
+    png_read_image(png, rows.data());
+    png_read_end(png, nullptr);
+    png_destroy_read_struct(&png, &info, nullptr);
+    std::fclose(file);
+
+    if (direct)
+        return decoded;
+    if (bit_depth == 8) {
+        toUploadFormat8(scratch.data(), channels, decoded);
+    } else {
+        const size_t count = static_cast<size_t>(decoded.width) * decoded.height * channels;
+        scratch_halves.resize(count);
+        PixelConvert::unorm16ToHalf(reinterpret_cast<const uint16_t*>(scratch.data()), scratch_halves.data(), count);
+        toUploadFormat16F(scratch_halves.data(), channels, decoded);
+    }
+    return decoded;
+}
+
+DecodedImage ImageDecoder::decodeJpeg(const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        throw std::runtime_error("can't open " + path);
+
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager error;
+    cinfo.err                = jpeg_std_error(&error.manager);
+    error.manager.error_exit = jpegErrorExit;
+    // everything with a destructor lives before setjmp, longjmp doesn't unwind
+    DecodedImage decoded;
+    // libjpeg reports errors by jumping back here
+    if (setjmp(error.jump)) {
+        char message[JMSG_LENGTH_MAX];
+        cinfo.err->format_message(reinterpret_cast<j_common_ptr>(&cinfo), message);
+        jpeg_destroy_decompress(&cinfo);
+        std::fclose(file);
+        throw std::runtime_error("libjpeg failed to decode " + path + ": " + message);
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, file);
+    jpeg_read_header(&cinfo, TRUE);
+    // gray stays R8, anything else goes through libjpeg-turbo's SIMD color conversion straight to RGBA
+    const bool gray       = cinfo.jpeg_color_space == JCS_GRAYSCALE;
+    cinfo.out_color_space = gray ? JCS_GRAYSCALE : JCS_EXT_RGBA;
+    jpeg_start_decompress(&cinfo);
+
+    decoded.width          = cinfo.output_width;
+    decoded.height         = cinfo.output_height;
+    decoded.format         = gray ? VK_FORMAT_R8_UNORM : VK_FORMAT_R8G8B8A8_UNORM;
+    const size_t row_bytes = static_cast<size_t>(decoded.width) * cinfo.output_components;
+    decoded.pixels.resize(row_bytes * decoded.height);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        // the decoder produces up to rec_outbuf_height rows per call
+        JSAMPROW rows[4];
+        JDIMENSION count = std::min<JDIMENSION>(4, cinfo.output_height - cinfo.output_scanline);
+        for (JDIMENSION i = 0; i < count; i++) {
+            rows[i] = decoded.pixels.data() + (cinfo.output_scanline + i) * row_bytes;
+        }
+        jpeg_read_scanlines(&cinfo, rows, count);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    std::fclose(file);
+    return decoded;
+}
+
+DecodedImage ImageDecoder::decodeTiff(const std::string& path)
+{
+    using namespace boost::gil;
+
+    any_image<
+        gray8_image_t, gray16_image_t, gray32_image_t,
+        rgb8_image_t, rgb16_image_t, rgb32_image_t,
+        rgba8_image_t, rgba16_image_t, rgba32_image_t>
+        boost_image;
+    read_image(path, boost_image, tiff_tag {});
+
+    DecodedImage decoded;
+    boost::variant2::visit([&](auto&& view) {
+        using ViewType              = std::decay_t<decltype(view)>;
+        using Channel               = typename channel_type<ViewType>::type;
+        constexpr uint32_t channels = num_channels<ViewType>::value;
+        decoded.width               = view.width();
+        decoded.height              = view.height();
+        const auto* src             = reinterpret_cast<const Channel*>(interleaved_view_get_raw_data(view));
+        const size_t count          = static_cast<size_t>(decoded.width) * decoded.height * channels;
+
+        if constexpr (sizeof(Channel) == 1) {
+            toUploadFormat8(reinterpret_cast<const uint8_t*>(src), channels, decoded);
+        } else if constexpr (sizeof(Channel) == 2) {
+            scratch_halves.resize(count);
+            PixelConvert::unorm16ToHalf(reinterpret_cast<const uint16_t*>(src), scratch_halves.data(), count);
+            toUploadFormat16F(scratch_halves.data(), channels, decoded);
+        } else {
+            // 32-bit unsigned, half has too few bits anyway so go through float
+            scratch_floats.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                scratch_floats[i] = static_cast<float>(static_cast<double>(src[i]) / 4294967295.0);
+            }
+            scratch_halves.resize(count);
+            PixelConvert::floatToHalf(scratch_floats.data(), scratch_halves.data(), count);
+            toUploadFormat16F(scratch_halves.data(), channels, decoded);
+        }
+    },
+                           view(boost_image));
+    return decoded;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "function/type/texture.h"
+#include <string>
+
+// Decodes image files straight into upload-ready pixels: 8-bit images become R8 (gray) or RGBA8, 16 and
+// 32-bit images are read as unorm and become R16F or RGBA16F. Safe to call from several threads,
+// throws when the file can't be decoded
+struct ImageDecoder {
+    // libpng, 1-4 channels, 8 or 16 bits
+    static DecodedImage decodePng(const std::string& path);
+    // libjpeg-turbo, converts color images to RGBA while decoding
+    static DecodedImage decodeJpeg(const std::string& path);
+    // Boost.GIL, 1/3/4 channels of 8, 16 or 32-bit unsigned integers
+    static DecodedImage decodeTiff(const std::string& path);
+};
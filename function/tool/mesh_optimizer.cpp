@@ -0,0 +1,170 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr uint32_t CACHE_SIZE       = 32;
+constexpr float CACHE_DECAY_POWER   = 1.5f;
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+constexpr uint32_t INVALID          = std::numeric_limits<uint32_t>::max();
+
+float vertexScore(int32_t cache_position, uint32_t remaining_triangles)
+{
+    // no triangle left to draw, never pick it again
+    if (remaining_triangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cache_position >= 0) {
+        if (cache_position < 3) {
+            // used by the last triangle, a fixed score so the next one doesn't just reuse its edge
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            float scaler = 1.0f / (CACHE_SIZE - 3);
+            score        = std::pow(1.0f - (cache_position - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+    // favour vertices with few triangles left so they can leave the cache
+    score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining_triangles), -VALENCE_BOOST_POWER);
+    return score;
+}
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertex_count)
+{
+    assert(indices.size() % 3 == 0);
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+        return;
+
+    // vertex -> triangles, compressed rows. Emitted triangles are swapped past the end of the row
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    for (uint32_t index : indices) {
+        remaining[index]++;
+    }
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; v++) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++) {
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<int32_t> cache_position(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++) {
+        vertex_scores[v] = vertexScore(-1, remaining[v]);
+    }
+
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    // the 3 vertices of the new triangle are pushed in front of the cache, so it holds up to CACHE_SIZE + 3
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> next_cache;
+    cache.reserve(CACHE_SIZE + 3);
+    next_cache.reserve(CACHE_SIZE + 3);
+
+    size_t scan_cursor = 0;
+    uint32_t best      = INVALID;
+    for (size_t emitted_count = 0; emitted_count < triangle_count; emitted_count++) {
+        if (best == INVALID) {
+            // nothing in the cache has triangles left, start over at the next unused triangle
+            while (emitted[scan_cursor])
+                scan_cursor++;
+            best = static_cast<uint32_t>(scan_cursor);
+        }
+
+        const uint32_t* tri = &indices[best * 3];
+        result.insert(result.end(), tri, tri + 3);
+        emitted[best] = true;
+
+        for (int i = 0; i < 3; i++) {
+            uint32_t v = tri[i];
+            // drop the triangle from the vertex's row
+            uint32_t* row_begin = &adjacency[offsets[v]];
+            uint32_t* row_end   = row_begin + remaining[v];
+            uint32_t* it        = std::find(row_begin, row_end, best);
+            assert(it != row_end);
+            std::swap(*it, *(row_end - 1));
+            remaining[v]--;
+        }
+
+        // LRU update: the triangle's vertices first, then the old entries in order
+        next_cache.assign(tri, tri + 3);
+        for (uint32_t v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                next_cache.emplace_back(v);
+        }
+        for (size_t i = CACHE_SIZE; i < next_cache.size(); i++) {
+            cache_position[next_cache[i]] = -1;
+            vertex_scores[next_cache[i]]  = vertexScore(-1, remaining[next_cache[i]]);
+        }
+        if (next_cache.size() > CACHE_SIZE)
+            next_cache.resize(CACHE_SIZE);
+        std::swap(cache, next_cache);
+
+        for (size_t i = 0; i < cache.size(); i++) {
+            cache_position[cache[i]] = static_cast<int32_t>(i);
+            vertex_scores[cache[i]]  = vertexScore(static_cast<int32_t>(i), remaining[cache[i]]);
+        }
+
+        // only triangles touching the cache changed score, pick the best of them
+        best             = INVALID;
+        float best_score = -1.0f;
+        for (uint32_t v : cache) {
+            for (uint32_t k = offsets[v]; k < offsets[v] + remaining[v]; k++) {
+                uint32_t t  = adjacency[k];
+                float score = vertex_scores[indices[t * 3 + 0]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+                if (score > best_score) {
+                    best_score = score;
+                    best       = t;
+                }
+            }
+        }
+    }
+
+    indices = std::move(result);
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertex_count)
+{
+    std::vector<uint32_t> remap(vertex_count, INVALID);
+    uint32_t next = 0;
+    for (uint32_t& index : indices) {
+        if (remap[index] == INVALID)
+            remap[index] = next++;
+        index = remap[index];
+    }
+    for (uint32_t& target : remap) {
+        if (target == INVALID)
+            target = next++;
+    }
+    return remap;
+}
+
+float MeshOptimizer::averageCacheMissRatio(const std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size)
+{
+    if (indices.size() < 3)
+        return 0.0f;
+
+    // FIFO like the hardware, a vertex is in the cache if it was loaded less than cache_size misses ago
+    std::vector<uint32_t> loaded_at(vertex_count, 0);
+    uint32_t misses = 0;
+    for (uint32_t index : indices) {
+        if (loaded_at[index] == 0 || misses + 1 - loaded_at[index] > cache_size) {
+            misses++;
+            loaded_at[index] = misses;
+        }
+    }
+    return static_cast<float>(misses) / (indices.size() / 3);
+}
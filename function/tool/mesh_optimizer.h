@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Load-time reordering of indexed triangle lists, independent of the vertex layout
+struct MeshOptimizer {
+    // Reorders the triangles for the post-transform vertex cache (Forsyth's linear-speed algorithm)
+    static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertex_count);
+
+    // Renumbers the vertices in order of first use so the fetches walk the vertex buffer linearly.
+    // Rewrites indices and returns remap, vertex i moves to remap[i]. Unreferenced vertices go last.
+    static std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertex_count);
+
+    // Average cache misses per triangle of a FIFO cache, 0.5 is ideal for a regular grid and 3 is the worst
+    static float averageCacheMissRatio(const std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size = 16);
+};
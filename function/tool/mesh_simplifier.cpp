@@ -0,0 +1,252 @@
+#include "mesh_simplifier.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+// a collapse may turn the triangles it moves by up to ~75 degrees
+constexpr double MIN_NORMAL_COSINE = 0.25;
+
+// sum of squared distances to a set of planes, the unique terms of the symmetric 4x4 matrix
+struct Quadric {
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+    double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+    double a22 = 0.0, a23 = 0.0;
+    double a33 = 0.0;
+
+    // the plane n.p + d = 0, n of unit length
+    static Quadric plane(const glm::dvec3& n, double d)
+    {
+        Quadric q;
+        q.a00 = n.x * n.x;
+        q.a01 = n.x * n.y;
+        q.a02 = n.x * n.z;
+        q.a03 = n.x * d;
+        q.a11 = n.y * n.y;
+        q.a12 = n.y * n.z;
+        q.a13 = n.y * d;
+        q.a22 = n.z * n.z;
+        q.a23 = n.z * d;
+        q.a33 = d * d;
+        return q;
+    }
+
+    void add(const Quadric& q)
+    {
+        a00 += q.a00;
+        a01 += q.a01;
+        a02 += q.a02;
+        a03 += q.a03;
+        a11 += q.a11;
+        a12 += q.a12;
+        a13 += q.a13;
+        a22 += q.a22;
+        a23 += q.a23;
+        a33 += q.a33;
+    }
+
+    double evaluate(const glm::vec3& p) const
+    {
+        const double x = p.x;
+        const double y = p.y;
+        const double z = p.z;
+        return a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+            + a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+            + a22 * z * z + 2.0 * a23 * z
+            + a33;
+    }
+};
+
+struct PositionHash {
+    size_t operator()(const glm::vec3& p) const
+    {
+        uint32_t bits[3];
+        std::memcpy(bits, &p, sizeof(bits));
+        return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+    }
+};
+
+uint64_t edgeKey(uint32_t a, uint32_t b)
+{
+    return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+}
+
+glm::dvec3 triangleNormal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+{
+    return glm::cross(glm::dvec3(p1 - p0), glm::dvec3(p2 - p0));
+}
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    double cost;
+};
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(
+    const std::vector<uint32_t>& indices,
+    const std::vector<glm::vec3>& positions,
+    size_t target_index_count,
+    float& error)
+{
+    assert(indices.size() % 3 == 0);
+    const size_t vertex_count = positions.size();
+    std::vector<uint32_t> result = indices;
+    error                        = 0.0f;
+    if (result.size() <= target_index_count)
+        return result;
+
+    // vertices at the same position are one corner with several attribute sets, they all stay
+    std::vector<uint32_t> wedge(vertex_count, INVALID);
+    std::vector<bool> locked(vertex_count, false);
+    {
+        std::unordered_map<glm::vec3, uint32_t, PositionHash> corners;
+        for (uint32_t index : result) {
+            if (wedge[index] != INVALID)
+                continue;
+            auto [corner, inserted] = corners.emplace(positions[index], index);
+            wedge[index]            = corner->second;
+            if (!inserted) {
+                locked[index]          = true;
+                locked[corner->second] = true;
+            }
+        }
+    }
+    // an edge of a single triangle is on an open border, counted between corners so seams aren't borders
+    {
+        std::unordered_map<uint64_t, uint32_t> edges;
+        for (size_t i = 0; i < result.size(); i++) {
+            const size_t next = i - i % 3 + (i + 1) % 3;
+            edges[edgeKey(wedge[result[i]], wedge[result[next]])]++;
+        }
+        for (size_t i = 0; i < result.size(); i++) {
+            const size_t next = i - i % 3 + (i + 1) % 3;
+            if (edges[edgeKey(wedge[result[i]], wedge[result[next]])] == 1) {
+                locked[result[i]]    = true;
+                locked[result[next]] = true;
+            }
+        }
+    }
+
+    // the planes of the triangles around every corner, shared by the vertices of a seam
+    std::vector<Quadric> quadrics(vertex_count);
+    for (size_t t = 0; t < result.size(); t += 3) {
+        const glm::vec3& p0 = positions[result[t]];
+        const glm::dvec3 n  = triangleNormal(p0, positions[result[t + 1]], positions[result[t + 2]]);
+        const double length = glm::length(n);
+        if (length == 0.0)
+            continue;
+        const Quadric q = Quadric::plane(n / length, -glm::dot(n / length, glm::dvec3(p0)));
+        for (size_t k = 0; k < 3; k++) {
+            quadrics[wedge[result[t + k]]].add(q);
+        }
+    }
+
+    std::vector<uint32_t> offsets(vertex_count + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<bool> touched(vertex_count);
+    double max_cost = 0.0;
+    while (result.size() > target_index_count) {
+        // vertex -> triangles of the current result, compressed rows
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (uint32_t index : result) {
+            offsets[index + 1]++;
+        }
+        for (size_t v = 0; v < vertex_count; v++) {
+            offsets[v + 1] += offsets[v];
+        }
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++) {
+                adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        // both directions of every edge, an edge between two triangles shows up twice
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i++) {
+            const uint32_t a = result[i];
+            const uint32_t b = result[i - i % 3 + (i + 1) % 3];
+            for (auto [from, to] : { std::pair { a, b }, std::pair { b, a } }) {
+                if (locked[from])
+                    continue;
+                Quadric q = quadrics[from];
+                q.add(quadrics[wedge[to]]);
+                collapses.emplace_back(Collapse { from, to, q.evaluate(positions[to]) });
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // cheapest first, a vertex and its neighbours take part in one collapse per pass so the costs
+        // and the adjacency stay exact
+        const size_t excess = (result.size() - target_index_count + 2) / 3;
+        size_t removed      = 0;
+        bool progress       = false;
+        std::fill(touched.begin(), touched.end(), false);
+        for (const auto& collapse : collapses) {
+            if (removed >= excess)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            bool flips = false;
+            for (uint32_t k = offsets[collapse.from]; k < offsets[collapse.from + 1] && !flips; k++) {
+                const uint32_t* tri = &result[adjacency[k] * 3];
+                if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+                    continue;
+                glm::vec3 moved[3];
+                for (int c = 0; c < 3; c++) {
+                    moved[c] = positions[tri[c] == collapse.from ? collapse.to : tri[c]];
+                }
+                const glm::dvec3 before = triangleNormal(positions[tri[0]], positions[tri[1]], positions[tri[2]]);
+                const glm::dvec3 after  = triangleNormal(moved[0], moved[1], moved[2]);
+                // already degenerate triangles may go anywhere, others must not fold over or collapse
+                if (glm::length(before) == 0.0)
+                    continue;
+                flips = glm::dot(before, after) <= MIN_NORMAL_COSINE * glm::length(before) * glm::length(after);
+            }
+            if (flips)
+                continue;
+
+            for (uint32_t k = offsets[collapse.from]; k < offsets[collapse.from + 1]; k++) {
+                uint32_t* tri = &result[adjacency[k] * 3];
+                if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+                    removed++;
+                for (int c = 0; c < 3; c++) {
+                    touched[tri[c]] = true;
+                    if (tri[c] == collapse.from)
+                        tri[c] = collapse.to;
+                }
+            }
+            quadrics[wedge[collapse.to]].add(quadrics[collapse.from]);
+            max_cost = std::max(max_cost, collapse.cost);
+            progress = true;
+        }
+        if (!progress)
+            break;
+
+        // drop the triangles that lost a corner
+        size_t write = 0;
+        for (size_t t = 0; t < result.size(); t += 3) {
+            const uint32_t a = result[t];
+            const uint32_t b = result[t + 1];
+            const uint32_t c = result[t + 2];
+            if (a == b || b == c || c == a)
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    // the quadrics sum squared distances, so this bounds the distance to every original plane
+    error = static_cast<float>(std::sqrt(std::max(max_cost, 0.0)));
+    return result;
+}
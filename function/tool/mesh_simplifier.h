@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Load-time level of detail generation for indexed triangle lists
+struct MeshSimplifier {
+    // Quadric error edge collapse (Garland & Heckbert) until at most target_index_count indices are left.
+    // Vertices collapse onto a neighbour instead of a new position, so the result indexes the same
+    // vertices as the source. Vertices sharing their position with another (a UV or tangent seam) or on
+    // an open border are never removed, which keeps seams and outlines where they were. Stops early when
+    // nothing can collapse anymore. error is the largest collapse error, a distance in the units of positions
+    static std::vector<uint32_t> simplify(
+        const std::vector<uint32_t>& indices,
+        const std::vector<glm::vec3>& positions,
+        size_t target_index_count,
+        float& error);
+};
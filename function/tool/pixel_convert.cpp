@@ -0,0 +1,230 @@
+#include "pixel_convert.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PIXEL_CONVERT_SSE
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_SSSE3
+#else
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#endif
+
+namespace {
+// Rounding float to half conversion after F. Giesen's float_to_half_fast3_rtne, no F16C needed
+uint16_t floatToHalfScalar(float value)
+{
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof(f));
+    const uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    uint16_t h;
+    if (f >= (143u << 23)) {
+        // too large for a half: infinity, or a quiet NaN
+        h = f > (255u << 23) ? 0x7e00 : 0x7c00;
+    } else if (f < (113u << 23)) {
+        // subnormal or zero, let the FPU round the mantissa into place
+        const uint32_t magic_bits = 126u << 23;
+        float magic, shifted;
+        std::memcpy(&magic, &magic_bits, sizeof(magic));
+        std::memcpy(&shifted, &f, sizeof(shifted));
+        shifted += magic;
+        std::memcpy(&f, &shifted, sizeof(f));
+        h = static_cast<uint16_t>(f - magic_bits);
+    } else {
+        const uint32_t mant_odd = (f >> 13) & 1;
+        f += (static_cast<uint32_t>(15 - 127) << 23) + 0xfff;
+        f += mant_odd;
+        h = static_cast<uint16_t>(f >> 13);
+    }
+    return h | static_cast<uint16_t>(sign >> 16);
+}
+
+#ifdef PIXEL_CONVERT_SSE
+// 4 floats to 4 halves in the low 16 bits of each lane, same steps as floatToHalfScalar
+__m128i floatToHalf4(__m128 value)
+{
+    const __m128i f16max        = _mm_set1_epi32(143 << 23);
+    const __m128i f32infty      = _mm_set1_epi32(255 << 23);
+    const __m128i min_normal    = _mm_set1_epi32(113 << 23);
+    const __m128i subnorm_magic = _mm_set1_epi32(126 << 23);
+    const __m128i normal_bias   = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+    __m128i f    = _mm_castps_si128(value);
+    __m128i sign = _mm_and_si128(f, _mm_set1_epi32(static_cast<int>(0x80000000u)));
+    __m128i abs  = _mm_xor_si128(f, sign);
+    // abs < 2^31, so the signed compares are fine
+    __m128i is_nan     = _mm_cmpgt_epi32(abs, f32infty);
+    __m128i is_regular = _mm_cmpgt_epi32(f16max, abs);
+    __m128i is_sub     = _mm_cmpgt_epi32(min_normal, abs);
+    __m128i inf_or_nan = _mm_or_si128(_mm_and_si128(is_nan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+
+    __m128i subnormal = _mm_sub_epi32(
+        _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(abs), _mm_castsi128_ps(subnorm_magic))), subnorm_magic);
+    __m128i mant_odd = _mm_srai_epi32(_mm_slli_epi32(abs, 31 - 13), 31);
+    __m128i normal   = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(abs, normal_bias), mant_odd), 13);
+
+    __m128i finite = _mm_or_si128(_mm_and_si128(is_sub, subnormal), _mm_andnot_si128(is_sub, normal));
+    __m128i joined = _mm_or_si128(_mm_and_si128(is_regular, finite), _mm_andnot_si128(is_regular, inf_or_nan));
+    return _mm_or_si128(joined, _mm_srli_epi32(sign, 16));
+}
+
+// packs the low 16 bits of two vectors of 4 lanes, sign extension keeps _mm_packs_epi32 from saturating
+__m128i pack16(__m128i lo, __m128i hi)
+{
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    return _mm_packs_epi32(lo, hi);
+}
+
+bool hasSSSE3()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+TARGET_SSSE3 size_t rgbToRgba8SSSE3(const uint8_t* src, uint8_t* dst, size_t pixel_count)
+{
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha   = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    size_t i              = 0;
+    // each load reads 16 bytes but uses 12, stop while the over-read is still in bounds
+    for (; i + 6 <= pixel_count; i += 4) {
+        __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+    }
+    return i;
+}
+#endif
+}
+
+void PixelConvert::grayAlphaToRgba8(const uint8_t* src, uint8_t* dst, size_t pixel_count)
+{
+    size_t i = 0;
+#ifdef PIXEL_CONVERT_SSE
+    const __m128i low = _mm_set1_epi16(0x00ff);
+    for (; i + 8 <= pixel_count; i += 8) {
+        __m128i ga = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        __m128i g  = _mm_and_si128(ga, low);
+        __m128i gg = _mm_or_si128(g, _mm_slli_epi16(g, 8));
+        auto* out  = reinterpret_cast<__m128i*>(dst + i * 4);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(gg, ga));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(gg, ga));
+    }
+#endif
+    for (; i < pixel_count; i++) {
+        dst[i * 4 + 0] = src[i * 2];
+        dst[i * 4 + 1] = src[i * 2];
+        dst[i * 4 + 2] = src[i * 2];
+        dst[i * 4 + 3] = src[i * 2 + 1];
+    }
+}
+
+void PixelConvert::rgbToRgba8(const uint8_t* src, uint8_t* dst, size_t pixel_count)
+{
+    size_t i = 0;
+#ifdef PIXEL_CONVERT_SSE
+    static const bool ssse3 = hasSSSE3();
+    if (ssse3)
+        i = rgbToRgba8SSSE3(src, dst, pixel_count);
+#endif
+    for (; i < pixel_count; i++) {
+        dst[i * 4 + 0] = src[i * 3 + 0];
+        dst[i * 4 + 1] = src[i * 3 + 1];
+        dst[i * 4 + 2] = src[i * 3 + 2];
+        dst[i * 4 + 3] = 255;
+    }
+}
+
+void PixelConvert::floatToHalf(const float* src, uint16_t* dst, size_t count)
+{
+    size_t i = 0;
+#ifdef PIXEL_CONVERT_SSE
+    for (; i + 8 <= count; i += 8) {
+        __m128i lo = floatToHalf4(_mm_loadu_ps(src + i));
+        __m128i hi = floatToHalf4(_mm_loadu_ps(src + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), pack16(lo, hi));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = floatToHalfScalar(src[i]);
+    }
+}
+
+void PixelConvert::unorm16ToHalf(const uint16_t* src, uint16_t* dst, size_t count)
+{
+    constexpr float scale = 1.0f / 65535.0f;
+    size_t i              = 0;
+#ifdef PIXEL_CONVERT_SSE
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128 lo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)), vscale);
+        __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)), vscale);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), pack16(floatToHalf4(lo), floatToHalf4(hi)));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = floatToHalfScalar(static_cast<float>(src[i]) * scale);
+    }
+}
+
+float PixelConvert::halfToFloat(uint16_t h)
+{
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    const uint32_t exp  = (h >> 10) & 0x1f;
+    const uint32_t mant = h & 0x3ff;
+
+    uint32_t f;
+    if (exp == 0) {
+        // zero or subnormal, exact in float
+        float value = static_cast<float>(mant) * (1.0f / 16777216.0f);
+        return sign ? -value : value;
+    } else if (exp == 31) {
+        f = sign | 0x7f800000u | (mant << 13);
+    } else {
+        f = sign | ((exp + 112) << 23) | (mant << 13);
+    }
+    float value;
+    std::memcpy(&value, &f, sizeof(value));
+    return value;
+}
+
+void PixelConvert::expandToRgba16(const uint16_t* src, uint32_t channels, uint16_t one, uint16_t* dst, size_t pixel_count)
+{
+    switch (channels) {
+    case 1:
+        for (size_t i = 0; i < pixel_count; i++) {
+            dst[i * 4 + 0] = dst[i * 4 + 1] = dst[i * 4 + 2] = src[i];
+            dst[i * 4 + 3]                                   = one;
+        }
+        break;
+    case 2:
+        for (size_t i = 0; i < pixel_count; i++) {
+            dst[i * 4 + 0] = dst[i * 4 + 1] = dst[i * 4 + 2] = src[i * 2];
+            dst[i * 4 + 3]                                   = src[i * 2 + 1];
+        }
+        break;
+    case 3:
+        for (size_t i = 0; i < pixel_count; i++) {
+            dst[i * 4 + 0] = src[i * 3 + 0];
+            dst[i * 4 + 1] = src[i * 3 + 1];
+            dst[i * 4 + 2] = src[i * 3 + 2];
+            dst[i * 4 + 3] = one;
+        }
+        break;
+    default:
+        std::memcpy(dst, src, pixel_count * 4 * sizeof(uint16_t));
+        break;
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Pixel format conversions for texture import. SSE2/SSSE3 on x86-64 with a scalar fallback,
+// the SSSE3 kernels are picked at runtime. Halves are IEEE binary16 bit patterns
+struct PixelConvert {
+    static void grayAlphaToRgba8(const uint8_t* src, uint8_t* dst, size_t pixel_count);
+    static void rgbToRgba8(const uint8_t* src, uint8_t* dst, size_t pixel_count);
+
+    // round to nearest even, overflow becomes infinity
+    static void floatToHalf(const float* src, uint16_t* dst, size_t count);
+    // [0, 65535] -> [0, 1]
+    static void unorm16ToHalf(const uint16_t* src, uint16_t* dst, size_t count);
+    static float halfToFloat(uint16_t h);
+
+    // widens 1 (gray), 2 (gray + alpha), 3 or 4 channel 16-bit pixels to RGBA, alpha is filled with `one`
+    static void expandToRgba16(const uint16_t* src, uint32_t channels, uint16_t one, uint16_t* dst, size_t pixel_count);
+};
@@ -0,0 +1,50 @@
+#include "radix_sort.h"
+#include <array>
+#include <cstring>
+
+void RadixSort::sort(std::vector<Item>& items, std::vector<Item>& scratch)
+{
+    constexpr uint32_t RADIX  = 256;
+    constexpr uint32_t PASSES = sizeof(uint64_t);
+    if (items.size() < 2)
+        return;
+
+    // every pass's histogram in one read of the keys
+    std::array<std::array<uint32_t, RADIX>, PASSES> counts {};
+    for (const auto& item : items) {
+        for (uint32_t pass = 0; pass < PASSES; pass++) {
+            counts[pass][(item.key >> (pass * 8)) & (RADIX - 1)]++;
+        }
+    }
+
+    scratch.resize(items.size());
+    auto* src = &items;
+    auto* dst = &scratch;
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        auto& count = counts[pass];
+        if (count[((*src)[0].key >> (pass * 8)) & (RADIX - 1)] == items.size())
+            continue;
+
+        uint32_t offset = 0;
+        for (auto& c : count) {
+            const uint32_t n = c;
+            c                = offset;
+            offset += n;
+        }
+        for (const auto& item : *src) {
+            (*dst)[count[(item.key >> (pass * 8)) & (RADIX - 1)]++] = item;
+        }
+        std::swap(src, dst);
+    }
+    if (src != &items)
+        items.swap(scratch);
+}
+
+uint32_t RadixSort::floatKey(float value)
+{
+    // the bits of a non-negative IEEE float grow with its value
+    value = value > 0.0f ? value : 0.0f;
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// LSD radix sort of 64 bit keys carrying a 32 bit value, 8 bits per pass. Stable, and the passes over a
+// byte every key shares are skipped, so keys using only their low bits sort in fewer passes
+struct RadixSort {
+    struct Item {
+        uint64_t key;
+        uint32_t value;
+    };
+
+    // scratch is resized to items and left holding garbage, pass the same one every frame
+    static void sort(std::vector<Item>& items, std::vector<Item>& scratch);
+
+    // a non-negative float as a key that sorts like it, negatives clamp to 0
+    static uint32_t floatKey(float value);
+};
@@ -0,0 +1,241 @@
+#include "texture_encoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// Gathers a 4x4 block, pixels outside the image repeat the last row / column
+template <typename T>
+void fetchBlock(const T* src, uint32_t width, uint32_t height, uint32_t channels, uint32_t bx, uint32_t by, T* block)
+{
+    for (uint32_t y = 0; y < 4; y++) {
+        uint32_t sy = std::min(by * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; x++) {
+            uint32_t sx = std::min(bx * 4 + x, width - 1);
+            std::memcpy(block + (y * 4 + x) * channels, src + (static_cast<size_t>(sy) * width + sx) * channels, channels * sizeof(T));
+        }
+    }
+}
+
+uint16_t packRGB565(const float* c)
+{
+    auto r = static_cast<uint16_t>(std::clamp(c[0] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+    auto g = static_cast<uint16_t>(std::clamp(c[1] * 63.0f / 255.0f + 0.5f, 0.0f, 63.0f));
+    auto b = static_cast<uint16_t>(std::clamp(c[2] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+    return (r << 11) | (g << 5) | b;
+}
+
+void unpackRGB565(uint16_t v, float* c)
+{
+    uint32_t r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    c[0]       = static_cast<float>((r << 3) | (r >> 2));
+    c[1]       = static_cast<float>((g << 2) | (g >> 4));
+    c[2]       = static_cast<float>((b << 3) | (b >> 2));
+}
+
+// 4 color mode: endpoints on the principal axis of the block, indices to the closest palette entry
+void encodeColorBlock(const uint8_t* rgba, uint8_t* dst)
+{
+    float mean[3] = {};
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++)
+            mean[c] += rgba[i * 4 + c];
+    }
+    for (float& m : mean)
+        m /= 16.0f;
+
+    float cov[6] = {};
+    for (int i = 0; i < 16; i++) {
+        float r = rgba[i * 4 + 0] - mean[0], g = rgba[i * 4 + 1] - mean[1], b = rgba[i * 4 + 2] - mean[2];
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b;
+    }
+    // a few power iterations are plenty for a 3x3 covariance
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int it = 0; it < 4; it++) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float m = std::max({ std::abs(x), std::abs(y), std::abs(z) });
+        if (m < 1e-6f)
+            break;
+        axis[0] = x / m;
+        axis[1] = y / m;
+        axis[2] = z / m;
+    }
+
+    float min_t = 1e30f, max_t = -1e30f;
+    for (int i = 0; i < 16; i++) {
+        float t = (rgba[i * 4 + 0] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] + (rgba[i * 4 + 2] - mean[2]) * axis[2];
+        min_t   = std::min(min_t, t);
+        max_t   = std::max(max_t, t);
+    }
+    float axis_len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    float hi[3], lo[3];
+    for (int c = 0; c < 3; c++) {
+        hi[c] = mean[c] + axis[c] * max_t / axis_len2;
+        lo[c] = mean[c] + axis[c] * min_t / axis_len2;
+    }
+
+    uint16_t c0 = packRGB565(hi);
+    uint16_t c1 = packRGB565(lo);
+    // c0 > c1 selects the 4 color mode, c0 == c1 is a flat block
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    float palette[4][3];
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+        palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+    }
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        for (int i = 0; i < 16; i++) {
+            float best_dist = 1e30f;
+            uint32_t best   = 0;
+            for (uint32_t p = 0; p < 4; p++) {
+                float dr = rgba[i * 4 + 0] - palette[p][0], dg = rgba[i * 4 + 1] - palette[p][1], db = rgba[i * 4 + 2] - palette[p][2];
+                float dist = dr * dr + dg * dg + db * db;
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best      = p;
+                }
+            }
+            indices |= best << (i * 2);
+        }
+    }
+
+    std::memcpy(dst + 0, &c0, 2);
+    std::memcpy(dst + 2, &c1, 2);
+    std::memcpy(dst + 4, &indices, 4);
+}
+
+// 8 value mode between the block's min and max, 3 bit indices
+void encodeSingleChannelBlock(const uint8_t* values, uint32_t stride, uint8_t* dst)
+{
+    uint8_t lo = 255, hi = 0;
+    for (int i = 0; i < 16; i++) {
+        lo = std::min(lo, values[i * stride]);
+        hi = std::max(hi, values[i * stride]);
+    }
+    dst[0] = hi;
+    dst[1] = lo;
+
+    uint64_t indices = 0;
+    if (hi != lo) {
+        // a0 > a1: palette is a0, a1, then 6 steps from a0 towards a1
+        float palette[8] = { static_cast<float>(hi), static_cast<float>(lo) };
+        for (int p = 1; p < 7; p++)
+            palette[p + 1] = ((7 - p) * hi + p * lo) / 7.0f;
+        for (int i = 0; i < 16; i++) {
+            float best_dist = 1e30f;
+            uint64_t best   = 0;
+            for (uint64_t p = 0; p < 8; p++) {
+                float dist = std::abs(values[i * stride] - palette[p]);
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best      = p;
+                }
+            }
+            indices |= best << (i * 3);
+        }
+    }
+    for (int b = 0; b < 6; b++)
+        dst[2 + b] = static_cast<uint8_t>(indices >> (b * 8));
+}
+}
+
+uint32_t TextureEncoder::mipLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+        levels++;
+    return levels;
+}
+
+void TextureEncoder::downsample(const uint8_t* src, uint32_t width, uint32_t height, uint32_t channels, uint8_t* dst)
+{
+    uint32_t dst_width  = std::max(1u, width / 2);
+    uint32_t dst_height = std::max(1u, height / 2);
+    for (uint32_t y = 0; y < dst_height; y++) {
+        uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+        for (uint32_t x = 0; x < dst_width; x++) {
+            uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            for (uint32_t c = 0; c < channels; c++) {
+                uint32_t sum = src[(static_cast<size_t>(y0) * width + x0) * channels + c]
+                    + src[(static_cast<size_t>(y0) * width + x1) * channels + c]
+                    + src[(static_cast<size_t>(y1) * width + x0) * channels + c]
+                    + src[(static_cast<size_t>(y1) * width + x1) * channels + c];
+                dst[(static_cast<size_t>(y) * dst_width + x) * channels + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+void TextureEncoder::downsample(const float* src, uint32_t width, uint32_t height, uint32_t channels, float* dst)
+{
+    uint32_t dst_width  = std::max(1u, width / 2);
+    uint32_t dst_height = std::max(1u, height / 2);
+    for (uint32_t y = 0; y < dst_height; y++) {
+        uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+        for (uint32_t x = 0; x < dst_width; x++) {
+            uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            for (uint32_t c = 0; c < channels; c++) {
+                float sum = src[(static_cast<size_t>(y0) * width + x0) * channels + c]
+                    + src[(static_cast<size_t>(y0) * width + x1) * channels + c]
+                    + src[(static_cast<size_t>(y1) * width + x0) * channels + c]
+                    + src[(static_cast<size_t>(y1) * width + x1) * channels + c];
+                dst[(static_cast<size_t>(y) * dst_width + x) * channels + c] = sum * 0.25f;
+            }
+        }
+    }
+}
+
+size_t TextureEncoder::compressedSize(uint32_t width, uint32_t height, uint32_t block_size)
+{
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * block_size;
+}
+
+void TextureEncoder::encodeBC1(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* dst)
+{
+    uint8_t block[16 * 4];
+    for (uint32_t by = 0; by < (height + 3) / 4; by++) {
+        for (uint32_t bx = 0; bx < (width + 3) / 4; bx++) {
+            fetchBlock(rgba, width, height, 4, bx, by, block);
+            encodeColorBlock(block, dst);
+            dst += 8;
+        }
+    }
+}
+
+void TextureEncoder::encodeBC3(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* dst)
+{
+    uint8_t block[16 * 4];
+    for (uint32_t by = 0; by < (height + 3) / 4; by++) {
+        for (uint32_t bx = 0; bx < (width + 3) / 4; bx++) {
+            fetchBlock(rgba, width, height, 4, bx, by, block);
+            encodeSingleChannelBlock(block + 3, 4, dst);
+            encodeColorBlock(block, dst + 8);
+            dst += 16;
+        }
+    }
+}
+
+void TextureEncoder::encodeBC4(const uint8_t* r, uint32_t width, uint32_t height, uint8_t* dst)
+{
+    uint8_t block[16];
+    for (uint32_t by = 0; by < (height + 3) / 4; by++) {
+        for (uint32_t bx = 0; bx < (width + 3) / 4; bx++) {
+            fetchBlock(r, width, height, 1, bx, by, block);
+            encodeSingleChannelBlock(block, 1, dst);
+            dst += 8;
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CPU mip generation and block compression for imported textures. Pixels are tightly packed and interleaved
+struct TextureEncoder {
+    static uint32_t mipLevelCount(uint32_t width, uint32_t height);
+
+    // 2x2 box filter into a max(1, width / 2) x max(1, height / 2) image, odd edges are clamped
+    static void downsample(const uint8_t* src, uint32_t width, uint32_t height, uint32_t channels, uint8_t* dst);
+    static void downsample(const float* src, uint32_t width, uint32_t height, uint32_t channels, float* dst);
+
+    // bytes of a width x height image in 4x4 blocks of block_size bytes
+    static size_t compressedSize(uint32_t width, uint32_t height, uint32_t block_size);
+
+    // BC1 (opaque RGB) from RGBA8, 8 bytes per block
+    static void encodeBC1(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* dst);
+    // BC3 (RGB + interpolated alpha) from RGBA8, 16 bytes per block
+    static void encodeBC3(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* dst);
+    // BC4 (single channel) from R8, 8 bytes per block
+    static void encodeBC4(const uint8_t* r, uint32_t width, uint32_t height, uint8_t* dst);
+};
@@ -0,0 +1,83 @@
+#include "vertex_packer.h"
+#include "function/tool/pixel_convert.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+int16_t toSnorm16(float v)
+{
+    return static_cast<int16_t>(std::round(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+
+float signNotZero(float v)
+{
+    return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+template <typename PackedType>
+void packAttributes(const Vertex& vertex, PackedType& packed)
+{
+    VertexPacker::octEncode(vertex.normal, packed.normal);
+    VertexPacker::octEncode(vertex.tangent, packed.tangent);
+    PixelConvert::floatToHalf(&vertex.uv.x, packed.uv, 2);
+}
+}
+
+std::vector<uint8_t> VertexPacker::pack(const std::vector<Vertex>& vertices, VertexFormat format, const AABB& aabb)
+{
+    std::vector<uint8_t> bytes;
+    switch (format) {
+    case VertexFormat::Float:
+        bytes.resize(vertices.size() * sizeof(Vertex));
+        std::memcpy(bytes.data(), vertices.data(), bytes.size());
+        break;
+    case VertexFormat::Packed: {
+        std::vector<PackedVertex> packed(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            packed[i].pos = vertices[i].pos;
+            packAttributes(vertices[i], packed[i]);
+        }
+        bytes.resize(packed.size() * sizeof(PackedVertex));
+        std::memcpy(bytes.data(), packed.data(), bytes.size());
+        break;
+    }
+    case VertexFormat::Quantized: {
+        const glm::vec3 extent = aabb.bmax - aabb.bmin;
+        std::vector<QuantizedVertex> packed(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            for (int c = 0; c < 3; c++) {
+                // flat axes (e.g. a plane) decode to bmin whatever is stored
+                float t              = extent[c] > 0.0f ? (vertices[i].pos[c] - aabb.bmin[c]) / extent[c] : 0.0f;
+                packed[i].pos[c]     = static_cast<uint16_t>(std::round(std::clamp(t, 0.0f, 1.0f) * 65535.0f));
+            }
+            packed[i].pos[3] = 0;
+            packAttributes(vertices[i], packed[i]);
+        }
+        bytes.resize(packed.size() * sizeof(QuantizedVertex));
+        std::memcpy(bytes.data(), packed.data(), bytes.size());
+        break;
+    }
+    }
+    return bytes;
+}
+
+void VertexPacker::octEncode(const glm::vec3& v, int16_t out[2])
+{
+    const float l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    if (l1 == 0.0f) {
+        out[0] = out[1] = 0;
+        return;
+    }
+    float x = v.x / l1;
+    float y = v.y / l1;
+    // fold the lower hemisphere over the diagonals
+    if (v.z < 0.0f) {
+        const float folded_x = (1.0f - std::abs(y)) * signNotZero(x);
+        const float folded_y = (1.0f - std::abs(x)) * signNotZero(y);
+        x                    = folded_x;
+        y                    = folded_y;
+    }
+    out[0] = toSnorm16(x);
+    out[1] = toSnorm16(y);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "function/type/aabb.h"
+#include "function/type/vertex.h"
+#include <cstdint>
+#include <vector>
+
+// Converts float vertices to the compact layouts of VertexFormat for upload
+struct VertexPacker {
+    // bytes of the vertex buffer in `format`. Quantized positions are relative to aabb,
+    // decode them with aabb.bmin + (aabb.bmax - aabb.bmin) * position
+    static std::vector<uint8_t> pack(const std::vector<Vertex>& vertices, VertexFormat format, const AABB& aabb);
+
+    // unit vector to the octahedron unfolded onto [-1, 1]^2, as snorm16
+    static void octEncode(const glm::vec3& v, int16_t out[2]);
+};
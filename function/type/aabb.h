@@ -7,4 +7,22 @@ struct AABB {
     float padding0;
     glm::vec3 bmax;
     float padding1;
+
+    AABB merge(const AABB& other) const
+    {
+        return AABB { .bmin = glm::min(bmin, other.bmin), .bmax = glm::max(bmax, other.bmax) };
+    }
+
+    // bounds of the box after an affine transform (Arvo), tight for translations and scales
+    AABB transform(const glm::mat4& m) const
+    {
+        AABB box { .bmin = glm::vec3(m[3]), .bmax = glm::vec3(m[3]) };
+        for (int i = 0; i < 3; i++) {
+            const glm::vec3 a = glm::vec3(m[i]) * bmin[i];
+            const glm::vec3 b = glm::vec3(m[i]) * bmax[i];
+            box.bmin += glm::min(a, b);
+            box.bmax += glm::max(a, b);
+        }
+        return box;
+    }
 };
@@ -5,7 +5,12 @@
 #include "core/vulkan/vulkan_util.h"
 #include "function/global_context.h"
 #include "function/resource_manager/resource_manager.h"
+#include "function/tool/pixel_convert.h"
+#include "function/tool/texture_encoder.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <filesystem>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
@@ -49,6 +54,8 @@ void Field::destroy()
 {
     Buffer::Delete(g_ctx.vk, attr_buf);
     Image::Delete(g_ctx.vk, field_img);
+    Buffer::Delete(g_ctx.vk, bricks);
+    Buffer::Delete(g_ctx.vk, macrocells);
 }
 
 void Field::init(const FieldConfiguration& cfg)
@@ -66,35 +73,260 @@ void Field::init(const FieldConfiguration& cfg)
 
     initFieldImage(cfg);
     g_ctx.dm.registerResource(field_img, DescriptorType::CombinedImageSampler);
+
+    if (data.brick_size > 0) {
+        initBricks();
+        g_ctx.dm.registerResource(bricks, DescriptorType::Storage);
+    }
+
+    initMacrocells();
+    g_ctx.dm.registerResource(macrocells, DescriptorType::Storage);
+
+    if (!cfg.path.empty())
+        updateFieldImage(loadVoxels(cfg));
 }
 
-void Field::initFieldImage(const FieldConfiguration& cfg)
+std::vector<float> Field::loadVoxels(const FieldConfiguration& cfg)
 {
-    auto extent = VkExtent3D {
-        static_cast<uint32_t>(cfg.dimension[0]),
-        static_cast<uint32_t>(cfg.dimension[1]),
-        static_cast<uint32_t>(cfg.dimension[2]),
-    };
-    field_img = Image::New(
+    std::vector<float> voxels;
+    if (std::filesystem::path(cfg.path).extension() == ".vti")
+        voxels = readVti<float>(cfg.path, cfg.name);
+    else
+        voxels = npy::read_npy<float>(cfg.path).data;
+
+    const auto count = static_cast<size_t>(cfg.dimension[0]) * cfg.dimension[1] * cfg.dimension[2];
+    if (voxels.size() != count)
+        throw std::runtime_error("field " + cfg.name + " has " + std::to_string(voxels.size()) + " voxels in " + cfg.path + ", its dimension needs " + std::to_string(count));
+    return voxels;
+}
+
+VkFormat Field::storageFormat(const std::string& format)
+{
+    if (format == "r32_sfloat")
+        return VK_FORMAT_R32_SFLOAT;
+    if (format == "r16_sfloat")
+        return VK_FORMAT_R16_SFLOAT;
+    if (format == "r16_unorm")
+        return VK_FORMAT_R16_UNORM;
+    if (format == "r8_unorm")
+        return VK_FORMAT_R8_UNORM;
+    if (format == "bc4") {
+        // BC4 decodes like R8_UNORM, so a device without BC for 3D images takes that instead
+        VkImageFormatProperties properties;
+        if (g_ctx.vk.textureCompressionBC
+            && vkGetPhysicalDeviceImageFormatProperties(
+                   g_ctx.vk.physicalDevice,
+                   VK_FORMAT_BC4_UNORM_BLOCK,
+                   VK_IMAGE_TYPE_3D,
+                   VK_IMAGE_TILING_OPTIMAL,
+                   VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                   0,
+                   &properties)
+                == VK_SUCCESS)
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+        return VK_FORMAT_R8_UNORM;
+    }
+    throw std::runtime_error("unknown field format " + format);
+}
+
+Image Field::createImage(VkFormat format, VkExtent3D extent, bool external)
+{
+    auto image = Image::New(
         g_ctx.vk,
-        VK_FORMAT_R32_SFLOAT,
+        format,
         extent,
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
         VK_IMAGE_ASPECT_COLOR_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         1,
         1,
-        true,
+        external,
         VK_IMAGE_TILING_OPTIMAL,
         VK_IMAGE_TYPE_3D,
         VK_IMAGE_VIEW_TYPE_3D);
-    field_img.AddDefaultSampler(g_ctx.vk);
-    field_img.TransitionLayoutSingleTime(g_ctx.vk, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    image.AddDefaultSampler(g_ctx.vk);
+    image.TransitionLayoutSingleTime(g_ctx.vk, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    return image;
+}
+
+void Field::initFieldImage(const FieldConfiguration& cfg)
+{
+    const VkFormat format = storageFormat(cfg.format);
+    if (data.brick_size > 0) {
+        // a single slot until the first upload tells how many bricks are occupied
+        const uint32_t stride = data.brick_size + 2;
+        field_img             = createImage(format, VkExtent3D { stride, stride, stride }, false);
+        return;
+    }
+
+    auto extent = VkExtent3D {
+        static_cast<uint32_t>(cfg.dimension[0]),
+        static_cast<uint32_t>(cfg.dimension[1]),
+        static_cast<uint32_t>(cfg.dimension[2]),
+    };
+    // CUDA only maps the float formats, the normalized and block compressed images are only uploaded
+    external  = format == VK_FORMAT_R32_SFLOAT || format == VK_FORMAT_R16_SFLOAT;
+    field_img = createImage(format, extent, external);
+}
+
+void Field::initBricks()
+{
+    const glm::ivec3 count = (dimension + static_cast<int>(data.brick_size) - 1) / static_cast<int>(data.brick_size);
+    const std::vector<uint32_t> slots(static_cast<size_t>(count.x) * count.y * count.z, EMPTY_BRICK);
+    bricks = Buffer::New(
+        g_ctx.vk,
+        slots.size() * sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    bricks.Update(g_ctx.vk, slots.data(), slots.size() * sizeof(uint32_t));
+}
+
+void Field::initMacrocells()
+{
+    const glm::ivec3 count = (dimension + static_cast<int>(data.macrocell_size) - 1) / static_cast<int>(data.macrocell_size);
+    macrocells             = Buffer::New(
+        g_ctx.vk,
+        static_cast<VkDeviceSize>(count.x) * count.y * count.z * sizeof(glm::vec2),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 }
 
 void Field::updateFieldImage(const std::vector<float>& data)
 {
-    field_img.Update(g_ctx.vk, data.data());
+    const size_t count = static_cast<size_t>(dimension.x) * dimension.y * dimension.z;
+    assert(data.size() == count);
+
+    std::vector<float> encoded(count);
+    for (size_t i = 0; i < count; i++)
+        encoded[i] = (data[i] - this->data.bias) / this->data.scale;
+
+    if (this->data.brick_size > 0)
+        uploadTexels(packBricks(encoded));
+    else
+        uploadTexels(encoded);
+}
+
+std::vector<float> Field::packBricks(const std::vector<float>& encoded)
+{
+    const int size         = static_cast<int>(data.brick_size);
+    const int stride       = size + 2;
+    const glm::ivec3 count = (dimension + size - 1) / size;
+    auto voxel             = [&](const glm::ivec3& p) {
+        if (glm::any(glm::lessThan(p, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(p, dimension)))
+            return 0.0f;
+        return encoded[(static_cast<size_t>(p.z) * dimension.y + p.y) * dimension.x + p.x];
+    };
+
+    // a brick is kept when a voxel a sample inside it can blend, its ring included, isn't zero
+    std::vector<uint32_t> slots(static_cast<size_t>(count.x) * count.y * count.z, EMPTY_BRICK);
+    std::vector<glm::ivec3> occupied;
+    for (int bz = 0; bz < count.z; bz++) {
+        for (int by = 0; by < count.y; by++) {
+            for (int bx = 0; bx < count.x; bx++) {
+                const glm::ivec3 brick(bx, by, bz);
+                const glm::ivec3 first = glm::max(brick * size - 1, glm::ivec3(0));
+                const glm::ivec3 last  = glm::min((brick + 1) * size, dimension - 1);
+                bool empty             = true;
+                for (int z = first.z; z <= last.z && empty; z++)
+                    for (int y = first.y; y <= last.y && empty; y++)
+                        for (int x = first.x; x <= last.x && empty; x++)
+                            empty = voxel({ x, y, z }) == 0.0f;
+                if (!empty)
+                    occupied.emplace_back(brick);
+            }
+        }
+    }
+
+    // the atlas only grows, a later upload with fewer bricks keeps its slots
+    glm::uvec3 slots_per_axis(field_img.extent.width / stride, field_img.extent.height / stride, field_img.extent.depth / stride);
+    if (occupied.size() > static_cast<size_t>(slots_per_axis.x) * slots_per_axis.y * slots_per_axis.z) {
+        const auto side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(occupied.size()))));
+        slots_per_axis  = glm::uvec3(side, side, static_cast<uint32_t>((occupied.size() + side * side - 1) / (side * side)));
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(g_ctx.vk.physicalDevice, &properties);
+        if (slots_per_axis.x > 1024 || slots_per_axis.x * stride > properties.limits.maxImageDimension3D)
+            throw std::runtime_error("field " + name + " has too many occupied bricks for its atlas");
+
+        auto fresh = createImage(field_img.format, VkExtent3D { slots_per_axis.x * stride, slots_per_axis.y * stride, slots_per_axis.z * stride }, false);
+        // Fields::Param holds the handle, which is looked up by id. The frames in flight may still sample
+        // the old atlas through it
+        fresh.id = field_img.id;
+        vkDeviceWaitIdle(g_ctx.vk.device);
+        g_ctx.dm.updateResourceRegistration(fresh);
+        Image::Delete(g_ctx.vk, field_img);
+        field_img = fresh;
+    }
+
+    const VkExtent3D extent = field_img.extent;
+    std::vector<float> atlas(static_cast<size_t>(extent.width) * extent.height * extent.depth, 0.0f);
+    for (uint32_t i = 0; i < occupied.size(); i++) {
+        const glm::uvec3 slot(i % slots_per_axis.x, i / slots_per_axis.x % slots_per_axis.y, i / (slots_per_axis.x * slots_per_axis.y));
+        const glm::ivec3& brick = occupied[i];
+        slots[(static_cast<size_t>(brick.z) * count.y + brick.y) * count.x + brick.x] = slot.x | slot.y << 10 | slot.z << 20;
+
+        // the brick and its ring, the ring's voxels outside the field are the zero border
+        const glm::ivec3 origin = brick * size - 1;
+        const glm::uvec3 corner = slot * static_cast<uint32_t>(stride);
+        for (int z = 0; z < stride; z++)
+            for (int y = 0; y < stride; y++)
+                for (int x = 0; x < stride; x++)
+                    atlas[((static_cast<size_t>(corner.z) + z) * extent.height + corner.y + y) * extent.width + corner.x + x]
+                        = voxel(origin + glm::ivec3(x, y, z));
+    }
+    bricks.Update(g_ctx.vk, slots.data(), slots.size() * sizeof(uint32_t));
+
+    INFO_ALL("Field {}: {} of {} bricks occupied, atlas of {}x{}x{} texels",
+             name, occupied.size(), slots.size(), extent.width, extent.height, extent.depth);
+    return atlas;
+}
+
+void Field::uploadTexels(const std::vector<float>& encoded)
+{
+    const VkExtent3D extent = field_img.extent;
+    const size_t count      = encoded.size();
+
+    std::vector<uint8_t> texels;
+    switch (field_img.format) {
+    case VK_FORMAT_R32_SFLOAT:
+        texels.resize(count * sizeof(float));
+        std::memcpy(texels.data(), encoded.data(), texels.size());
+        break;
+    case VK_FORMAT_R16_SFLOAT:
+        texels.resize(count * sizeof(uint16_t));
+        PixelConvert::floatToHalf(encoded.data(), reinterpret_cast<uint16_t*>(texels.data()), count);
+        break;
+    case VK_FORMAT_R16_UNORM: {
+        texels.resize(count * sizeof(uint16_t));
+        auto* dst = reinterpret_cast<uint16_t*>(texels.data());
+        for (size_t i = 0; i < count; i++)
+            dst[i] = static_cast<uint16_t>(std::lround(std::clamp(encoded[i], 0.0f, 1.0f) * 65535.0f));
+        break;
+    }
+    case VK_FORMAT_R8_UNORM:
+    case VK_FORMAT_BC4_UNORM_BLOCK: {
+        std::vector<uint8_t> r(count);
+        for (size_t i = 0; i < count; i++)
+            r[i] = static_cast<uint8_t>(std::lround(std::clamp(encoded[i], 0.0f, 1.0f) * 255.0f));
+        if (field_img.format == VK_FORMAT_R8_UNORM) {
+            texels = std::move(r);
+            break;
+        }
+        // the blocks of a 3D image are 4x4 in every slice
+        const size_t slice      = static_cast<size_t>(extent.width) * extent.height;
+        const size_t slice_size = TextureEncoder::compressedSize(extent.width, extent.height, 8);
+        texels.resize(slice_size * extent.depth);
+        for (uint32_t z = 0; z < extent.depth; z++)
+            TextureEncoder::encodeBC4(r.data() + z * slice, extent.width, extent.height, texels.data() + z * slice_size);
+        break;
+    }
+    default:
+        throw std::runtime_error("field image has an unsupported format");
+    }
+
+    field_img.UpdateMipChain(g_ctx.vk, texels.data(), { 0, texels.size() });
+    field_img.TransitionLayoutSingleTime(g_ctx.vk, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 }
 
 void SelfIlluminationLights::destroy()
@@ -211,6 +443,8 @@ Fields Fields::fromConfiguration(FieldsConfiguration& cfg)
     Fields fields;
     fields.step            = cfg.step;
     fields.has_temperature = false;
+    if (cfg.macrocell_size == 0)
+        throw std::runtime_error("fields need a positive macrocell_size");
 
     assert(cfg.arr.size() <= MAX_FIELDS);
     int temp_field_cnt = 0;
@@ -220,18 +454,41 @@ Fields Fields::fromConfiguration(FieldsConfiguration& cfg)
         field.name      = field_config.name;
         field.dimension = arrayToVec3(field_config.dimension);
 
-        glm::vec3 start_pos     = arrayToVec3(field_config.start_pos);
-        glm::vec3 size          = arrayToVec3(field_config.size);
-        field.data.to_local_uvw = Fields::toLocaluvw(g_ctx.rm->camera, start_pos, size);
-        field.data.scatter      = arrayToVec3(field_config.scatter);
-        field.data.absorption   = arrayToVec3(field_config.absorption);
-        field.data.aabb         = AABB { .bmin = start_pos, .bmax = start_pos + size };
+        glm::vec3 start_pos       = arrayToVec3(field_config.start_pos);
+        glm::vec3 size            = arrayToVec3(field_config.size);
+        field.data.to_local_uvw   = Fields::toLocaluvw(g_ctx.rm->camera, start_pos, size);
+        field.data.scatter        = arrayToVec3(field_config.scatter);
+        field.data.absorption     = arrayToVec3(field_config.absorption);
+        field.data.macrocell_size = cfg.macrocell_size;
+        field.data.aabb           = AABB { .bmin = start_pos, .bmax = start_pos + size };
+        field.data.scale          = field_config.scale;
+        field.data.bias           = field_config.bias;
+        field.data.brick_size     = field_config.brick_size;
+        field.data.dimension      = field.dimension;
+        if (!(field_config.scale > 0.0f))
+            throw std::runtime_error("field " + field_config.name + " needs a positive scale");
+        // CUDA can't write a block compressed image, it is only filled from the field's file
+        if (field_config.format == "bc4" && field_config.path.empty())
+            throw std::runtime_error("field " + field_config.name + " is bc4, which needs a path to load it from");
+        if (field_config.brick_size != 0 && field_config.brick_size != 8 && field_config.brick_size != 16)
+            throw std::runtime_error("field " + field_config.name + " needs a brick_size of 0, 8 or 16");
+        // CUDA writes a surface's raw integers, it has no normalized view to quantize the field into
+        if ((field_config.format == "r16_unorm" || field_config.format == "r8_unorm") && field_config.path.empty())
+            throw std::runtime_error("field " + field_config.name + " is " + field_config.format + ", which needs a path to load it from");
+        // like bc4, CUDA writes a dense image and can't target the atlas
+        if (field_config.brick_size > 0 && field_config.path.empty())
+            throw std::runtime_error("field " + field_config.name + " is bricked, which needs a path to load it from");
         if (field_config.data_type == "concentration") {
             field.data.type = FieldDataType::CONCENTRATION;
         } else if (field_config.data_type == "temperature") {
             assert(temp_field_cnt == 0 && "Only one temperature field is supported");
             field.data.type        = FieldDataType::TEMPERATURE;
             fields.has_temperature = true;
+            // FireLightsUpdater reads the temperatures in CUDA as raw floats
+            if (field_config.format != "r32_sfloat")
+                throw std::runtime_error("field " + field_config.name + " holds the temperature, which needs the r32_sfloat format");
+            if (field_config.brick_size > 0)
+                throw std::runtime_error("field " + field_config.name + " holds the temperature, which CUDA can't read from a brick atlas");
         }
 
         field.init(field_config);
@@ -257,6 +514,11 @@ Fields Fields::fromConfiguration(FieldsConfiguration& cfg)
             = g_ctx.dm.getResourceHandle(fields.fields[i].attr_buf.id);
         fields.param.img[i * 4]
             = g_ctx.dm.getResourceHandle(fields.fields[i].field_img.id);
+        fields.param.macrocells[i * 4]
+            = g_ctx.dm.getResourceHandle(fields.fields[i].macrocells.id);
+        if (fields.fields[i].data.brick_size > 0)
+            fields.param.bricks[i * 4]
+                = g_ctx.dm.getResourceHandle(fields.fields[i].bricks.id);
     }
     fields.paramBuffer = Buffer::New(
         g_ctx.vk,
@@ -281,6 +543,8 @@ glm::mat4x4 Fields::toLocaluvw(const Camera& camera, const glm::vec3& start_pos,
 #ifdef _WIN64
 HANDLE Fields::getVkFieldMemHandle(int index)
 {
+    if (!fields[index].external)
+        throw std::runtime_error("field " + fields[index].name + " isn't exported, a bricked, normalized or block compressed field can't be imported into CUDA");
     HANDLE handle;
     VkMemoryGetWin32HandleInfoKHR vkMemoryGetWin32HandleInfoKHR = {};
     vkMemoryGetWin32HandleInfoKHR.sType                         = VK_STRUCTURE_TYPE_MEMORY_GET_WIN32_HANDLE_INFO_KHR;
@@ -293,23 +557,16 @@ HANDLE Fields::getVkFieldMemHandle(int index)
 
 HANDLE Fields::getVkFieldMemHandle(const std::string& field_name)
 {
-    HANDLE handle;
-    VkMemoryGetWin32HandleInfoKHR vkMemoryGetWin32HandleInfoKHR = {};
-    vkMemoryGetWin32HandleInfoKHR.sType                         = VK_STRUCTURE_TYPE_MEMORY_GET_WIN32_HANDLE_INFO_KHR;
-    for (const auto& field : fields) {
-        if (field.name == field_name) {
-            vkMemoryGetWin32HandleInfoKHR.memory = field.field_img.memory;
-            break;
-        }
-    }
-    vkMemoryGetWin32HandleInfoKHR.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT;
-
-    fpGetMemoryWin32Handle(g_ctx.vk.device, &vkMemoryGetWin32HandleInfoKHR, &handle);
-    return handle;
+    for (int i = 0; i < fields.size(); i++)
+        if (fields[i].name == field_name)
+            return getVkFieldMemHandle(i);
+    throw std::runtime_error("no field named " + field_name);
 }
 #else
 int Fields::getVkFieldMemHandle(int index)
 {
+    if (!fields[index].external)
+        throw std::runtime_error("field " + fields[index].name + " isn't exported, a bricked, normalized or block compressed field can't be imported into CUDA");
     int fd;
     VkMemoryGetFdInfoKHR vkMemoryGetFdInfoKHR = {};
     vkMemoryGetFdInfoKHR.sType                = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR;
@@ -322,18 +579,9 @@ int Fields::getVkFieldMemHandle(int index)
 
 int Fields::getVkFieldMemHandle(const std::string& field_name)
 {
-    int fd;
-    VkMemoryGetFdInfoKHR vkMemoryGetFdInfoKHR = {};
-    vkMemoryGetFdInfoKHR.sType                = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR;
-    for (const auto& field : fields) {
-        if (field.name == field_name) {
-            vkMemoryGetFdInfoKHR.memory = field.field_img.memory;
-            break;
-        }
-    }
-    vkMemoryGetFdInfoKHR.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
-
-    fpGetMemoryFdKHR(g_ctx.vk.device, &vkMemoryGetFdInfoKHR, &fd);
-    return fd;
+    for (int i = 0; i < fields.size(); i++)
+        if (fields[i].name == field_name)
+            return getVkFieldMemHandle(i);
+    throw std::runtime_error("no field named " + field_name);
 }
 #endif
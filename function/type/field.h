@@ -20,14 +20,24 @@ enum class FieldDataType : uint32_t {
 };
 
 inline constexpr uint32_t MAX_FIELDS = 2;
+// the slot of a brick with no value in a bricked field, see bricks.glsl
+inline constexpr uint32_t EMPTY_BRICK = 0xffffffff;
 
 struct FieldData {
     glm::mat4x4 to_local_uvw;
     glm::vec3 scatter;
     FieldDataType type;
     glm::vec3 absorption;
-    float padding0;
+    uint32_t macrocell_size;
     AABB aabb;
+    // the shaders decode a texel as texel * scale + bias
+    float scale;
+    float bias;
+    // voxels along an edge of a bricked field's bricks, 0 for a dense field, see bricks.glsl
+    uint32_t brick_size;
+    float padding0;
+    glm::ivec3 dimension;
+    float padding1;
 };
 
 struct Field {
@@ -37,14 +47,30 @@ struct Field {
     FieldData data;
     Vk::Buffer attr_buf;
 
+    // the voxels of a dense field, the brick atlas of a bricked one
     Vk::Image field_img;
+    // whether field_img can be imported into CUDA, see Fields::getVkFieldMemHandle
+    bool external = false;
+    // the atlas slot of every brick of a bricked field, see bricks.glsl
+    Vk::Buffer bricks;
+    // min and max of every macrocell, written by the MacrocellGrid node, see macrocells.glsl
+    Vk::Buffer macrocells;
 
     void destroy();
     void init(const FieldConfiguration& cfg);
     void updateFieldImage(const std::vector<float>& data);
 
 private:
+    static VkFormat storageFormat(const std::string& format);
+    static std::vector<float> loadVoxels(const FieldConfiguration& cfg);
+    static Vk::Image createImage(VkFormat format, VkExtent3D extent, bool external);
     void initFieldImage(const FieldConfiguration& cfg);
+    void initBricks();
+    void initMacrocells();
+    // packs the occupied bricks into the atlas, growing it when they don't fit
+    std::vector<float> packBricks(const std::vector<float>& encoded);
+    // converts the encoded texels of field_img to its format and uploads them
+    void uploadTexels(const std::vector<float>& encoded);
 };
 
 class FireLightsUpdater;
@@ -65,6 +91,8 @@ struct Fields {
     struct Param {
         Vk::DescriptorHandle attr[MAX_FIELDS * 4]; // * 4 for alignment
         Vk::DescriptorHandle img[MAX_FIELDS * 4];
+        Vk::DescriptorHandle macrocells[MAX_FIELDS * 4];
+        Vk::DescriptorHandle bricks[MAX_FIELDS * 4];
     };
 
     Fields();
@@ -78,7 +106,7 @@ struct Fields {
     float step;
 
     // pipelines/render graph can use these
-    bool has_temperature;
+    bool has_temperature = false;
     glm::ivec3 lights_dim;
     Lights lights;
     std::unique_ptr<FireLightsUpdater> lights_updater;
@@ -1,14 +1,18 @@
 #include "mesh.h"
+#include "core/filesystem/file.h"
 #include "core/math/math.h"
 #include "core/tool/logger.h"
-#include "function/global_context.h"
 #include "function/tool/geometry.h"
+#include "function/tool/mesh_optimizer.h"
+#include "function/tool/mesh_simplifier.h"
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tiny_obj_loader.h"
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
+#include <algorithm>
 #include <boost/functional/hash.hpp>
+#include <limits>
 
 using namespace Vk;
 
@@ -29,7 +33,7 @@ struct IndexEqual {
     }
 };
 
-Mesh Mesh::fromConfiguration(MeshConfiguration& config)
+Mesh Mesh::loadFromConfiguration(MeshConfiguration& config)
 {
     Mesh mesh;
 
@@ -46,26 +50,116 @@ Mesh Mesh::fromConfiguration(MeshConfiguration& config)
         throw std::runtime_error("Mesh type not supported");
     }
 
+    // imported meshes are optimized and simplified before they go to the cache
+    if (type != "file" && shouldOptimize(config))
+        mesh.optimize();
+    if (type != "file")
+        mesh.generateLods(lodLevels(config));
+
     mesh.name = config.at("name").get<std::string>();
 
     return mesh;
 }
 
-void Mesh::initBuffersFromData()
+bool Mesh::shouldOptimize(MeshConfiguration& config)
+{
+    return config["optimize"] == nullptr || config["optimize"].get<bool>();
+}
+
+uint32_t Mesh::lodLevels(MeshConfiguration& config)
+{
+    return config["lod_levels"] == nullptr ? DEFAULT_LOD_LEVELS : config["lod_levels"].get<uint32_t>();
+}
+
+void Mesh::optimize()
+{
+    float acmr_before = MeshOptimizer::averageCacheMissRatio(data.indices, data.vertices.size());
+    // submeshes keep their triangles, only the order within each one changes
+    for (const auto& submesh : submeshes) {
+        auto first = data.indices.begin() + submesh.firstIndex;
+        std::vector<uint32_t> indices(first, first + submesh.indexCount);
+        MeshOptimizer::optimizeVertexCache(indices, data.vertices.size());
+        std::copy(indices.begin(), indices.end(), first);
+    }
+    float acmr_after = MeshOptimizer::averageCacheMissRatio(data.indices, data.vertices.size());
+
+    // submeshes share no vertices, so numbering by first use keeps each one's vertices contiguous
+    auto remap = MeshOptimizer::optimizeVertexFetch(data.indices, data.vertices.size());
+    std::vector<Vertex> vertices(data.vertices.size());
+    for (size_t i = 0; i < remap.size(); i++) {
+        vertices[remap[i]] = data.vertices[i];
+    }
+    data.vertices = std::move(vertices);
+    for (auto& submesh : submeshes) {
+        if (submesh.indexCount == 0)
+            continue;
+        auto first          = data.indices.begin() + submesh.firstIndex;
+        auto [min, max]     = std::minmax_element(first, first + submesh.indexCount);
+        submesh.firstVertex = *min;
+        submesh.vertexCount = *max - *min + 1;
+    }
+
+    INFO_ALL("Optimized mesh: {} vertices, {} triangles, {} submeshes, ACMR {:.3f} -> {:.3f}",
+             data.vertices.size(), data.indices.size() / 3, submeshes.size(), acmr_before, acmr_after);
+}
+
+void Mesh::generateLods(uint32_t levels)
+{
+    size_t base_index_count = 0;
+    for (const auto& submesh : submeshes) {
+        base_index_count += submesh.indexCount;
+    }
+    if (base_index_count / 3 < MIN_LOD_TRIANGLES)
+        return;
+
+    std::vector<glm::vec3> positions(data.vertices.size());
+    std::transform(data.vertices.begin(), data.vertices.end(), positions.begin(), [](const Vertex& v) { return v.pos; });
+    const float diagonal = std::max(glm::length(aabb.bmax - aabb.bmin), std::numeric_limits<float>::min());
+
+    // every level starts from the full mesh, so its error is against the original surface
+    size_t previous = base_index_count;
+    for (uint32_t level = 1; level <= levels; level++) {
+        MeshLod lod { .error = 0.0f };
+        std::vector<uint32_t> indices;
+        for (const auto& submesh : submeshes) {
+            auto first = data.indices.begin() + submesh.firstIndex;
+            float error;
+            auto simplified = MeshSimplifier::simplify(
+                std::vector<uint32_t>(first, first + submesh.indexCount), positions, (submesh.indexCount / 3 >> level) * 3, error);
+            MeshOptimizer::optimizeVertexCache(simplified, data.vertices.size());
+
+            Submesh lod_submesh    = submesh;
+            lod_submesh.firstIndex = static_cast<uint32_t>(data.indices.size() + indices.size());
+            lod_submesh.indexCount = static_cast<uint32_t>(simplified.size());
+            lod.submeshes.emplace_back(lod_submesh);
+            lod.error = std::max(lod.error, error / diagonal);
+            indices.insert(indices.end(), simplified.begin(), simplified.end());
+        }
+        // seams and borders can't collapse, past some point a level saves little but still costs memory
+        if (indices.size() > previous * MAX_LOD_RATIO)
+            break;
+        data.indices.insert(data.indices.end(), indices.begin(), indices.end());
+        lods.emplace_back(std::move(lod));
+        previous = indices.size();
+    }
+
+    if (!lods.empty()) {
+        INFO_ALL("Generated {} LODs: {} -> {} triangles, error {:.4f}",
+                 lods.size(), base_index_count / 3, previous / 3, lods.back().error);
+    }
+}
+
+uint32_t Mesh::selectLod(float screen_size, float pixel_error, float hysteresis, uint32_t current) const
 {
-    vertexBuffer = Buffer::New(
-        g_ctx.vk,
-        sizeof(Vertex) * data.vertices.size(),
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    vertexBuffer.Update(g_ctx.vk, data.vertices.data(), vertexBuffer.size);
-
-    indexBuffer = Buffer::New(
-        g_ctx.vk,
-        sizeof(uint32_t) * data.indices.size(),
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    indexBuffer.Update(g_ctx.vk, data.indices.data(), indexBuffer.size);
+    // the errors grow with the level
+    auto coarsest = [&](float limit) {
+        uint32_t lod = 0;
+        while (lod < lods.size() && lods[lod].error * screen_size <= limit)
+            lod++;
+        return lod;
+    };
+    // a band around the threshold, an object sitting on it doesn't switch back and forth every frame
+    return std::clamp(current, coarsest(pixel_error * (1.0f - hysteresis)), coarsest(pixel_error * (1.0f + hysteresis)));
 }
 
 Mesh Mesh::fileMesh(MeshConfiguration& config)
@@ -80,37 +174,57 @@ Mesh Mesh::fileMesh(MeshConfiguration& config)
         flags |= aiProcess_FlipUVs;
     }
 
+    bool use_cache = config["cache"] == nullptr || config["cache"].get<bool>();
+    bool optimize  = shouldOptimize(config);
+    CacheKey key { use_cache ? hashFile(inputfile) : 0, CacheKey::Loader::Assimp, static_cast<uint32_t>(flags), optimize, lodLevels(config) };
+    if (use_cache && loadCache(inputfile, key, mesh))
+        return mesh;
+
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(inputfile, flags);
     if (!scene) {
         ERROR_ALL("Assimp: " + std::string(importer.GetErrorString()));
         throw std::runtime_error("Assimp: " + std::string(importer.GetErrorString()));
     }
-    assert(scene->mNumMeshes == 1 && "Only one mesh in a file is supported");
-
-    const aiMesh* ai_mesh = scene->mMeshes[0];
-    assert(ai_mesh->GetNumUVChannels() == 1 && "Only one UV channel is supported");
-
-    mesh.data.vertices.resize(ai_mesh->mNumVertices);
-    for (uint32_t i = 0; i < ai_mesh->mNumVertices; i++) {
-        mesh.data.vertices[i].pos = glm::vec3(
-            ai_mesh->mVertices[i].x, ai_mesh->mVertices[i].y, ai_mesh->mVertices[i].z);
-        mesh.data.vertices[i].normal = glm::vec3(
-            ai_mesh->mNormals[i].x, ai_mesh->mNormals[i].y, ai_mesh->mNormals[i].z);
-        mesh.data.vertices[i].tangent = glm::vec3(
-            ai_mesh->mTangents[i].x, ai_mesh->mTangents[i].y, ai_mesh->mTangents[i].z);
-        mesh.data.vertices[i].uv = glm::vec2(
-            ai_mesh->mTextureCoords[0][i].x, ai_mesh->mTextureCoords[0][i].y);
-    }
+    // every mesh of the file becomes a submesh
+    for (uint32_t m = 0; m < scene->mNumMeshes; m++) {
+        const aiMesh* ai_mesh = scene->mMeshes[m];
+        assert(ai_mesh->GetNumUVChannels() == 1 && "Only one UV channel is supported");
+
+        const auto first_vertex = static_cast<uint32_t>(mesh.data.vertices.size());
+        const auto first_index  = static_cast<uint32_t>(mesh.data.indices.size());
+        mesh.data.vertices.resize(first_vertex + ai_mesh->mNumVertices);
+        for (uint32_t i = 0; i < ai_mesh->mNumVertices; i++) {
+            auto& vertex = mesh.data.vertices[first_vertex + i];
+            vertex.pos   = glm::vec3(
+                ai_mesh->mVertices[i].x, ai_mesh->mVertices[i].y, ai_mesh->mVertices[i].z);
+            vertex.normal = glm::vec3(
+                ai_mesh->mNormals[i].x, ai_mesh->mNormals[i].y, ai_mesh->mNormals[i].z);
+            vertex.tangent = glm::vec3(
+                ai_mesh->mTangents[i].x, ai_mesh->mTangents[i].y, ai_mesh->mTangents[i].z);
+            vertex.uv = glm::vec2(
+                ai_mesh->mTextureCoords[0][i].x, ai_mesh->mTextureCoords[0][i].y);
+        }
 
-    mesh.data.indices.resize(ai_mesh->mNumFaces * 3);
-    for (uint32_t i = 0; i < ai_mesh->mNumFaces; i++) {
-        assert(ai_mesh->mFaces[i].mNumIndices == 3 && "Only triangles are supported");
-        for (uint32_t j = 0; j < 3; j++)
-            mesh.data.indices[i * 3 + j] = ai_mesh->mFaces[i].mIndices[j];
+        mesh.data.indices.resize(first_index + ai_mesh->mNumFaces * 3);
+        for (uint32_t i = 0; i < ai_mesh->mNumFaces; i++) {
+            assert(ai_mesh->mFaces[i].mNumIndices == 3 && "Only triangles are supported");
+            for (uint32_t j = 0; j < 3; j++)
+                mesh.data.indices[first_index + i * 3 + j] = first_vertex + ai_mesh->mFaces[i].mIndices[j];
+        }
+        mesh.submeshes.emplace_back(Submesh {
+            .firstIndex  = first_index,
+            .indexCount  = ai_mesh->mNumFaces * 3,
+            .firstVertex = first_vertex,
+            .vertexCount = ai_mesh->mNumVertices });
     }
+    mesh.calculateAABB();
+    if (optimize)
+        mesh.optimize();
+    mesh.generateLods(key.lod_levels);
 
-    mesh.initBuffersFromData();
+    if (use_cache)
+        storeCache(inputfile, key, mesh);
 
     return mesh;
 }
@@ -128,7 +242,7 @@ Mesh Mesh::sphereMesh(MeshConfiguration& config)
     mesh.isWaterTight        = true;
     // mesh.calculateTangents();
 
-    mesh.initBuffersFromData();
+    mesh.calculateAABB();
 
     return mesh;
 }
@@ -145,7 +259,7 @@ Mesh Mesh::cubeMesh(MeshConfiguration& config)
     mesh.isWaterTight        = true;
     mesh.calculateTangents();
 
-    mesh.initBuffersFromData();
+    mesh.calculateAABB();
 
     return mesh;
 }
@@ -163,7 +277,7 @@ Mesh Mesh::planeMesh(MeshConfiguration& config)
     mesh.isWaterTight        = false;
     mesh.calculateTangents();
 
-    mesh.initBuffersFromData();
+    mesh.calculateAABB();
 
     return mesh;
 }
@@ -174,6 +288,13 @@ Mesh Mesh::objMesh(MeshConfiguration& config)
     mesh.isWaterTight = true;
 
     std::string inputfile = config.at("path").get<std::string>();
+
+    bool use_cache = config["cache"] == nullptr || config["cache"].get<bool>();
+    bool optimize  = shouldOptimize(config);
+    CacheKey key { use_cache ? hashFile(inputfile) : 0, CacheKey::Loader::TinyObj, 0, optimize, lodLevels(config) };
+    if (use_cache && loadCache(inputfile, key, mesh))
+        return mesh;
+
     tinyobj::ObjReaderConfig reader_config;
     tinyobj::ObjReader reader;
 
@@ -189,38 +310,51 @@ Mesh Mesh::objMesh(MeshConfiguration& config)
 
     const auto& attrib = reader.GetAttrib();
     const auto& shapes = reader.GetShapes();
-    assert(shapes.size() == 1);
-    const auto& shape = shapes[0];
-    std::unordered_map<tinyobj::index_t, uint32_t, IndexHash, IndexEqual> index_map;
-    size_t index_offset = 0;
-    for (size_t face_id = 0; face_id < shape.mesh.num_face_vertices.size(); face_id++) {
-        assert(shape.mesh.num_face_vertices[face_id] == 3);
-        for (int i = 0; i < 3; i++) {
-            tinyobj::index_t idx = shape.mesh.indices[index_offset + i];
-            assert(idx.vertex_index >= 0);
-            assert(idx.texcoord_index >= 0);
-            if (index_map.count(idx) == 0) {
-                index_map[idx] = mesh.data.vertices.size();
-                mesh.data.vertices.emplace_back(Vertex {
-                    .pos = glm::vec3(
-                        attrib.vertices[3 * idx.vertex_index + 0],
-                        attrib.vertices[3 * idx.vertex_index + 1],
-                        attrib.vertices[3 * idx.vertex_index + 2]),
-                    .normal = glm::vec3(
-                        attrib.normals[3 * idx.normal_index + 0],
-                        attrib.normals[3 * idx.normal_index + 1],
-                        attrib.normals[3 * idx.normal_index + 2]),
-                    .uv = glm::vec2(
-                        attrib.texcoords[2 * idx.texcoord_index + 0],
-                        attrib.texcoords[2 * idx.texcoord_index + 1]) });
+    // every shape becomes a submesh, vertices aren't shared between them
+    for (const auto& shape : shapes) {
+        std::unordered_map<tinyobj::index_t, uint32_t, IndexHash, IndexEqual> index_map;
+        const auto first_vertex = static_cast<uint32_t>(mesh.data.vertices.size());
+        const auto first_index  = static_cast<uint32_t>(mesh.data.indices.size());
+        size_t index_offset     = 0;
+        for (size_t face_id = 0; face_id < shape.mesh.num_face_vertices.size(); face_id++) {
+            assert(shape.mesh.num_face_vertices[face_id] == 3);
+            for (int i = 0; i < 3; i++) {
+                tinyobj::index_t idx = shape.mesh.indices[index_offset + i];
+                assert(idx.vertex_index >= 0);
+                assert(idx.texcoord_index >= 0);
+                if (index_map.count(idx) == 0) {
+                    index_map[idx] = mesh.data.vertices.size();
+                    mesh.data.vertices.emplace_back(Vertex {
+                        .pos = glm::vec3(
+                            attrib.vertices[3 * idx.vertex_index + 0],
+                            attrib.vertices[3 * idx.vertex_index + 1],
+                            attrib.vertices[3 * idx.vertex_index + 2]),
+                        .normal = glm::vec3(
+                            attrib.normals[3 * idx.normal_index + 0],
+                            attrib.normals[3 * idx.normal_index + 1],
+                            attrib.normals[3 * idx.normal_index + 2]),
+                        .uv = glm::vec2(
+                            attrib.texcoords[2 * idx.texcoord_index + 0],
+                            attrib.texcoords[2 * idx.texcoord_index + 1]) });
+                }
+                mesh.data.indices.emplace_back(index_map[idx]);
             }
-            mesh.data.indices.emplace_back(index_map[idx]);
+            index_offset += 3;
         }
-        index_offset += 3;
+        mesh.submeshes.emplace_back(Submesh {
+            .firstIndex  = first_index,
+            .indexCount  = static_cast<uint32_t>(mesh.data.indices.size()) - first_index,
+            .firstVertex = first_vertex,
+            .vertexCount = static_cast<uint32_t>(mesh.data.vertices.size()) - first_vertex });
     }
     mesh.calculateTangents();
+    mesh.calculateAABB();
+    if (optimize)
+        mesh.optimize();
+    mesh.generateLods(key.lod_levels);
 
-    mesh.initBuffersFromData();
+    if (use_cache)
+        storeCache(inputfile, key, mesh);
 
     return mesh;
 }
@@ -287,8 +421,31 @@ void Mesh::calculateTangents()
     }
 }
 
-void Mesh::destroy()
+void Mesh::calculateAABB()
 {
-    Buffer::Delete(g_ctx.vk, vertexBuffer);
-    Buffer::Delete(g_ctx.vk, indexBuffer);
+    auto bounds = [this](uint32_t first_index, uint32_t index_count) {
+        AABB box { .bmin = glm::vec3(std::numeric_limits<float>::max()), .bmax = glm::vec3(std::numeric_limits<float>::lowest()) };
+        for (uint32_t i = first_index; i < first_index + index_count; i++) {
+            box.bmin = glm::min(box.bmin, data.vertices[data.indices[i]].pos);
+            box.bmax = glm::max(box.bmax, data.vertices[data.indices[i]].pos);
+        }
+        return box;
+    };
+
+    if (submeshes.empty()) {
+        submeshes.emplace_back(Submesh {
+            .firstIndex  = 0,
+            .indexCount  = static_cast<uint32_t>(data.indices.size()),
+            .firstVertex = 0,
+            .vertexCount = static_cast<uint32_t>(data.vertices.size()) });
+    }
+    for (auto& submesh : submeshes) {
+        submesh.aabb = bounds(submesh.firstIndex, submesh.indexCount);
+    }
+
+    aabb = AABB { .bmin = glm::vec3(std::numeric_limits<float>::max()), .bmax = glm::vec3(std::numeric_limits<float>::lowest()) };
+    for (const auto& vertex : data.vertices) {
+        aabb.bmin = glm::min(aabb.bmin, vertex.pos);
+        aabb.bmax = glm::max(aabb.bmax, vertex.pos);
+    }
 }
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "core/config/config.h"
+#include "aabb.h"
 #include "core/vulkan/type/buffer.h"
 #include "vertex.h"
+#include <filesystem>
 #include <vector>
 
 struct MeshData {
@@ -10,19 +12,84 @@ struct MeshData {
     std::vector<uint32_t> indices;
 };
 
+// One mesh of a multi-mesh file, a range of the triangles over its own contiguous range of vertices
+struct Submesh {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t firstVertex;
+    uint32_t vertexCount;
+    AABB aabb;
+};
+
+// A coarser version of a mesh: every submesh again with fewer triangles over the same vertices, its
+// indices follow the full resolution ones in MeshData
+struct MeshLod {
+    std::vector<Submesh> submeshes;
+    // largest distance the simplification moved the surface, relative to the mesh's AABB diagonal
+    float error;
+};
+
 struct Mesh {
     std::string name;
 
     MeshData data;
-    Vk::Buffer vertexBuffer;
-    Vk::Buffer indexBuffer;
+    std::vector<Submesh> submeshes;
+    // level i + 1, each with about half the triangles of the one before and a larger error
+    std::vector<MeshLod> lods;
+    // placement in the GeometryPool, set when the pool is built
+    uint32_t firstIndex  = 0;
+    int32_t vertexOffset = 0;
+    // set when the pool is built, the vertex shader computes positionOffset + positionScale * position
+    glm::vec4 positionOffset = glm::vec4(0.0f);
+    glm::vec4 positionScale  = glm::vec4(1.0f);
     bool isWaterTight;
+    AABB aabb;
 
-    static Mesh fromConfiguration(MeshConfiguration& config);
+    // safe to call from any thread, the GeometryPool uploads it
+    static Mesh loadFromConfiguration(MeshConfiguration& config);
+    // reorders data for the vertex cache and vertex fetch within each submesh, the triangles themselves don't change
+    void optimize();
     void calculateTangents();
-    void destroy();
+    // of the whole mesh and of each submesh, a mesh without submeshes gets one covering all of it
+    void calculateAABB();
+    // simplifies the submeshes into up to levels LODs, stops early when a level barely shrinks
+    void generateLods(uint32_t levels);
+    // the submeshes of level lod, 0 is the full mesh
+    const std::vector<Submesh>& lodSubmeshes(uint32_t lod) const { return lod == 0 ? submeshes : lods[lod - 1].submeshes; }
+    // the coarsest level whose error projects to at most pixel_error pixels on an object screen_size
+    // pixels across. current is kept while it's within hysteresis (a fraction of pixel_error) of that
+    uint32_t selectLod(float screen_size, float pixel_error, float hysteresis, uint32_t current) const;
 
 private:
+    // Identifies an imported mesh in the binary cache next to its source file
+    struct CacheKey {
+        enum class Loader : uint32_t {
+            Assimp  = 0,
+            TinyObj = 1,
+        };
+
+        uint64_t source_hash;
+        Loader loader;
+        uint32_t import_flags;
+        bool optimized;
+        uint32_t lod_levels;
+    };
+
+    // mesh_cache.cpp
+    static std::filesystem::path cachePath(const std::filesystem::path& source);
+    static bool loadCache(const std::filesystem::path& source, const CacheKey& key, Mesh& mesh);
+    static void storeCache(const std::filesystem::path& source, const CacheKey& key, const Mesh& mesh);
+
+    static bool shouldOptimize(MeshConfiguration& config);
+    // "lod_levels" of the mesh, 0 turns them off
+    static uint32_t lodLevels(MeshConfiguration& config);
+
+    static constexpr uint32_t DEFAULT_LOD_LEVELS = 4;
+    // smaller meshes cost less than the extra draws, no LODs
+    static constexpr size_t MIN_LOD_TRIANGLES = 512;
+    // a level keeps at most this much of the previous one's triangles
+    static constexpr float MAX_LOD_RATIO = 0.75f;
+
     static Mesh sphereMesh(MeshConfiguration& config);
     static Mesh cubeMesh(MeshConfiguration& config);
     static Mesh planeMesh(MeshConfiguration& config);
@@ -34,5 +101,4 @@ private:
         const glm::vec2& uv1, const glm::vec2& uv2, const glm::vec2& uv3);
     // an arbitrary tangent around normal
     static glm::vec3 computeFallbackTangent(const glm::vec3& normal);
-    void initBuffersFromData();
 };
@@ -0,0 +1,136 @@
+#include "mesh.h"
+#include "core/filesystem/file.h"
+#include "core/tool/logger.h"
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace {
+// <source>.meshcache layout: header, Vertex[vertex_count], uint32_t[index_count], Submesh[submesh_count],
+// then per LOD its error and Submesh[submesh_count]. The LODs' indices are part of index_count
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vertex_size;
+    uint64_t source_hash;
+    uint32_t loader;
+    uint32_t import_flags;
+    uint32_t optimized;
+    uint32_t lod_levels;
+    uint32_t lod_count;
+    uint32_t submesh_count;
+    uint64_t vertex_count;
+    uint64_t index_count;
+    AABB aabb;
+};
+
+constexpr char CACHE_MAGIC[8] = { 'R', 'E', 'M', 'E', 'S', 'H', '\0', '\0' };
+// bump when the layout or the import post-processing changes
+constexpr uint32_t CACHE_VERSION = 4;
+}
+
+std::filesystem::path Mesh::cachePath(const std::filesystem::path& source)
+{
+    return std::filesystem::path(source.string() + ".meshcache");
+}
+
+bool Mesh::loadCache(const std::filesystem::path& source, const CacheKey& key, Mesh& mesh)
+{
+    auto path = cachePath(source);
+    if (!std::filesystem::exists(path))
+        return false;
+
+    MappedFile file(path);
+    if (file.size() < sizeof(CacheHeader))
+        return false;
+    CacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(CacheHeader));
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+        || header.version != CACHE_VERSION
+        || header.vertex_size != sizeof(Vertex)
+        || header.source_hash != key.source_hash
+        || header.loader != static_cast<uint32_t>(key.loader)
+        || header.import_flags != key.import_flags
+        || header.optimized != static_cast<uint32_t>(key.optimized)
+        || header.lod_levels != key.lod_levels) {
+        INFO_ALL("Mesh cache {} is stale", path.string());
+        return false;
+    }
+    size_t vertex_bytes = header.vertex_count * sizeof(Vertex);
+    size_t index_bytes   = header.index_count * sizeof(uint32_t);
+    size_t submesh_bytes = header.submesh_count * sizeof(Submesh);
+    size_t lod_bytes     = header.lod_count * (sizeof(float) + submesh_bytes);
+    if (file.size() != sizeof(CacheHeader) + vertex_bytes + index_bytes + submesh_bytes + lod_bytes) {
+        WARN_ALL("Mesh cache {} is truncated", path.string());
+        return false;
+    }
+
+    // a single bulk copy out of the mapping, the upload happens later on the loading thread
+    const auto* vertices = reinterpret_cast<const Vertex*>(file.data() + sizeof(CacheHeader));
+    const auto* indices   = reinterpret_cast<const uint32_t*>(file.data() + sizeof(CacheHeader) + vertex_bytes);
+    const auto* submeshes = reinterpret_cast<const Submesh*>(file.data() + sizeof(CacheHeader) + vertex_bytes + index_bytes);
+    mesh.data.vertices.assign(vertices, vertices + header.vertex_count);
+    mesh.data.indices.assign(indices, indices + header.index_count);
+    mesh.submeshes.assign(submeshes, submeshes + header.submesh_count);
+    const char* lod = file.data() + sizeof(CacheHeader) + vertex_bytes + index_bytes + submesh_bytes;
+    for (uint32_t i = 0; i < header.lod_count; i++, lod += sizeof(float) + submesh_bytes) {
+        MeshLod& level = mesh.lods.emplace_back();
+        std::memcpy(&level.error, lod, sizeof(float));
+        const auto* lod_submeshes = reinterpret_cast<const Submesh*>(lod + sizeof(float));
+        level.submeshes.assign(lod_submeshes, lod_submeshes + header.submesh_count);
+    }
+    mesh.aabb = header.aabb;
+
+    INFO_ALL("Loaded {} from mesh cache", source.string());
+    return true;
+}
+
+void Mesh::storeCache(const std::filesystem::path& source, const CacheKey& key, const Mesh& mesh)
+{
+    CacheHeader header {};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version       = CACHE_VERSION;
+    header.vertex_size   = sizeof(Vertex);
+    header.source_hash   = key.source_hash;
+    header.loader        = static_cast<uint32_t>(key.loader);
+    header.import_flags  = key.import_flags;
+    header.optimized     = key.optimized;
+    header.lod_levels    = key.lod_levels;
+    header.lod_count     = mesh.lods.size();
+    header.vertex_count  = mesh.data.vertices.size();
+    header.index_count   = mesh.data.indices.size();
+    header.submesh_count = mesh.submeshes.size();
+    header.aabb          = mesh.aabb;
+
+    // write next to the cache and rename, so an interrupted run never leaves a half-written cache. Objects
+    // sharing a mesh load it on several threads at once, each writes its own tmp
+    auto path = cachePath(source);
+    auto tmp  = std::filesystem::path(path.string() + "." + std::to_string(std::hash<std::thread::id> {}(std::this_thread::get_id())) + ".tmp");
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            WARN_ALL("Can't write mesh cache {}", path.string());
+            return;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+        out.write(reinterpret_cast<const char*>(mesh.data.vertices.data()), mesh.data.vertices.size() * sizeof(Vertex));
+        out.write(reinterpret_cast<const char*>(mesh.data.indices.data()), mesh.data.indices.size() * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(mesh.submeshes.data()), mesh.submeshes.size() * sizeof(Submesh));
+        for (const auto& lod : mesh.lods) {
+            out.write(reinterpret_cast<const char*>(&lod.error), sizeof(float));
+            out.write(reinterpret_cast<const char*>(lod.submeshes.data()), lod.submeshes.size() * sizeof(Submesh));
+        }
+        if (!out) {
+            WARN_ALL("Can't write mesh cache {}", path.string());
+            out.close();
+            std::filesystem::remove(tmp);
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec)
+        WARN_ALL("Can't write mesh cache {}: {}", path.string(), ec.message());
+}
@@ -4,33 +4,38 @@
 #include "core/vulkan/descriptor_manager.h"
 #include "core/vulkan/type/buffer.h"
 #include "function/resource_manager/resource.h"
+#include "function/type/aabb.h"
 #include "function/type/transform.h"
-
-#ifdef _WIN64
-#include <Windows.h>
-#endif
+#include "function/type/vertex.h"
 
 struct Object : public Resource {
     struct Param {
         glm::mat4 model;
         glm::mat4 modelInvTrans;
+        // dequantizes the mesh positions, see Mesh::positionOffset
+        glm::vec4 positionOffset;
+        glm::vec4 positionScale;
         Vk::DescriptorHandle material;
         Vk::DescriptorHandle vertBuf;
+        VertexFormat vertexFormat;
+        // the mesh's first vertex in the GeometryPool, gl_VertexIndex - vertexOffset indexes vertBuf
+        int32_t vertexOffset;
     };
 
     std::string name;
     std::string mesh;
+    std::string material;
     Transform transform;
 
+    // copied to ResourceManager::object_buffer when it changes, see ObjectBuffer::markDirty
     Param param;
-    Vk::Buffer paramBuffer;
+    // world space bounds of the mesh
+    AABB bounds;
+    // level of detail the camera passes draw, 0 is the full mesh. Set by ResourceManager::selectLods
+    uint32_t lod = 0;
 
-#ifdef _WIN64
-    HANDLE getVkVertexMemHandle();
-#else
-    int getVkVertexMemHandle();
-#endif
-    void updatePosition(float delta_time);
+    // true when the object moved and its bounds changed
+    bool updatePosition(float delta_time);
     virtual std::string type() const override { return "Object"; }
     virtual void destroy() override;
     static Object fromConfiguration(ObjectConfiguration& config);
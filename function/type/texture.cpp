@@ -1,10 +1,13 @@
 #include "texture.h"
+#include "core/filesystem/file.h"
 #include "core/tool/logger.h"
 #include "function/global_context.h"
-#include <boost/gil.hpp>
-#include <boost/gil/extension/io/jpeg.hpp>
-#include <boost/gil/extension/io/png.hpp>
-#include <boost/gil/extension/io/tiff.hpp>
+#include "function/tool/image_decoder.h"
+#include "function/tool/pixel_convert.h"
+#include "function/tool/texture_encoder.h"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
 #include <filesystem>
 
 using namespace Vk;
@@ -16,113 +19,226 @@ void Texture::destroy()
 
 Texture Texture::fromConfiguration(const TextureConfiguration& config)
 {
-    Texture texture;
-    texture.name = config.name;
+    return fromDecoded(config.name, loadFromConfiguration(config));
+}
 
-    const auto extension = std::filesystem::path(config.path).extension().string();
-    texture.image        = loadExternalImage(config.path);
-    g_ctx.dm.registerResource(texture.image, DescriptorType::CombinedImageSampler);
+DecodedImage Texture::loadFromConfiguration(const TextureConfiguration& config)
+{
+    // the device decides whether block compression happens at all
+    CacheKey key { config.cache ? hashFile(config.path) : 0, config.mipmaps, config.compress && g_ctx.vk.textureCompressionBC };
 
-    return texture;
+    DecodedImage decoded;
+    if (config.cache && loadCache(config.path, key, decoded))
+        return decoded;
+
+    decoded = decodeExternalImage(config.path);
+    if (key.mipmaps)
+        generateMipChain(decoded);
+    if (key.compress)
+        compressBlocks(decoded);
+
+    if (config.cache)
+        storeCache(config.path, key, decoded);
+    return decoded;
 }
 
-Vk::Image Texture::loadExternalImage(const std::string& path)
+Texture Texture::fromDecoded(const std::string& name, const DecodedImage& decoded)
 {
-    using namespace boost::gil;
+    Texture texture;
+    texture.name  = name;
+    texture.image = createImage(decoded);
+    g_ctx.dm.registerResource(texture.image, DescriptorType::CombinedImageSampler);
 
-    auto width  = 0;
-    auto height = 0;
-    VkFormat format {};
-    VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
+    return texture;
+}
 
-    any_image<
-        gray8_image_t, gray16_image_t, gray32_image_t,
-        rgb8_image_t, rgb16_image_t, rgb32_image_t,
-        rgba8_image_t, rgba16_image_t, rgba32_image_t>
-        boost_image;
-    try {
-        const auto extension = std::filesystem::path(path).extension().string();
-        if (extension == ".tif" || extension == ".tiff") {
-            read_image(path, boost_image, tiff_tag {});
-        } else if (extension == ".png") {
-            read_image(path, boost_image, png_tag {});
-        } else if (extension == ".jpg" || extension == ".jpeg") {
-            read_image(path, boost_image, jpeg_tag {});
-        } else {
-            throw std::runtime_error("Image type not supported");
-        }
-    } catch (const std::exception& e) {
-        ERROR_ALL("Failed to load image: " + std::string(e.what()));
+DecodedImage Texture::mipTail(const DecodedImage& decoded, uint32_t base_level)
+{
+    assert(base_level < decoded.mip_levels);
+    DecodedImage tail;
+    tail.width         = std::max(1u, decoded.width >> base_level);
+    tail.height        = std::max(1u, decoded.height >> base_level);
+    tail.format        = decoded.format;
+    tail.mip_levels    = decoded.mip_levels - base_level;
+    const size_t begin = decoded.level_offsets[base_level];
+    for (uint32_t level = base_level; level <= decoded.mip_levels; level++) {
+        tail.level_offsets.emplace_back(decoded.level_offsets[level] - begin);
     }
-    auto boost_image_view = view(boost_image);
-    uint8_t* ptr          = nullptr;
-    std::vector<uint8_t> extra_converted_buffer;
-    boost::variant2::visit([&](auto&& view) {
-        using ViewType = std::decay_t<decltype(view)>;
-        width          = view.width();
-        height         = view.height();
-        ptr            = reinterpret_cast<uint8_t*>(interleaved_view_get_raw_data(view));
+    tail.pixels.assign(decoded.pixels.begin() + begin, decoded.pixels.begin() + decoded.level_offsets.back());
+    return tail;
+}
 
-        if constexpr (std::is_same_v<ViewType, gray8_view_t>) {
-            format = VK_FORMAT_R8_UNORM;
-        } else if constexpr (std::is_same_v<ViewType, gray16_view_t>) {
-            format = VK_FORMAT_R16_SFLOAT;
-        } else if constexpr (std::is_same_v<ViewType, gray32_view_t>) {
-            format = VK_FORMAT_R32_SFLOAT;
-        } else if constexpr (std::is_same_v<ViewType, rgb8_view_t>) {
-            format = VK_FORMAT_R8G8B8A8_UNORM; // vulkan doesn't support 3 bytes formats
-            extra_converted_buffer.resize(width * height * 4);
-            auto rgba_view = interleaved_view(width, height,
-                                              reinterpret_cast<rgba8_pixel_t*>(extra_converted_buffer.data()),
-                                              width * sizeof(rgba8_pixel_t));
-            copy_and_convert_pixels(view, rgba_view);
-            ptr = reinterpret_cast<uint8_t*>(interleaved_view_get_raw_data(rgba_view));
-        } else if constexpr (std::is_same_v<ViewType, rgb16_view_t>) {
-            format = VK_FORMAT_R16G16B16_SFLOAT;
-            tiling = VK_IMAGE_TILING_LINEAR;
-        } else if constexpr (std::is_same_v<ViewType, rgb32_view_t>) {
-            format = VK_FORMAT_R32G32B32_SFLOAT;
-            tiling = VK_IMAGE_TILING_LINEAR;
-        } else if constexpr (std::is_same_v<ViewType, rgba8_view_t>) {
-            format = VK_FORMAT_R8G8B8A8_UNORM;
-        } else if constexpr (std::is_same_v<ViewType, rgba16_view_t>) {
-            format = VK_FORMAT_R16G16B16A16_SFLOAT;
-            tiling = VK_IMAGE_TILING_LINEAR;
-        } else if constexpr (std::is_same_v<ViewType, rgba32_view_t>) {
-            format = VK_FORMAT_R32G32B32A32_SFLOAT;
-            tiling = VK_IMAGE_TILING_LINEAR;
-        } else {
-            assert(false);
-        }
-    },
-                           boost_image_view);
+void Texture::replaceImage(const DecodedImage& decoded)
+{
+    auto fresh = createImage(decoded);
+    // the materials hold the handle, which is looked up by id
+    fresh.id = image.id;
+    g_ctx.dm.updateResourceRegistration(fresh);
+    Image::Delete(g_ctx.vk, image);
+    image = fresh;
+}
 
+Image Texture::createImage(const DecodedImage& decoded)
+{
     const auto extent = VkExtent3D {
-        static_cast<uint32_t>(width),
-        static_cast<uint32_t>(height),
+        decoded.width,
+        decoded.height,
         1
     };
-    Image image;
-    image = Image::New(
+    auto image = Image::New(
         g_ctx.vk,
-        format,
+        decoded.format,
         extent,
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
         VK_IMAGE_ASPECT_COLOR_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        1,
+        decoded.mip_levels,
         1,
         false,
-        tiling);
-    image.Update(g_ctx.vk, ptr);
+        VK_IMAGE_TILING_OPTIMAL);
+    image.UpdateMipChain(g_ctx.vk, decoded.pixels.data(), decoded.level_offsets);
     image.AddSampler(g_ctx.vk,
                      VK_FILTER_LINEAR,
                      std::vector<VkSamplerAddressMode>(3, VK_SAMPLER_ADDRESS_MODE_REPEAT));
     image.TransitionLayoutSingleTime(g_ctx.vk, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
     return image;
 }
 
+DecodedImage Texture::decodeExternalImage(const std::string& path)
+{
+    auto extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    DecodedImage decoded;
+    try {
+        if (extension == ".tif" || extension == ".tiff") {
+            decoded = ImageDecoder::decodeTiff(path);
+        } else if (extension == ".png") {
+            decoded = ImageDecoder::decodePng(path);
+        } else if (extension == ".jpg" || extension == ".jpeg") {
+            decoded = ImageDecoder::decodeJpeg(path);
+        } else {
+            throw std::runtime_error("Image type not supported");
+        }
+    } catch (const std::exception& e) {
+        // the upload would read past an empty pixel buffer, so don't carry on
+        throw std::runtime_error("Failed to load image " + path + ": " + e.what());
+    }
+    decoded.level_offsets = { 0, decoded.pixels.size() };
+
+    return decoded;
+}
+
+void Texture::generateMipChain(DecodedImage& decoded)
+{
+    uint32_t channels;
+    bool is_half;
+    switch (decoded.format) {
+    case VK_FORMAT_R8_UNORM:
+        channels = 1;
+        is_half  = false;
+        break;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+        channels = 4;
+        is_half  = false;
+        break;
+    case VK_FORMAT_R16_SFLOAT:
+        channels = 1;
+        is_half  = true;
+        break;
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+        channels = 4;
+        is_half  = true;
+        break;
+    default:
+        return;
+    }
+    const size_t texel_size = channels * (is_half ? sizeof(uint16_t) : sizeof(uint8_t));
+
+    decoded.mip_levels = TextureEncoder::mipLevelCount(decoded.width, decoded.height);
+    decoded.level_offsets.assign(decoded.mip_levels + 1, 0);
+    for (uint32_t level = 0; level < decoded.mip_levels; level++) {
+        size_t width                     = std::max(1u, decoded.width >> level);
+        size_t height                    = std::max(1u, decoded.height >> level);
+        decoded.level_offsets[level + 1] = decoded.level_offsets[level] + width * height * texel_size;
+    }
+    decoded.pixels.resize(decoded.level_offsets.back());
+
+    // halves are filtered in float, each level is kept in float for the next one so rounding doesn't accumulate
+    std::vector<float> src_floats, dst_floats;
+    if (is_half) {
+        const size_t count = static_cast<size_t>(decoded.width) * decoded.height * channels;
+        const auto* halves = reinterpret_cast<const uint16_t*>(decoded.pixels.data());
+        src_floats.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            src_floats[i] = PixelConvert::halfToFloat(halves[i]);
+        }
+    }
+    for (uint32_t level = 1; level < decoded.mip_levels; level++) {
+        uint32_t width  = std::max(1u, decoded.width >> (level - 1));
+        uint32_t height = std::max(1u, decoded.height >> (level - 1));
+        uint8_t* src    = decoded.pixels.data() + decoded.level_offsets[level - 1];
+        uint8_t* dst    = decoded.pixels.data() + decoded.level_offsets[level];
+        if (is_half) {
+            const size_t count = static_cast<size_t>(std::max(1u, width / 2)) * std::max(1u, height / 2) * channels;
+            dst_floats.resize(count);
+            TextureEncoder::downsample(src_floats.data(), width, height, channels, dst_floats.data());
+            PixelConvert::floatToHalf(dst_floats.data(), reinterpret_cast<uint16_t*>(dst), count);
+            std::swap(src_floats, dst_floats);
+        } else {
+            TextureEncoder::downsample(src, width, height, channels, dst);
+        }
+    }
+}
+
+void Texture::compressBlocks(DecodedImage& decoded)
+{
+    VkFormat format;
+    uint32_t block_size;
+    if (decoded.format == VK_FORMAT_R8_UNORM) {
+        format     = VK_FORMAT_BC4_UNORM_BLOCK;
+        block_size = 8;
+    } else if (decoded.format == VK_FORMAT_R8G8B8A8_UNORM) {
+        bool opaque = true;
+        for (size_t i = 3; i < decoded.level_offsets[1]; i += 4) {
+            if (decoded.pixels[i] != 255) {
+                opaque = false;
+                break;
+            }
+        }
+        format     = opaque ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        block_size = opaque ? 8 : 16;
+    } else {
+        // half images keep their precision
+        return;
+    }
+
+    std::vector<size_t> level_offsets(decoded.mip_levels + 1, 0);
+    for (uint32_t level = 0; level < decoded.mip_levels; level++) {
+        uint32_t width           = std::max(1u, decoded.width >> level);
+        uint32_t height          = std::max(1u, decoded.height >> level);
+        level_offsets[level + 1] = level_offsets[level] + TextureEncoder::compressedSize(width, height, block_size);
+    }
+    std::vector<uint8_t> blocks(level_offsets.back());
+    for (uint32_t level = 0; level < decoded.mip_levels; level++) {
+        uint32_t width     = std::max(1u, decoded.width >> level);
+        uint32_t height    = std::max(1u, decoded.height >> level);
+        const uint8_t* src = decoded.pixels.data() + decoded.level_offsets[level];
+        uint8_t* dst       = blocks.data() + level_offsets[level];
+        if (format == VK_FORMAT_BC4_UNORM_BLOCK) {
+            TextureEncoder::encodeBC4(src, width, height, dst);
+        } else if (format == VK_FORMAT_BC1_RGB_UNORM_BLOCK) {
+            TextureEncoder::encodeBC1(src, width, height, dst);
+        } else {
+            TextureEncoder::encodeBC3(src, width, height, dst);
+        }
+    }
+
+    decoded.format        = format;
+    decoded.level_offsets = std::move(level_offsets);
+    decoded.pixels        = std::move(blocks);
+}
+
 Texture Texture::loadDefaultColorTexture()
 {
     Texture texture;
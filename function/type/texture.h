@@ -2,7 +2,20 @@
 
 #include "core/config/config.h"
 #include "core/vulkan/type/image.h"
+#include <filesystem>
 #include <string>
+#include <vector>
+
+// Pixels of an image file, decoded on the CPU and ready to be uploaded
+struct DecodedImage {
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    VkFormat format {};
+    uint32_t mip_levels = 1;
+    // mip levels back to back, level i starts at level_offsets[i], level_offsets.back() is the size
+    std::vector<size_t> level_offsets;
+    std::vector<uint8_t> pixels;
+};
 
 struct Texture {
     std::string name;
@@ -11,6 +24,17 @@ struct Texture {
 
     void destroy();
     static Texture fromConfiguration(const TextureConfiguration& config);
+    // CPU part of fromConfiguration, safe to call from any thread: decode or read the cache,
+    // build the mip chain and block compress it. Upload with fromDecoded()
+    static DecodedImage loadFromConfiguration(const TextureConfiguration& config);
+    // level 0 only
+    static DecodedImage decodeExternalImage(const std::string& path);
+    // uploads and registers the image, main thread only
+    static Texture fromDecoded(const std::string& name, const DecodedImage& decoded);
+    // levels [base_level, mip_levels) of decoded as a chain of their own
+    static DecodedImage mipTail(const DecodedImage& decoded, uint32_t base_level);
+    // swaps in a new image behind the same descriptor handle. Main thread, the GPU must not be using the old image
+    void replaceImage(const DecodedImage& decoded);
 
     static Texture loadDefaultColorTexture();
     static Texture loadDefaultMetallicTexture();
@@ -19,5 +43,20 @@ struct Texture {
     static Texture loadDefaultAoTexture();
 
 private:
-    static Vk::Image loadExternalImage(const std::string& path);
+    // uploads decoded into a sampled image in SHADER_READ_ONLY_OPTIMAL
+    static Vk::Image createImage(const DecodedImage& decoded);
+    static void generateMipChain(DecodedImage& decoded);
+    static void compressBlocks(DecodedImage& decoded);
+
+    // Identifies a processed image in the binary cache next to its source file
+    struct CacheKey {
+        uint64_t source_hash;
+        bool mipmaps;
+        bool compress;
+    };
+
+    // texture_cache.cpp
+    static std::filesystem::path cachePath(const std::filesystem::path& source);
+    static bool loadCache(const std::filesystem::path& source, const CacheKey& key, DecodedImage& decoded);
+    static void storeCache(const std::filesystem::path& source, const CacheKey& key, const DecodedImage& decoded);
 };
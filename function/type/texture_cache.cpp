@@ -0,0 +1,116 @@
+#include "texture.h"
+#include "core/filesystem/file.h"
+#include "core/tool/logger.h"
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace {
+// <source>.texcache layout, modelled on KTX2: header, uint64_t[mip_levels + 1] level offsets, level data.
+// Levels are stored largest first and ready to copy into the image
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t format;
+    uint64_t source_hash;
+    uint32_t mipmaps;
+    uint32_t compress;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_levels;
+};
+
+constexpr char CACHE_MAGIC[8] = { 'R', 'E', 'T', 'E', 'X', '\0', '\0', '\0' };
+// bump when the layout, the mip filter or the encoders change
+constexpr uint32_t CACHE_VERSION = 2;
+}
+
+std::filesystem::path Texture::cachePath(const std::filesystem::path& source)
+{
+    return std::filesystem::path(source.string() + ".texcache");
+}
+
+bool Texture::loadCache(const std::filesystem::path& source, const CacheKey& key, DecodedImage& decoded)
+{
+    auto path = cachePath(source);
+    if (!std::filesystem::exists(path))
+        return false;
+
+    MappedFile file(path);
+    if (file.size() < sizeof(CacheHeader))
+        return false;
+    CacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(CacheHeader));
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+        || header.version != CACHE_VERSION
+        || header.source_hash != key.source_hash
+        || header.mipmaps != static_cast<uint32_t>(key.mipmaps)
+        || header.compress != static_cast<uint32_t>(key.compress)) {
+        INFO_ALL("Texture cache {} is stale", path.string());
+        return false;
+    }
+    size_t offsets_bytes = (static_cast<size_t>(header.mip_levels) + 1) * sizeof(uint64_t);
+    if (header.mip_levels == 0 || file.size() < sizeof(CacheHeader) + offsets_bytes) {
+        WARN_ALL("Texture cache {} is truncated", path.string());
+        return false;
+    }
+    std::vector<uint64_t> offsets(header.mip_levels + 1);
+    std::memcpy(offsets.data(), file.data() + sizeof(CacheHeader), offsets_bytes);
+    const size_t data_offset = sizeof(CacheHeader) + offsets_bytes;
+    if (offsets.front() != 0 || file.size() != data_offset + offsets.back()) {
+        WARN_ALL("Texture cache {} is truncated", path.string());
+        return false;
+    }
+
+    decoded.width      = header.width;
+    decoded.height     = header.height;
+    decoded.format     = static_cast<VkFormat>(header.format);
+    decoded.mip_levels = header.mip_levels;
+    decoded.level_offsets.assign(offsets.begin(), offsets.end());
+    decoded.pixels.assign(file.data() + data_offset, file.data() + file.size());
+
+    INFO_ALL("Loaded {} from texture cache", source.string());
+    return true;
+}
+
+void Texture::storeCache(const std::filesystem::path& source, const CacheKey& key, const DecodedImage& decoded)
+{
+    CacheHeader header {};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version     = CACHE_VERSION;
+    header.format      = static_cast<uint32_t>(decoded.format);
+    header.source_hash = key.source_hash;
+    header.mipmaps     = key.mipmaps;
+    header.compress    = key.compress;
+    header.width       = decoded.width;
+    header.height      = decoded.height;
+    header.mip_levels  = decoded.mip_levels;
+    std::vector<uint64_t> offsets(decoded.level_offsets.begin(), decoded.level_offsets.end());
+
+    // write next to the cache and rename, so an interrupted run never leaves a half-written cache. Textures
+    // sharing a source load it on several threads at once, each writes its own tmp
+    auto path = cachePath(source);
+    auto tmp  = std::filesystem::path(path.string() + "." + std::to_string(std::hash<std::thread::id> {}(std::this_thread::get_id())) + ".tmp");
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            WARN_ALL("Can't write texture cache {}", path.string());
+            return;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+        out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(decoded.pixels.data()), decoded.pixels.size());
+        if (!out) {
+            WARN_ALL("Can't write texture cache {}", path.string());
+            out.close();
+            std::filesystem::remove(tmp);
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec)
+        WARN_ALL("Can't write texture cache {}: {}", path.string(), ec.message());
+}
@@ -4,44 +4,96 @@
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 
+// Layout of the vertex buffers, one for the whole scene since the pipelines bake it in.
+// Matches VertexFormat* in common.glsl
+enum class VertexFormat : uint32_t {
+    Float     = 0, // Vertex, 44 bytes
+    Packed    = 1, // PackedVertex, 24 bytes
+    Quantized = 2, // QuantizedVertex, 20 bytes
+};
+
+// Octahedral snorm16 normal and tangent, half float uv
+struct PackedVertex {
+    glm::vec3 pos;
+    int16_t normal[2];
+    uint16_t uv[2];
+    int16_t tangent[2];
+};
+
+// PackedVertex with the position as unorm16 in the mesh AABB, w is padding
+struct QuantizedVertex {
+    uint16_t pos[4];
+    int16_t normal[2];
+    uint16_t uv[2];
+    int16_t tangent[2];
+};
+
 struct Vertex {
     glm::vec3 pos;
     glm::vec3 normal;
     glm::vec2 uv;
     glm::vec3 tangent;
 
-    static VkVertexInputBindingDescription getBindingDescription()
+    static VkVertexInputBindingDescription getBindingDescription(VertexFormat format = VertexFormat::Float)
     {
         VkVertexInputBindingDescription bindingDescription {};
         bindingDescription.binding   = 0;
-        bindingDescription.stride    = sizeof(Vertex);
         bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        switch (format) {
+        case VertexFormat::Float:
+            bindingDescription.stride = sizeof(Vertex);
+            break;
+        case VertexFormat::Packed:
+            bindingDescription.stride = sizeof(PackedVertex);
+            break;
+        case VertexFormat::Quantized:
+            bindingDescription.stride = sizeof(QuantizedVertex);
+            break;
+        }
 
         return bindingDescription;
     }
 
-    static std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions()
+    static std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions(VertexFormat format = VertexFormat::Float)
     {
         std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions {};
-        attributeDescriptions[0].binding  = 0;
-        attributeDescriptions[0].location = 0;
-        attributeDescriptions[0].format   = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[0].offset   = offsetof(Vertex, pos);
-
-        attributeDescriptions[1].binding  = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format   = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset   = offsetof(Vertex, normal);
-
-        attributeDescriptions[2].binding  = 0;
-        attributeDescriptions[2].location = 2;
-        attributeDescriptions[2].format   = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[2].offset   = offsetof(Vertex, uv);
-
-        attributeDescriptions[3].binding  = 0;
-        attributeDescriptions[3].location = 3;
-        attributeDescriptions[3].format   = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[3].offset   = offsetof(Vertex, tangent);
+        for (uint32_t i = 0; i < attributeDescriptions.size(); i++) {
+            attributeDescriptions[i].binding  = 0;
+            attributeDescriptions[i].location = i;
+        }
+
+        switch (format) {
+        case VertexFormat::Float:
+            attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+            attributeDescriptions[0].offset = offsetof(Vertex, pos);
+            attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+            attributeDescriptions[1].offset = offsetof(Vertex, normal);
+            attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+            attributeDescriptions[2].offset = offsetof(Vertex, uv);
+            attributeDescriptions[3].format = VK_FORMAT_R32G32B32_SFLOAT;
+            attributeDescriptions[3].offset = offsetof(Vertex, tangent);
+            break;
+        case VertexFormat::Packed:
+            attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+            attributeDescriptions[0].offset = offsetof(PackedVertex, pos);
+            attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+            attributeDescriptions[1].offset = offsetof(PackedVertex, normal);
+            attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+            attributeDescriptions[2].offset = offsetof(PackedVertex, uv);
+            attributeDescriptions[3].format = VK_FORMAT_R16G16_SNORM;
+            attributeDescriptions[3].offset = offsetof(PackedVertex, tangent);
+            break;
+        case VertexFormat::Quantized:
+            attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+            attributeDescriptions[0].offset = offsetof(QuantizedVertex, pos);
+            attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+            attributeDescriptions[1].offset = offsetof(QuantizedVertex, normal);
+            attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+            attributeDescriptions[2].offset = offsetof(QuantizedVertex, uv);
+            attributeDescriptions[3].format = VK_FORMAT_R16G16_SNORM;
+            attributeDescriptions[3].offset = offsetof(QuantizedVertex, tangent);
+            break;
+        }
 
         return attributeDescriptions;
     }
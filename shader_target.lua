@@ -10,4 +10,5 @@ function shader_target(name)
     add_files("**/node/" .. name .. "/*.vert")
     add_files("**/node/" .. name .. "/*.frag")
     add_files("**/node/" .. name .. "/*.geom")
+    add_files("**/node/" .. name .. "/*.comp")
 end
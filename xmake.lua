@@ -67,11 +67,17 @@ target("engine")
 includes("shader_target.lua")
 
 shader_target("default_object")
+shader_target("depth_prepass")
+shader_target("gbuffer")
+shader_target("deferred_lighting")
 shader_target("fire_object")
 shader_target("smoke_field")
 shader_target("vorticity_field")
 shader_target("fire_field")
 shader_target("hdr_to_sdr")
+shader_target("occlusion_culling")
+shader_target("light_culling")
+shader_target("macrocell_grid")
 shader_target("calculate_luminance")
 shader_target("fxaa")
 shader_target("voxelization")